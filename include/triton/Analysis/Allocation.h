@@ -12,6 +12,7 @@
 #include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 #include <atomic>
 #include <limits>
+#include <optional>
 
 namespace mlir {
 
@@ -24,13 +25,17 @@ class AllocationAnalysis;
 // vectorized loads/stores. The scratch buffer has a shape (`repShape`) that
 // represents the maximum size accessed in each dimension during each iteration.
 // It is padded (`paddedRepShape`) to avoid bank conflicts and is accessed in a
-// specific `order`.
+// specific `order`.  Alternatively, it is left unpadded and swizzled like a
+// SharedEncodingAttr with `swizzleVec`, `perPhase` and `maxPhase`.
 struct ScratchConfig {
   SmallVector<unsigned> repShape;
   SmallVector<unsigned> paddedRepShape;
   SmallVector<unsigned> order;
   unsigned inVec;
   unsigned outVec;
+  unsigned swizzleVec = 1;
+  unsigned perPhase = 1;
+  unsigned maxPhase = 1;
 
   ScratchConfig(SmallVector<unsigned> repShape,
                 SmallVector<unsigned> paddedRepShape, unsigned inVec = 1,
@@ -48,13 +53,40 @@ struct ScratchConfig {
     os << ", order: [";
     llvm::interleaveComma(order, os);
     os << "]";
-    os << ", inVec: " << inVec << ", outVec: " << outVec << "\n";
+    os << ", inVec: " << inVec << ", outVec: " << outVec;
+    if (maxPhase > 1)
+      os << ", swizzle: [" << swizzleVec << ", " << perPhase << ", "
+         << maxPhase << "]";
+    os << "\n";
   }
 };
 
+// With TRITON_SMEM_SWIZZLE_CVT=1, conversions between blocked layouts that the
+// linear layout lowering handles get an unpadded scratch buffer when some
+// swizzle of it, possibly none, makes both the stores and the loads free of
+// bank conflicts.
 ScratchConfig getScratchConfigForCvt(RankedTensorType srcTy,
                                      RankedTensorType dstTy);
 
+/// Strategies used to assign shared memory offsets to buffers.
+enum class AllocationStrategy {
+  /// Computes initial offsets from (size, start, end) triples, then resolves
+  /// the remaining overlaps by coloring the interference graph.
+  GraphColoring,
+  /// Places buffers from the largest to the smallest in the tightest gap left
+  /// by the already placed buffers whose liveness overlaps. Overlapping
+  /// buffers are looked up in a liveness interval tree.
+  BestFit,
+};
+
+/// Returns the strategy named `name` ("graph-coloring" or "best-fit"), or
+/// std::nullopt if the name is unknown.
+std::optional<AllocationStrategy> parseAllocationStrategy(StringRef name);
+
+/// Returns the strategy selected by TRITON_SMEM_ALLOCATOR, graph coloring by
+/// default.
+AllocationStrategy getDefaultAllocationStrategy();
+
 } // namespace triton
 
 /// Modified from llvm-15.0: llvm/ADT/AddressRanges.h
@@ -99,7 +131,10 @@ public:
   Allocation() = default;
   /// Creates a new Allocation analysis that computes the shared memory
   /// information for all associated shared memory values.
-  explicit Allocation(Operation *operation) : operation(operation) {}
+  explicit Allocation(Operation *operation,
+                      triton::AllocationStrategy strategy =
+                          triton::AllocationStrategy::GraphColoring)
+      : operation(operation), strategy(strategy) {}
 
   /// Runs allocation analysis on the given top-level operation.
   void run(FuncAllocMapT &funcAllocMap);
@@ -167,6 +202,21 @@ public:
   /// Returns the size of total shared memory allocated
   size_t getSharedMemorySize() const { return sharedMemorySize; }
 
+  /// Returns the largest total size of the buffers live at the same time.
+  /// This is a lower bound of the shared memory size for any strategy.
+  size_t getPeakLiveSize() const { return peakLiveSize; }
+
+  /// Returns the fraction of the allocated shared memory that is not used at
+  /// the point of peak liveness, i.e., lost to alignment and fragmentation.
+  double getFragmentation() const {
+    if (sharedMemorySize == 0)
+      return 0.0;
+    return 1.0 - static_cast<double>(peakLiveSize) / sharedMemorySize;
+  }
+
+  /// Returns the strategy used to assign the buffer offsets.
+  triton::AllocationStrategy getStrategy() const { return strategy; }
+
   /// Returns mapping from operation to list of live LDS buffers
   std::map<Operation *, SmallVector<BufferId>> getLiveBuffers();
 
@@ -236,6 +286,9 @@ private:
   AliasBufferMapT aliasBuffer;
   BufferSetT bufferSet;
   size_t sharedMemorySize = 0;
+  size_t peakLiveSize = 0;
+  triton::AllocationStrategy strategy =
+      triton::AllocationStrategy::GraphColoring;
 
   friend class triton::AllocationAnalysis;
 };
@@ -250,14 +303,17 @@ class ModuleAllocation : public CallGraph<Allocation> {
 public:
   using FuncOffsetMapT = DenseMap<FunctionOpInterface, Value>;
 
-  explicit ModuleAllocation(ModuleOp moduleOp)
+  explicit ModuleAllocation(ModuleOp moduleOp,
+                            triton::AllocationStrategy strategy =
+                                triton::getDefaultAllocationStrategy())
       : CallGraph<Allocation>(moduleOp) {
     walk<WalkOrder::PreOrder, WalkOrder::PostOrder>(
         // Pre-order edge walk callback
         [](CallOpInterface callOp, FunctionOpInterface funcOp) {},
         // Post-order node walk callback
         [&](FunctionOpInterface funcOp) {
-          auto [iter, inserted] = funcMap.try_emplace(funcOp, funcOp);
+          auto [iter, inserted] =
+              funcMap.try_emplace(funcOp, funcOp, strategy);
           if (inserted)
             iter->second.run(funcMap);
         });
@@ -276,6 +332,28 @@ public:
     return getFuncData(funcOp)->getSharedMemorySize();
   }
 
+  size_t getPeakLiveSize() {
+    size_t size = 0;
+    for (auto funcOp : getRoots()) {
+      auto *alloc = getFuncData(funcOp);
+      size = std::max(size, alloc->getPeakLiveSize());
+    }
+    return size;
+  }
+
+  /// Returns the fragmentation of the root function using the most shared
+  /// memory.
+  double getFragmentation() {
+    Allocation *maxAlloc = nullptr;
+    for (auto funcOp : getRoots()) {
+      auto *alloc = getFuncData(funcOp);
+      if (!maxAlloc ||
+          alloc->getSharedMemorySize() > maxAlloc->getSharedMemorySize())
+        maxAlloc = alloc;
+    }
+    return maxAlloc ? maxAlloc->getFragmentation() : 0.0;
+  }
+
   void setFunctionSharedMemoryValue(FunctionOpInterface funcOp, Value value) {
     sharedMemoryValue[funcOp] = value;
   }
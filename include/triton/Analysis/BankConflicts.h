@@ -0,0 +1,86 @@
+#ifndef TRITON_ANALYSIS_BANKCONFLICTS_H
+#define TRITON_ANALYSIS_BANKCONFLICTS_H
+
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "triton/Tools/LinearLayout.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <optional>
+
+namespace mlir::triton {
+
+/// Shared memory is made of 32 banks of 4 bytes; consecutive words are in
+/// consecutive banks.  A warp is served 128 bytes at a time, and accesses to
+/// different words of the same bank are serialized.
+constexpr int kNumSharedBanks = 32;
+constexpr int kSharedBankBytes = 4;
+
+/// The cost of the shared memory accesses of one warp.
+struct BankConflicts {
+  /// Number of passes over the banks (wavefronts) the accesses take.
+  int64_t wavefronts = 0;
+  /// Number of wavefronts the same accesses would take without conflicts.
+  int64_t minWavefronts = 0;
+  /// Largest ratio of wavefronts to conflict-free wavefronts over the
+  /// instructions of the warp, i.e. the worst n-way conflict.
+  int64_t ways = 1;
+
+  bool isConflictFree() const { return wavefronts == minWavefronts; }
+
+  void print(raw_ostream &os) const {
+    if (isConflictFree())
+      os << "no bank conflicts";
+    else
+      os << ways << "-way bank conflicts";
+    os << ", " << wavefronts << " wavefronts (" << minWavefronts
+       << " without conflicts)";
+  }
+};
+
+/// Counts the bank conflicts of a warp where every thread accesses
+/// `accessBytes` contiguous bytes per instruction.  `byteOffsets[i][lane]` is
+/// the shared memory offset accessed by `lane` in the i-th instruction.
+/// Accesses wider than 16 bytes are split in 16-byte accesses, as LLVM
+/// legalizes them.
+BankConflicts getBankConflicts(ArrayRef<SmallVector<int64_t>> byteOffsets,
+                               int accessBytes);
+
+/// Returns the offsets accessed by the first warp of `layout`, which maps
+/// (register, lane, warp, block) to (..., offset, ...), when every thread
+/// accesses `vecElems` consecutive registers per instruction.
+/// `result[i][lane]` is the offset, in elements, of the i-th access of `lane`.
+/// `remap` may modify the offsets, e.g. to account for padding.
+SmallVector<SmallVector<int64_t>>
+getWarpSharedOffsets(const LinearLayout &layout, int vecElems,
+                     function_ref<int64_t(int64_t)> remap = nullptr);
+
+struct ScratchConfig;
+
+/// Looks for a swizzle of the unpadded scratch buffer `config` of a conversion
+/// from `srcTy` to `dstTy` that makes both its stores and its loads free of
+/// bank conflicts, keeping their vector widths.  Only conversions between
+/// blocked layouts, or slices of them, are considered.  On success, sets the
+/// swizzle of `config` (maxPhase stays 1 if no swizzle is needed) and returns
+/// true.
+bool chooseConflictFreeSwizzle(RankedTensorType srcTy, RankedTensorType dstTy,
+                               ScratchConfig &config);
+
+/// Bank conflicts of the shared memory stores and loads of an operation, as
+/// lowered with linear layouts.
+struct SharedAccessConflicts {
+  std::optional<BankConflicts> store;
+  std::optional<BankConflicts> load;
+};
+
+/// Analyzes the shared memory accesses of `op`: the stores of local_alloc and
+/// local_store, the loads of local_load, and both for a convert_layout that
+/// goes through shared memory.  Accesses whose layouts can't be expressed as
+/// linear layouts are left out.
+SharedAccessConflicts getSharedAccessConflicts(Operation *op);
+
+} // namespace mlir::triton
+
+#endif // TRITON_ANALYSIS_BANKCONFLICTS_H
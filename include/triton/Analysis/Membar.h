@@ -4,15 +4,27 @@
 #include "Allocation.h"
 #include "llvm/ADT/SmallPtrSet.h"
 
+#include <optional>
 #include <set>
+#include <string>
 
 namespace mlir {
 
 class OpBuilder;
 
 struct BlockInfo {
+  /// Intervals are sorted by start, which lets isIntersected sweep two sets
+  /// in a single pass.
   using IntervalSetT = std::set<Interval<size_t>>;
 
+  /// A pair of conflicting accesses to the shared memory.
+  struct Hazard {
+    enum Kind { RAW, WAR, WAW };
+    Kind kind;
+    /// Part of the shared memory accessed by both operations.
+    Interval<size_t> interval;
+  };
+
   IntervalSetT syncReadIntervals;
   IntervalSetT syncWriteIntervals;
 
@@ -27,13 +39,24 @@ struct BlockInfo {
     return *this;
   }
 
+  /// Returns a hazard between the accesses of this BlockInfo object and the
+  /// following accesses in `other`, or std::nullopt if there is none.
+  std::optional<Hazard> getHazard(const BlockInfo &other) const {
+    if (auto interval =
+            getIntersection(syncWriteIntervals, other.syncReadIntervals))
+      return Hazard{Hazard::RAW, *interval};
+    if (auto interval =
+            getIntersection(syncReadIntervals, other.syncWriteIntervals))
+      return Hazard{Hazard::WAR, *interval};
+    if (auto interval =
+            getIntersection(syncWriteIntervals, other.syncWriteIntervals))
+      return Hazard{Hazard::WAW, *interval};
+    return std::nullopt;
+  }
+
   /// Returns true if intervals in two BlockInfo objects are intersected.
   bool isIntersected(const BlockInfo &other) const {
-    return /*RAW*/ isIntersected(syncWriteIntervals, other.syncReadIntervals) ||
-           /*WAR*/
-           isIntersected(syncReadIntervals, other.syncWriteIntervals) ||
-           /*WAW*/
-           isIntersected(syncWriteIntervals, other.syncWriteIntervals);
+    return getHazard(other).has_value();
   }
 
   /// Clears the intervals because a barrier is inserted.
@@ -51,16 +74,49 @@ struct BlockInfo {
   bool operator!=(const BlockInfo &other) const { return !(*this == other); }
 
 private:
-  bool isIntersected(const IntervalSetT &lhsIntervalSet,
-                     const IntervalSetT &rhsIntervalSet) const {
-    for (auto &lhs : lhsIntervalSet)
-      for (auto &rhs : rhsIntervalSet)
-        if (lhs.intersects(rhs))
-          return true;
-    return false;
+  /// Returns a non-empty interval contained in both an interval of `lhs` and
+  /// an interval of `rhs`, if any.  The intervals of both sets are visited by
+  /// increasing start, keeping the largest end seen so far in each set: an
+  /// interval intersects one of the other set that starts before it iff it
+  /// starts before that end.  This is O(n + m) instead of O(n * m).  Empty
+  /// intervals access no memory and are skipped.
+  static std::optional<Interval<size_t>>
+  getIntersection(const IntervalSetT &lhs, const IntervalSetT &rhs) {
+    auto lhsIt = lhs.begin(), rhsIt = rhs.begin();
+    size_t lhsMaxEnd = 0, rhsMaxEnd = 0;
+    while (lhsIt != lhs.end() || rhsIt != rhs.end()) {
+      bool fromLhs = rhsIt == rhs.end() ||
+                     (lhsIt != lhs.end() && lhsIt->start() <= rhsIt->start());
+      // Once a set is exhausted, the remaining intervals of the other one can
+      // only intersect intervals that ended before them.
+      if (fromLhs ? rhsIt == rhs.end() && lhsIt->start() >= rhsMaxEnd
+                  : lhsIt == lhs.end() && rhsIt->start() >= lhsMaxEnd)
+        break;
+      const Interval<size_t> &interval = fromLhs ? *lhsIt++ : *rhsIt++;
+      if (interval.size() == 0)
+        continue;
+      size_t &maxEnd = fromLhs ? lhsMaxEnd : rhsMaxEnd;
+      size_t otherMaxEnd = fromLhs ? rhsMaxEnd : lhsMaxEnd;
+      if (interval.start() < otherMaxEnd)
+        return Interval<size_t>(interval.start(),
+                                std::min(interval.end(), otherMaxEnd));
+      maxEnd = std::max(maxEnd, interval.end());
+    }
+    return std::nullopt;
   }
 };
 
+/// A barrier inserted by the membar analysis.
+struct MembarBarrierInfo {
+  Operation *barrier;
+  /// The hazard resolved by the barrier, std::nullopt for the barriers that
+  /// make the copies completed by an async wait visible to all threads.
+  std::optional<BlockInfo::Hazard> hazard;
+
+  /// Returns a description of why the barrier is needed.
+  std::string getReason() const;
+};
+
 //===----------------------------------------------------------------------===//
 // Shared Memory Barrier Analysis
 //===----------------------------------------------------------------------===//
@@ -80,8 +136,17 @@ public:
   /// a shared memory read. If the temporary storage is written but not read,
   /// it is considered as the problem of the operation itself but not the membar
   /// analysis.
+  ///
+  /// Barriers are first inserted greedily, right before the operations that
+  /// conflict with the pending accesses.  Because the blocks of a loop are
+  /// visited again once the accesses of the back edge are known, a barrier
+  /// inserted during an earlier visit may end up covered by one inserted
+  /// later.  Such barriers are removed once the analysis has converged, if the
+  /// function stays free of hazards without them.
   MembarAnalysis() = default;
-  explicit MembarAnalysis(Allocation *allocation) : allocation(allocation) {}
+  explicit MembarAnalysis(Allocation *allocation,
+                          SmallVector<MembarBarrierInfo> *barriers = nullptr)
+      : allocation(allocation), barriers(barriers) {}
 
   /// Runs the membar analysis to the given operation, inserts a barrier if
   /// necessary.
@@ -105,17 +170,42 @@ private:
   void resolve(FunctionOpInterface funcOp, FuncBlockInfoMapT *funcBlockInfoMap,
                OpBuilder *builder);
 
+  /// Propagates the pending accesses through the blocks of `funcOp` until a
+  /// fixed point is reached, calling `visit` on every non-terminator
+  /// operation, and fills the accesses pending at the end of each block.
+  /// Returns whether any block was visited more than once.
+  bool propagate(FunctionOpInterface funcOp,
+                 function_ref<void(Operation *, BlockInfo *)> visit,
+                 DenseMap<Block *, BlockInfo> &outputBlockInfoMap);
+
   /// Updates the BlockInfo operation based on the operation.
   void update(Operation *operation, BlockInfo *blockInfo,
               FuncBlockInfoMapT *funcBlockInfoMap, OpBuilder *builder);
 
+  /// Adds the shared memory accesses of the operation to `blockInfo`, and
+  /// returns the hazard that requires a barrier before it, if any.
+  std::optional<BlockInfo::Hazard>
+  transfer(Operation *operation, BlockInfo *blockInfo,
+           FuncBlockInfoMapT *funcBlockInfoMap);
+
+  /// Removes the inserted barriers that are covered by other barriers.
+  /// Returns the accesses pending at the end of each block with the
+  /// remaining barriers.
+  DenseMap<Block *, BlockInfo>
+  removeRedundantBarriers(FunctionOpInterface funcOp,
+                          FuncBlockInfoMapT *funcBlockInfoMap);
+
   /// Collects the successors of the terminator
   void visitTerminator(Operation *operation, SmallVector<Block *> &successors);
 
-  void insertBarrier(Operation *operation, OpBuilder *builder);
+  void insertBarrier(Operation *operation, OpBuilder *builder,
+                     std::optional<BlockInfo::Hazard> hazard);
 
 private:
   Allocation *allocation = nullptr;
+  SmallVector<MembarBarrierInfo> *barriers = nullptr;
+  /// Barriers inserted in the function being analyzed.
+  SmallVector<MembarBarrierInfo> inserted;
 };
 
 /// Postorder traversal on the callgraph to insert membar instructions
@@ -138,14 +228,18 @@ public:
           auto *allocation = moduleAllocation->getFuncData(funcOp);
           auto [it, inserted] = funcMap.try_emplace(funcOp, BlockInfo());
           if (inserted) {
-            MembarAnalysis analysis(allocation);
+            MembarAnalysis analysis(allocation, &barriers);
             analysis.run(funcMap);
           }
         });
   }
 
+  /// Returns the barriers inserted by the analysis, for reporting.
+  ArrayRef<MembarBarrierInfo> getBarriers() const { return barriers; }
+
 private:
   ModuleAllocation *moduleAllocation;
+  SmallVector<MembarBarrierInfo> barriers;
 };
 
 } // namespace mlir
@@ -7,9 +7,15 @@
 #include <optional>
 
 #include "triton/Tools/LinearLayout.h"
+#include "triton/Tools/LinearLayoutCache.h"
 
 namespace mlir::triton::gpu {
 
+// Returns the cache of LinearLayout operations owned by the TritonGPU dialect
+// of `ctx`.  Use it for operations that are repeated on the same layouts, e.g.
+// invertAndCompose between the layouts of a convert_layout op.
+LinearLayoutCache &getLinearLayoutCache(MLIRContext *ctx);
+
 // - BlockedEncodingAttrs have the following input dimensions.
 //
 //   "register": elements in one thread
@@ -72,9 +78,22 @@ bool isCrossCTAConversion(const LinearLayout &layout);
 //     offsets <- get offsets using the intermediate linear layout
 //     load registers[vecIdx * loadVec, (vecIdx + 1) * loadVec)] from shared
 //     memory
+//
+// If maxPhase > 1, the offsets of the buffer are swizzled as by
+// getSwizzleLayout.
 LinearLayout chooseShemLayoutForRegToRegConversion(
     MLIRContext *ctx, ArrayRef<unsigned> tensorShape,
-    ArrayRef<unsigned> repShape, ArrayRef<unsigned> order);
+    ArrayRef<unsigned> repShape, ArrayRef<unsigned> order,
+    unsigned swizzleVec = 1, unsigned perPhase = 1, unsigned maxPhase = 1);
+
+// Returns the "offset" -> "offset" layout that swizzles a buffer of shape
+// `shape`, laid out in `order`, the way a SharedEncodingAttr with the given
+// vec, perPhase and maxPhase does: the column of each element, in units of
+// `vec` elements, is xor'ed with (row / perPhase) % maxPhase.  The swizzle is
+// its own inverse.
+LinearLayout getSwizzleLayout(MLIRContext *ctx, ArrayRef<unsigned> shape,
+                              ArrayRef<unsigned> order, unsigned vec,
+                              unsigned perPhase, unsigned maxPhase);
 } // namespace mlir::triton::gpu
 
 #endif // TRITON_DIALECT_TRITONGPU_IR_LINEARLAYOUTCONVERSIONS_H
@@ -0,0 +1,90 @@
+#ifndef TRITON_TOOLS_BITMATRIX_H
+#define TRITON_TOOLS_BITMATRIX_H
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace mlir::triton {
+
+// A dense matrix over GF(2) of at most 64 x 64 bits.
+//
+// Each column is packed in a single 64-bit word, bit r of column c being the
+// element at row r, column c.  A LinearLayout maps to such a matrix by taking
+// its bases as the columns, with the bits of all the out-dims concatenated.
+// This makes the usual operations word-parallel: applying the matrix to a
+// vector XORs one column per set bit of the vector, and a product applies the
+// left matrix to each column of the right one.
+class BitMatrix {
+public:
+  static constexpr int kMaxSize = 64;
+
+  BitMatrix(int numRows, int numCols) : numRows(numRows), numCols(numCols) {
+    assert(numRows >= 0 && numRows <= kMaxSize && "BitMatrix too large");
+    assert(numCols >= 0 && numCols <= kMaxSize && "BitMatrix too large");
+  }
+
+  static BitMatrix identity(int size);
+
+  int getNumRows() const { return numRows; }
+  int getNumCols() const { return numCols; }
+
+  uint64_t getColumn(int c) const {
+    assert(c >= 0 && c < numCols);
+    return columns[c];
+  }
+  void setColumn(int c, uint64_t column) {
+    assert(c >= 0 && c < numCols);
+    assert((column & ~rowMask()) == 0 && "Column has too many rows");
+    columns[c] = column;
+  }
+
+  bool get(int r, int c) const { return (getColumn(c) >> r) & 1; }
+
+  // Returns M * x, where bit i of `x` is the element i of the vector.
+  uint64_t apply(uint64_t x) const {
+    assert((x & ~colMask()) == 0 && "Vector has too many elements");
+    uint64_t ret = 0;
+    for (; x != 0; x &= x - 1)
+      ret ^= columns[__builtin_ctzll(x)];
+    return ret;
+  }
+
+  // Matrix product, i.e. the composition `this(rhs(x))`.
+  BitMatrix operator*(const BitMatrix &rhs) const;
+
+  BitMatrix transpose() const;
+
+  // Returns the number of linearly-independent columns.
+  int rank() const;
+
+  // Returns a mask of the columns that are not in the span of the columns
+  // before them.  These are the pivot columns of the reduced row echelon form
+  // of the matrix, i.e. the basic variables of M * x = y.
+  uint64_t getPivotColumns() const;
+
+  // Returns the inverse of a square matrix, or std::nullopt if the matrix is
+  // singular.
+  std::optional<BitMatrix> inverse() const;
+
+  bool operator==(const BitMatrix &other) const;
+  bool operator!=(const BitMatrix &other) const { return !(*this == other); }
+
+  // One line per row, column 0 first.
+  std::string toString() const;
+
+private:
+  static uint64_t lowBits(int n) { return n == 64 ? ~0ULL : (1ULL << n) - 1; }
+  uint64_t rowMask() const { return lowBits(numRows); }
+  uint64_t colMask() const { return lowBits(numCols); }
+
+  int numRows;
+  int numCols;
+  std::array<uint64_t, kMaxSize> columns{};
+};
+
+} // namespace mlir::triton
+
+#endif // TRITON_TOOLS_BITMATRIX_H
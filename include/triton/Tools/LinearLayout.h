@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "mlir/IR/BuiltinAttributes.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
@@ -690,12 +691,16 @@ public:
 
   std::string toString() const;
 
-  friend bool operator==(LinearLayout lhs, LinearLayout rhs);
-  friend bool operator!=(LinearLayout lhs, LinearLayout rhs) {
+  friend bool operator==(const LinearLayout &lhs, const LinearLayout &rhs);
+  friend bool operator!=(const LinearLayout &lhs, const LinearLayout &rhs) {
     return !(lhs == rhs);
   }
   bool equalIgnoringOutDimSizes(const LinearLayout &other) const;
 
+  // Hashes the bases and the out-dims of the layout, so that layouts which
+  // compare equal have equal hashes.
+  friend llvm::hash_code hash_value(const LinearLayout &layout);
+
 private:
   // Factory function that gracefully fails rather than asserts if the layout is
   // not well-formed.
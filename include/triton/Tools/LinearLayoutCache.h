@@ -0,0 +1,81 @@
+#ifndef TRITON_TOOLS_LINEARLAYOUTCACHE_H
+#define TRITON_TOOLS_LINEARLAYOUTCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "triton/Tools/LinearLayout.h"
+
+namespace mlir::triton {
+
+// Memoizes the LinearLayout operations whose cost grows with the size of the
+// layouts, e.g. invertAndCompose, which runs a Gaussian elimination.
+//
+// Lowering a module computes the same operations on the same pairs of layouts
+// many times (e.g. once per convert_layout op, in each of the analyses and in
+// the conversion to LLVM).  With the cache, all but the first computation cost
+// a hash of the operands plus a structural comparison with the cached ones.
+//
+// Layouts refer to StringAttrs, so a cache must not outlive the MLIRContext of
+// the layouts it holds.  The TritonGPU dialect owns a cache per context, see
+// `getLinearLayoutCache` in LinearLayoutConversions.h.
+//
+// A module only uses a handful of layouts, but a context may compile many
+// modules, so the cache is emptied when it holds `maxSize` entries.
+//
+// [MT] All the methods are thread-safe.
+class LinearLayoutCache {
+public:
+  explicit LinearLayoutCache(size_t maxSize = 4096) : maxSize(maxSize) {}
+
+  // Same as inner.compose(outer).
+  [[nodiscard]] LinearLayout compose(const LinearLayout &inner,
+                                     const LinearLayout &outer);
+
+  // Same as inner.invertAndCompose(outer).
+  [[nodiscard]] LinearLayout invertAndCompose(const LinearLayout &inner,
+                                              const LinearLayout &outer);
+
+  // Same as inner * outer.
+  [[nodiscard]] LinearLayout multiply(const LinearLayout &inner,
+                                      const LinearLayout &outer);
+
+  // Same as dividend.divideRight(divisor).
+  std::optional<LinearLayout> divideRight(const LinearLayout &dividend,
+                                          const LinearLayout &divisor);
+
+  int64_t getNumHits() const { return numHits; }
+  int64_t getNumMisses() const { return numMisses; }
+  size_t size() const;
+
+  void clear();
+
+private:
+  enum class Op { Compose, InvertAndCompose, Multiply, DivideRight };
+
+  struct Entry {
+    Op op;
+    LinearLayout lhs;
+    LinearLayout rhs;
+    std::optional<LinearLayout> result;
+  };
+
+  template <typename ComputeFn>
+  std::optional<LinearLayout> getOrCompute(Op op, const LinearLayout &lhs,
+                                           const LinearLayout &rhs,
+                                           ComputeFn &&compute);
+
+  const size_t maxSize;
+  mutable std::shared_mutex mutex;
+  // Hash of (op, lhs, rhs) -> entries with that hash.
+  std::unordered_multimap<size_t, Entry> entries;
+  std::atomic<int64_t> numHits{0};
+  std::atomic<int64_t> numMisses{0};
+};
+
+} // namespace mlir::triton
+
+#endif // TRITON_TOOLS_LINEARLAYOUTCACHE_H
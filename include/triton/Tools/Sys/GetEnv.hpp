@@ -23,11 +23,14 @@ inline const std::set<std::string> CACHE_INVALIDATING_ENV_VARS = {
     "MLIR_ENABLE_DIAGNOSTICS",
     "MLIR_ENABLE_DUMP",
     "MLIR_ENABLE_TIMING",
+    "TRITON_COMPILE_TELEMETRY",
     "TRITON_DEFAULT_FP_FUSION",
     "TRITON_DISABLE_LINE_INFO",
     "TRITON_DISABLE_RESHAPE_ENCODING_INFERENCE",
     "TRITON_ENABLE_LLVM_DEBUG",
     "TRITON_LLVM_DEBUG_ONLY",
+    "TRITON_SMEM_ALLOCATOR",
+    "TRITON_SMEM_SWIZZLE_CVT",
     "USE_IR_LOC",
     "NVPTX_ENABLE_DUMP",
     // clang-format on
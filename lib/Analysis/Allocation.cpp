@@ -10,9 +10,12 @@
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/Support/LLVM.h"
 #include "triton/Analysis/Alias.h"
+#include "triton/Analysis/BankConflicts.h"
 #include "triton/Dialect/Triton/IR/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Tools/Sys/GetEnv.hpp"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSwitch.h"
 
 using ::mlir::triton::gpu::AMDMfmaEncodingAttr;
 using ::mlir::triton::gpu::BlockedEncodingAttr;
@@ -145,11 +148,107 @@ ScratchConfig getScratchConfigForCvt(RankedTensorType srcTy,
   if (rank <= 1)
     return scratchConfig;
 
+  if (tools::getBoolEnv("TRITON_SMEM_SWIZZLE_CVT") &&
+      chooseConflictFreeSwizzle(srcTy, dstTy, scratchConfig))
+    return scratchConfig;
+
   auto paddedSize = std::max(scratchConfig.inVec, scratchConfig.outVec);
   scratchConfig.paddedRepShape[outOrd[0]] += paddedSize;
   return scratchConfig;
 }
 
+std::optional<AllocationStrategy> parseAllocationStrategy(StringRef name) {
+  return llvm::StringSwitch<std::optional<AllocationStrategy>>(name)
+      .Case("graph-coloring", AllocationStrategy::GraphColoring)
+      .Case("best-fit", AllocationStrategy::BestFit)
+      .Default(std::nullopt);
+}
+
+AllocationStrategy getDefaultAllocationStrategy() {
+  auto name = tools::getStrEnv("TRITON_SMEM_ALLOCATOR");
+  if (name.empty())
+    return AllocationStrategy::GraphColoring;
+  auto strategy = parseAllocationStrategy(name);
+  if (!strategy)
+    llvm::report_fatal_error("Unknown TRITON_SMEM_ALLOCATOR: " + Twine(name));
+  return *strategy;
+}
+
+namespace {
+
+/// A static interval tree over a fixed set of liveness ranges.
+/// The ranges are sorted by start and laid out as an implicit balanced binary
+/// search tree, where each node also records the largest end in its subtree.
+/// Ranges are only reported by queries once they have been activated, which
+/// lets the allocator look up the placed buffers that overlap a new one in
+/// O(log(n) + k) instead of scanning all of them.
+class LivenessIntervalTree {
+public:
+  explicit LivenessIntervalTree(ArrayRef<Interval<size_t>> ranges)
+      : positions(ranges.size()) {
+    for (auto [index, range] : llvm::enumerate(ranges))
+      nodes.push_back({range, index, range.end(), false});
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [](const Node &lhs, const Node &rhs) {
+                       return lhs.range < rhs.range;
+                     });
+    for (auto [position, node] : llvm::enumerate(nodes))
+      positions[node.index] = position;
+    build(0, nodes.size());
+  }
+
+  /// Makes the `index`-th range visible to queries.
+  void activate(size_t index) { nodes[positions[index]].active = true; }
+
+  /// Calls `fn` with the index of every active range intersecting `range`.
+  template <typename FnT>
+  void forEachActiveOverlap(Interval<size_t> range, FnT &&fn) const {
+    query(0, nodes.size(), range, fn);
+  }
+
+private:
+  struct Node {
+    Interval<size_t> range;
+    size_t index;
+    size_t maxEnd;
+    bool active;
+  };
+
+  size_t build(size_t lo, size_t hi) {
+    if (lo >= hi)
+      return 0;
+    auto mid = lo + (hi - lo) / 2;
+    auto &node = nodes[mid];
+    node.maxEnd =
+        std::max({node.range.end(), build(lo, mid), build(mid + 1, hi)});
+    return node.maxEnd;
+  }
+
+  template <typename FnT>
+  void query(size_t lo, size_t hi, Interval<size_t> range, FnT &fn) const {
+    if (lo >= hi)
+      return;
+    auto mid = lo + (hi - lo) / 2;
+    auto &node = nodes[mid];
+    // No range in this subtree ends after the query starts
+    if (node.maxEnd <= range.start())
+      return;
+    query(lo, mid, range, fn);
+    if (node.active && node.range.intersects(range))
+      fn(node.index);
+    // Ranges in the right subtree start after the query ends
+    if (node.range.start() >= range.end())
+      return;
+    query(mid + 1, hi, range, fn);
+  }
+
+  SmallVector<Node> nodes;
+  // Range index -> node position
+  SmallVector<size_t> positions;
+};
+
+} // namespace
+
 class AllocationAnalysis {
 public:
   AllocationAnalysis(Operation *operation,
@@ -431,6 +530,12 @@ private:
       buffers.emplace_back(bufferIter.first);
     }
 
+    computePeakLiveSize(buffers);
+    if (allocation->getStrategy() == AllocationStrategy::BestFit) {
+      computeBestFitOffsets(buffers);
+      return;
+    }
+
     calculateStarts(buffers);
 
     // NOTE: The original paper doesn't consider interference between
@@ -448,6 +553,85 @@ private:
     } while (!interference.empty());
   }
 
+  /// Computes the largest total size of the buffers live at the same time.
+  void computePeakLiveSize(const SmallVector<BufferT *> &buffers) {
+    // (operation id, size delta). Liveness ranges are half-open, so a buffer
+    // ending at an operation is released before one starting there.
+    SmallVector<std::pair<size_t, int64_t>> events;
+    for (auto *buffer : buffers) {
+      auto range = bufferRange.lookup(buffer);
+      auto size = static_cast<int64_t>(buffer->size);
+      events.push_back({range.start(), size});
+      events.push_back({range.end(), -size});
+    }
+    llvm::sort(events);
+    int64_t liveSize = 0;
+    allocation->peakLiveSize = 0;
+    for (auto [id, delta] : events) {
+      liveSize += delta;
+      allocation->peakLiveSize =
+          std::max(allocation->peakLiveSize, static_cast<size_t>(liveSize));
+    }
+  }
+
+  /// Computes the shared memory offsets with best-fit packing.
+  /// Buffers are placed from the largest to the smallest. Each buffer goes to
+  /// the smallest gap left between the placed buffers whose liveness overlaps
+  /// with it, or right above them if none of the gaps is large enough. Every
+  /// buffer is placed once, so no interference fixup is needed.
+  void computeBestFitOffsets(const SmallVector<BufferT *> &buffers) {
+    SmallVector<Interval<size_t>> ranges;
+    for (auto *buffer : buffers)
+      ranges.push_back(bufferRange.lookup(buffer));
+    LivenessIntervalTree tree(ranges);
+
+    // Large and long-lived buffers are the hardest to fit, place them first
+    SmallVector<size_t> order(buffers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+      if (buffers[lhs]->size != buffers[rhs]->size)
+        return buffers[lhs]->size > buffers[rhs]->size;
+      return ranges[lhs].size() > ranges[rhs].size();
+    });
+
+    allocation->sharedMemorySize = 0;
+    SmallVector<Interval<size_t>> occupied;
+    for (auto i : order) {
+      auto *buffer = buffers[i];
+      occupied.clear();
+      tree.forEachActiveOverlap(ranges[i], [&](size_t j) {
+        auto *placed = buffers[j];
+        occupied.push_back(
+            Interval(placed->offset, placed->offset + placed->size));
+      });
+      llvm::sort(occupied);
+
+      std::optional<size_t> bestOffset;
+      size_t bestSlack = 0;
+      size_t gapStart = 0;
+      for (auto range : occupied) {
+        if (range.start() > gapStart) {
+          auto offset = llvm::alignTo(gapStart, buffer->alignment);
+          if (offset + buffer->size <= range.start()) {
+            auto slack = range.start() - gapStart - buffer->size;
+            if (!bestOffset || slack < bestSlack) {
+              bestOffset = offset;
+              bestSlack = slack;
+            }
+          }
+        }
+        gapStart = std::max(gapStart, range.end());
+      }
+      if (bestOffset)
+        buffer->offset = *bestOffset;
+      else
+        buffer->setOffsetAligned(gapStart);
+      tree.activate(i);
+      allocation->sharedMemorySize =
+          std::max(allocation->sharedMemorySize, buffer->offset + buffer->size);
+    }
+  }
+
   /// Computes the initial shared memory offsets.
   void calculateStarts(const SmallVector<BufferT *> &buffers) {
     //  v = values in shared memory
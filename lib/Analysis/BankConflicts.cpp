@@ -0,0 +1,280 @@
+#include "triton/Analysis/BankConflicts.h"
+
+#include <algorithm>
+#include <string>
+
+#include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/Triton/IR/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
+
+namespace mlir::triton {
+
+using ::mlir::triton::gpu::BlockedEncodingAttr;
+using ::mlir::triton::gpu::getLinearLayoutCache;
+using ::mlir::triton::gpu::SharedEncodingAttr;
+using ::mlir::triton::gpu::SliceEncodingAttr;
+
+BankConflicts getBankConflicts(ArrayRef<SmallVector<int64_t>> byteOffsets,
+                               int accessBytes) {
+  BankConflicts result;
+  int pieceBytes = std::min(accessBytes, 16);
+  int numPieces = ceil(accessBytes, pieceBytes);
+  // The threads of a warp are served in groups that access at most 128 bytes.
+  int lanesPerPhase = kNumSharedBanks * kSharedBankBytes /
+                      std::max(pieceBytes, kSharedBankBytes);
+  for (ArrayRef<int64_t> offsets : byteOffsets) {
+    if (offsets.empty())
+      continue;
+    for (int piece = 0; piece < numPieces; piece++) {
+      int64_t wavefronts = 0;
+      int64_t minWavefronts = 0;
+      for (size_t first = 0; first < offsets.size(); first += lanesPerPhase) {
+        // Threads accessing the same word are served at once, so only the
+        // distinct words matter.
+        SmallVector<int64_t> words;
+        for (int64_t offset : offsets.slice(
+                 first, std::min<size_t>(lanesPerPhase,
+                                         offsets.size() - first))) {
+          int64_t start = offset + piece * pieceBytes;
+          int64_t end = start + pieceBytes - 1;
+          for (int64_t word = start / kSharedBankBytes;
+               word <= end / kSharedBankBytes; word++)
+            words.push_back(word);
+        }
+        llvm::sort(words);
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        SmallVector<int64_t> wordsPerBank(kNumSharedBanks);
+        for (int64_t word : words)
+          wordsPerBank[word % kNumSharedBanks]++;
+        wavefronts += *std::max_element(wordsPerBank.begin(),
+                                        wordsPerBank.end());
+        minWavefronts += ceil<int64_t>(words.size(), kNumSharedBanks);
+      }
+      result.wavefronts += wavefronts;
+      result.minWavefronts += minWavefronts;
+      result.ways =
+          std::max(result.ways, ceil<int64_t>(wavefronts, minWavefronts));
+    }
+  }
+  return result;
+}
+
+SmallVector<SmallVector<int64_t>>
+getWarpSharedOffsets(const LinearLayout &layout, int vecElems,
+                     function_ref<int64_t(int64_t)> remap) {
+  MLIRContext *ctx = layout.getInDimNames().begin()->getContext();
+  StringAttr kRegister = StringAttr::get(ctx, "register");
+  StringAttr kLane = StringAttr::get(ctx, "lane");
+  StringAttr kOffset = StringAttr::get(ctx, "offset");
+
+  SmallVector<SmallVector<int64_t>> result;
+  for (int reg = 0; reg < layout.getInDimSize(kRegister); reg += vecElems) {
+    auto &offsets = result.emplace_back();
+    for (int lane = 0; lane < layout.getInDimSize(kLane); lane++) {
+      // The other input dims, warp and block, are 0.
+      SmallVector<std::pair<StringAttr, int32_t>> ins;
+      for (StringAttr inDim : layout.getInDimNames())
+        ins.push_back({inDim, inDim == kRegister ? reg
+                              : inDim == kLane   ? lane
+                                                 : 0});
+      int64_t offset = 0;
+      for (auto [outDim, value] : layout.apply(ins))
+        if (outDim == kOffset)
+          offset = value;
+      offsets.push_back(remap ? remap(offset) : offset);
+    }
+  }
+  return result;
+}
+
+namespace {
+
+int getElemBytes(Type elemTy) {
+  // Sub-byte elements are stored as bytes, and pointers as 64-bit integers.
+  if (isa<triton::PointerType>(elemTy))
+    return 8;
+  return std::max<int>(8, elemTy.getIntOrFloatBitWidth()) / 8;
+}
+
+// Same as getBankConflicts, with offsets in elements.
+BankConflicts getElemBankConflicts(ArrayRef<SmallVector<int64_t>> offsets,
+                                   int elemBytes, int vecElems) {
+  SmallVector<SmallVector<int64_t>> byteOffsets;
+  for (ArrayRef<int64_t> instOffsets : offsets)
+    byteOffsets.push_back(llvm::to_vector(llvm::map_range(
+        instOffsets, [&](int64_t offset) { return offset * elemBytes; })));
+  return getBankConflicts(byteOffsets, vecElems * elemBytes);
+}
+
+// Returns the bank conflicts of the transfer between registers of type
+// `registerTy` and shared memory of type `sharedTy`, as lowered by
+// emitTransferBetweenRegistersAndShared.
+std::optional<BankConflicts> getTransferConflicts(RankedTensorType registerTy,
+                                                  MemDescType sharedTy) {
+  MLIRContext *ctx = registerTy.getContext();
+  auto shape = registerTy.getShape();
+  int rank = shape.size();
+  Type elemTy = registerTy.getElementType();
+  int elemBitWidth = isa<triton::PointerType>(elemTy)
+                         ? 64
+                         : elemTy.getIntOrFloatBitWidth();
+  auto sharedEnc = dyn_cast<SharedEncodingAttr>(sharedTy.getEncoding());
+  if (!sharedEnc)
+    return std::nullopt;
+  auto regLayout = gpu::toLinearLayout(shape, registerTy.getEncoding());
+  auto sharedLayout = gpu::toLinearLayout(shape, sharedEnc, elemBitWidth);
+  if (!regLayout || !sharedLayout)
+    return std::nullopt;
+
+  // The vector width is the number of consecutive registers in the most minor
+  // dimension of the buffer, see emitTransferBetweenRegistersAndShared.
+  StringAttr kBlock = StringAttr::get(ctx, "block");
+  auto order = gpu::getOrder(sharedEnc);
+  auto ctaSplitNum = sharedEnc.getCTALayout().getCTASplitNum();
+  SmallVector<std::pair<StringAttr, int32_t>> multiDimSharedSize;
+  for (int i = 0; i < rank; i++) {
+    int dim = order[i];
+    int64_t size = std::max(int64_t{1}, shape[dim] / ctaSplitNum[dim]);
+    multiDimSharedSize.push_back(
+        {StringAttr::get(ctx, "offset" + std::to_string(dim)), size});
+  }
+  multiDimSharedSize.push_back({kBlock, sharedLayout->getInDimSize(kBlock)});
+  LinearLayoutCache &cache = getLinearLayoutCache(ctx);
+  int vecElems = cache
+                     .invertAndCompose(*regLayout, sharedLayout->reshapeIns(
+                                                       multiDimSharedSize))
+                     .getNumConsecutiveInOut();
+
+  auto offsets = getWarpSharedOffsets(
+      cache.invertAndCompose(*regLayout, *sharedLayout), vecElems);
+  return getElemBankConflicts(offsets, getElemBytes(elemTy), vecElems);
+}
+
+bool isBlockedOrSliceOfBlocked(Attribute layout) {
+  if (auto slice = dyn_cast<SliceEncodingAttr>(layout))
+    return isBlockedOrSliceOfBlocked(slice.getParent());
+  return isa<BlockedEncodingAttr>(layout);
+}
+
+// Returns the layouts of the stores to and the loads from the scratch buffer
+// of a conversion from `srcTy` to `dstTy`, as lowered by
+// ConvertLayoutOpUsingLinearLayoutsConversion.  They map (register, lane,
+// warp, block) to (offset, iteration, block).
+std::optional<std::pair<LinearLayout, LinearLayout>>
+getScratchLayouts(RankedTensorType srcTy, RankedTensorType dstTy,
+                  const ScratchConfig &config) {
+  MLIRContext *ctx = srcTy.getContext();
+  auto shape = dstTy.getShape();
+  auto srcLayout = gpu::toLinearLayout(shape, srcTy.getEncoding());
+  auto dstLayout = gpu::toLinearLayout(shape, dstTy.getEncoding());
+  if (!srcLayout || !dstLayout)
+    return std::nullopt;
+  LinearLayoutCache &cache = getLinearLayoutCache(ctx);
+  if (gpu::isCrossCTAConversion(
+          cache.invertAndCompose(*srcLayout, *dstLayout)))
+    return std::nullopt;
+  LinearLayout sharedLayout = gpu::chooseShemLayoutForRegToRegConversion(
+      ctx, convertType<unsigned, int64_t>(shape), config.repShape,
+      config.order, config.swizzleVec, config.perPhase, config.maxPhase);
+  return std::make_pair(cache.invertAndCompose(*srcLayout, sharedLayout),
+                        cache.invertAndCompose(*dstLayout, sharedLayout));
+}
+
+} // namespace
+
+bool chooseConflictFreeSwizzle(RankedTensorType srcTy, RankedTensorType dstTy,
+                               ScratchConfig &config) {
+  assert(config.maxPhase == 1 && config.repShape == config.paddedRepShape);
+  if (config.repShape.size() < 2 ||
+      !isBlockedOrSliceOfBlocked(srcTy.getEncoding()) ||
+      !isBlockedOrSliceOfBlocked(dstTy.getEncoding()))
+    return false;
+  auto layouts = getScratchLayouts(srcTy, dstTy, config);
+  if (!layouts)
+    return false;
+  MLIRContext *ctx = srcTy.getContext();
+  StringAttr kOffset = StringAttr::get(ctx, "offset");
+  int elemBytes = getElemBytes(srcTy.getElementType());
+  auto storeOffsets = getWarpSharedOffsets(layouts->first, config.inVec);
+  auto loadOffsets = getWarpSharedOffsets(layouts->second, config.outVec);
+
+  // Swizzling by vectors at least as wide as the accesses keeps them
+  // contiguous.
+  unsigned vec = std::max(config.inVec, config.outVec);
+  unsigned numCols = config.repShape[config.order[0]];
+  unsigned numRows = config.repShape[config.order[1]];
+  // Fewer phases first, starting with no swizzle at all.
+  for (unsigned maxPhase = 1; maxPhase * vec <= numCols; maxPhase *= 2) {
+    for (unsigned perPhase = 1; perPhase * maxPhase <= numRows;
+         perPhase *= 2) {
+      LinearLayout swizzle = gpu::getSwizzleLayout(
+          ctx, config.repShape, config.order, vec, perPhase, maxPhase);
+      auto isConflictFree = [&](ArrayRef<SmallVector<int64_t>> offsets,
+                                int vecElems) {
+        SmallVector<SmallVector<int64_t>> swizzled;
+        for (ArrayRef<int64_t> instOffsets : offsets)
+          swizzled.push_back(llvm::to_vector(
+              llvm::map_range(instOffsets, [&](int64_t offset) -> int64_t {
+                return swizzle.apply({{kOffset, int32_t(offset)}})[0].second;
+              })));
+        return getElemBankConflicts(swizzled, elemBytes, vecElems)
+            .isConflictFree();
+      };
+      if (isConflictFree(storeOffsets, config.inVec) &&
+          isConflictFree(loadOffsets, config.outVec)) {
+        config.swizzleVec = vec;
+        config.perPhase = perPhase;
+        config.maxPhase = maxPhase;
+        return true;
+      }
+      // Without swizzle, perPhase makes no difference.
+      if (maxPhase == 1)
+        break;
+    }
+  }
+  return false;
+}
+
+SharedAccessConflicts getSharedAccessConflicts(Operation *op) {
+  SharedAccessConflicts result;
+  if (auto alloc = dyn_cast<gpu::LocalAllocOp>(op)) {
+    if (alloc.getSrc())
+      result.store =
+          getTransferConflicts(alloc.getSrc().getType(), alloc.getType());
+  } else if (auto store = dyn_cast<gpu::LocalStoreOp>(op)) {
+    result.store = getTransferConflicts(store.getSrc().getType(),
+                                        store.getDst().getType());
+  } else if (auto load = dyn_cast<gpu::LocalLoadOp>(op)) {
+    result.load =
+        getTransferConflicts(load.getType(), load.getSrc().getType());
+  } else if (auto cvt = dyn_cast<gpu::ConvertLayoutOp>(op)) {
+    RankedTensorType srcTy = cvt.getSrc().getType();
+    RankedTensorType dstTy = cvt.getType();
+    if (isa<SharedEncodingAttr>(srcTy.getEncoding()) ||
+        isa<SharedEncodingAttr>(dstTy.getEncoding()) ||
+        !cvtNeedsSharedMemory(srcTy, dstTy))
+      return result;
+    ScratchConfig config = getScratchConfigForCvt(srcTy, dstTy);
+    auto layouts = getScratchLayouts(srcTy, dstTy, config);
+    if (!layouts)
+      return result;
+    // The lowering pads the buffer along its most minor dimension.
+    unsigned stride = config.repShape[config.order[0]];
+    unsigned padding = config.paddedRepShape[config.order[0]] - stride;
+    auto pad = [&](int64_t offset) {
+      return offset + offset / stride * padding;
+    };
+    int elemBytes = getElemBytes(srcTy.getElementType());
+    result.store = getElemBankConflicts(
+        getWarpSharedOffsets(layouts->first, config.inVec, pad), elemBytes,
+        config.inVec);
+    result.load = getElemBankConflicts(
+        getWarpSharedOffsets(layouts->second, config.outVec, pad), elemBytes,
+        config.outVec);
+  }
+  return result;
+}
+
+} // namespace mlir::triton
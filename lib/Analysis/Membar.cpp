@@ -20,10 +20,6 @@ void MembarAnalysis::run(FuncBlockInfoMapT &funcBlockInfoMap) {
 void MembarAnalysis::resolve(FunctionOpInterface funcOp,
                              FuncBlockInfoMapT *funcBlockInfoMap,
                              OpBuilder *builder) {
-  // Initialize the blockList
-  DenseMap<Block *, BlockInfo> inputBlockInfoMap;
-  DenseMap<Block *, BlockInfo> outputBlockInfoMap;
-  std::deque<Block *> blockList;
   funcOp.walk<WalkOrder::PreOrder>([&](Block *block) {
     for (auto &op : block->getOperations()) {
       // Check if the operation belongs to scf dialect, if so, we need to
@@ -35,6 +31,46 @@ void MembarAnalysis::resolve(FunctionOpInterface funcOp,
         return;
       }
     }
+  });
+
+  DenseMap<Block *, BlockInfo> outputBlockInfoMap;
+  bool revisited = propagate(
+      funcOp,
+      [&](Operation *op, BlockInfo *blockInfo) {
+        update(op, blockInfo, funcBlockInfoMap, builder);
+      },
+      outputBlockInfoMap);
+  // Only the barriers inserted before a block is visited again can be covered
+  // by another one.
+  if (revisited && inserted.size() > 1) {
+    // Removing barriers may leave more accesses pending at the end of a block,
+    // which have to be visible to the callers.
+    for (auto &[block, blockInfo] :
+         removeRedundantBarriers(funcOp, funcBlockInfoMap))
+      outputBlockInfoMap[block].join(blockInfo);
+  }
+  if (barriers)
+    barriers->append(inserted.begin(), inserted.end());
+
+  // Update the final dangling buffers that haven't been synced
+  auto &funcBlockInfo = (*funcBlockInfoMap)[funcOp];
+  funcOp.walk<WalkOrder::PreOrder>([&](Block *block) {
+    block->walk([&](triton::ReturnOp returnOp) {
+      funcBlockInfo.join(outputBlockInfoMap[block]);
+    });
+  });
+}
+
+bool MembarAnalysis::propagate(
+    FunctionOpInterface funcOp,
+    function_ref<void(Operation *, BlockInfo *)> visit,
+    DenseMap<Block *, BlockInfo> &outputBlockInfoMap) {
+  // Initialize the blockList
+  DenseMap<Block *, BlockInfo> inputBlockInfoMap;
+  DenseSet<Block *> visited;
+  bool revisited = false;
+  std::deque<Block *> blockList;
+  funcOp.walk<WalkOrder::PreOrder>([&](Block *block) {
     if (block->isEntryBlock())
       blockList.emplace_back(block);
   });
@@ -43,6 +79,7 @@ void MembarAnalysis::resolve(FunctionOpInterface funcOp,
   while (!blockList.empty()) {
     auto *block = blockList.front();
     blockList.pop_front();
+    revisited |= !visited.insert(block).second;
     // Make a copy of the inputblockInfo but not update
     auto inputBlockInfo = inputBlockInfoMap[block];
     SmallVector<Block *> successors;
@@ -50,7 +87,7 @@ void MembarAnalysis::resolve(FunctionOpInterface funcOp,
       if (op.hasTrait<OpTrait::IsTerminator>()) {
         visitTerminator(&op, successors);
       } else {
-        update(&op, &inputBlockInfo, funcBlockInfoMap, builder);
+        visit(&op, &inputBlockInfo);
       }
     }
     // Get the reference because we want to update if it changed
@@ -68,14 +105,57 @@ void MembarAnalysis::resolve(FunctionOpInterface funcOp,
       blockList.emplace_back(successor);
     }
   }
+  return revisited;
+}
 
-  // Update the final dangling buffers that haven't been synced
-  auto &funcBlockInfo = (*funcBlockInfoMap)[funcOp];
-  funcOp.walk<WalkOrder::PreOrder>([&](Block *block) {
-    block->walk([&](triton::ReturnOp returnOp) {
-      funcBlockInfo.join(outputBlockInfoMap[block]);
-    });
+DenseMap<Block *, BlockInfo>
+MembarAnalysis::removeRedundantBarriers(FunctionOpInterface funcOp,
+                                        FuncBlockInfoMapT *funcBlockInfoMap) {
+  DenseSet<Operation *> removed;
+  DenseMap<Block *, BlockInfo> outputBlockInfoMap;
+  // Replays the analysis without inserting barriers, ignoring the removed
+  // ones, and returns whether all the hazards are still covered.
+  auto isHazardFree = [&]() {
+    bool hazardFree = true;
+    outputBlockInfoMap.clear();
+    propagate(
+        funcOp,
+        [&](Operation *op, BlockInfo *blockInfo) {
+          if (isa<gpu::BarrierOp>(op)) {
+            if (!removed.contains(op))
+              blockInfo->sync();
+            return;
+          }
+          if (transfer(op, blockInfo, funcBlockInfoMap))
+            hazardFree = false;
+        },
+        outputBlockInfoMap);
+    return hazardFree;
+  };
+
+  // The barriers inserted last were placed with the most complete
+  // information, so the earlier ones are more likely to be covered by them.
+  bool lastRemoved = false;
+  for (auto &info : llvm::reverse(inserted)) {
+    // The barriers after async waits are needed whatever the accesses.
+    if (!info.hazard)
+      continue;
+    removed.insert(info.barrier);
+    lastRemoved = isHazardFree();
+    if (!lastRemoved)
+      removed.erase(info.barrier);
+  }
+  if (removed.empty())
+    return {};
+  if (!lastRemoved)
+    isHazardFree();
+
+  llvm::erase_if(inserted, [&](const MembarBarrierInfo &info) {
+    return removed.contains(info.barrier);
   });
+  for (Operation *barrier : removed)
+    barrier->erase();
+  return outputBlockInfoMap;
 }
 
 void MembarAnalysis::visitTerminator(Operation *op,
@@ -92,9 +172,11 @@ void MembarAnalysis::visitTerminator(Operation *op,
   llvm_unreachable("Unknown terminator encountered in membar analysis");
 }
 
-void MembarAnalysis::insertBarrier(Operation *op, OpBuilder *builder) {
+void MembarAnalysis::insertBarrier(Operation *op, OpBuilder *builder,
+                                   std::optional<BlockInfo::Hazard> hazard) {
   OpBuilder::InsertionGuard g(*builder);
   auto barrierOp = builder->create<gpu::BarrierOp>(op->getLoc());
+  inserted.push_back({barrierOp, hazard});
 }
 
 void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
@@ -111,11 +193,20 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
     // If the current op is an async wait and the next op is not a barrier we
     // insert a barrier op and sync
     builder->setInsertionPointAfter(op);
-    insertBarrier(op, builder);
+    insertBarrier(op, builder, std::nullopt);
     blockInfo->sync();
     return;
   }
 
+  if (auto hazard = transfer(op, blockInfo, funcBlockInfoMap)) {
+    builder->setInsertionPoint(op);
+    insertBarrier(op, builder, hazard);
+  }
+}
+
+std::optional<BlockInfo::Hazard>
+MembarAnalysis::transfer(Operation *op, BlockInfo *blockInfo,
+                         FuncBlockInfoMapT *funcBlockInfoMap) {
   BlockInfo curBlockInfo;
   auto scratchBufferId = Allocation::InvalidBufferId;
   if (isa<triton::CallOp>(op)) {
@@ -153,6 +244,7 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
   // starting from a shared memory write, followed by a series of shared memory
   // read/write operations, and ending with a shared memory read, i.e., shared
   // memory write -> ... -> shared memory read.
+  std::optional<BlockInfo::Hazard> hazard;
   if (scratchBufferId != Allocation::InvalidBufferId) {
     if (!curBlockInfo.syncReadIntervals.empty() ||
         !curBlockInfo.syncWriteIntervals.empty()) {
@@ -162,20 +254,27 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
     }
     auto interval = allocation->getAllocatedInterval(scratchBufferId);
     curBlockInfo.syncWriteIntervals.insert(interval);
-    if (blockInfo->isIntersected(curBlockInfo)) {
-      builder->setInsertionPoint(op);
-      insertBarrier(op, builder);
-    }
+    hazard = blockInfo->getHazard(curBlockInfo);
     // Ops with a scratch buffer internally syncs read/write on shared memory
     blockInfo->sync();
     curBlockInfo.syncReadIntervals.insert(interval);
-  } else if (blockInfo->isIntersected(curBlockInfo)) {
-    builder->setInsertionPoint(op);
-    insertBarrier(op, builder);
+  } else if ((hazard = blockInfo->getHazard(curBlockInfo))) {
     blockInfo->sync();
   }
   // Update the region info, even if barrier is inserted, we have to maintain
   // the current op's read/write buffers.
   blockInfo->join(curBlockInfo);
+  return hazard;
 }
+
+std::string MembarBarrierInfo::getReason() const {
+  if (!hazard)
+    return "barrier after async wait";
+  static const char *kindNames[] = {"RAW", "WAR", "WAW"};
+  return (Twine("barrier for ") + kindNames[hazard->kind] +
+          " hazard on shared memory [" + Twine(hazard->interval.start()) +
+          ", " + Twine(hazard->interval.end()) + ")")
+      .str();
+}
+
 } // namespace mlir
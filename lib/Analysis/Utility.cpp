@@ -573,7 +573,8 @@ bool cvtReordersRegisters(RankedTensorType srcTy, RankedTensorType dstTy) {
       toLinearLayout(dstTy.getShape(), dstTy.getEncoding());
   if (srcLayout.has_value() && dstLayout.has_value()) {
     // comp describes the layout function for converting from src to dst.
-    LinearLayout comp = srcLayout->invertAndCompose(*dstLayout);
+    LinearLayoutCache &cache = getLinearLayoutCache(ctx);
+    LinearLayout comp = cache.invertAndCompose(*srcLayout, *dstLayout);
     StringAttr kLane = StringAttr::get(ctx, "lane");
     StringAttr kWarp = StringAttr::get(ctx, "warp");
     StringAttr kBlock = StringAttr::get(ctx, "block");
@@ -583,13 +584,11 @@ bool cvtReordersRegisters(RankedTensorType srcTy, RankedTensorType dstTy) {
     // stronger than this, checking also that the choice of lane/warp/block does
     // not affect the permutation of registers.  If we allow different
     // lane/warp/blocks to have different permutations, we can generalize this.
-    if (comp.divideRight(LinearLayout::identity1D(comp.getInDimSize(kLane),
-                                                  kLane, kLane) *
-                         LinearLayout::identity1D(comp.getInDimSize(kWarp),
-                                                  kWarp, kWarp) *
-                         LinearLayout::identity1D(comp.getInDimSize(kBlock),
-                                                  kBlock, kBlock))
-            .has_value()) {
+    LinearLayout divisor =
+        LinearLayout::identity1D(comp.getInDimSize(kLane), kLane, kLane) *
+        LinearLayout::identity1D(comp.getInDimSize(kWarp), kWarp, kWarp) *
+        LinearLayout::identity1D(comp.getInDimSize(kBlock), kBlock, kBlock);
+    if (cache.divideRight(comp, divisor).has_value()) {
       return true;
     }
   }
@@ -604,14 +603,14 @@ bool cvtNeedsWarpShuffle(RankedTensorType srcTy, RankedTensorType dstTy) {
       toLinearLayout(dstTy.getShape(), dstTy.getEncoding());
   if (srcLayout.has_value() && dstLayout.has_value()) {
     // comp describes the layout function for converting from src to dst.
-    LinearLayout comp = srcLayout->invertAndCompose(*dstLayout);
+    LinearLayoutCache &cache = getLinearLayoutCache(ctx);
+    LinearLayout comp = cache.invertAndCompose(*srcLayout, *dstLayout);
     StringAttr kWarp = StringAttr::get(ctx, "warp");
     StringAttr kBlock = StringAttr::get(ctx, "block");
-    if (comp.divideRight(LinearLayout::identity1D(comp.getInDimSize(kWarp),
-                                                  kWarp, kWarp) *
-                         LinearLayout::identity1D(comp.getInDimSize(kBlock),
-                                                  kBlock, kBlock))
-            .has_value()) {
+    LinearLayout divisor =
+        LinearLayout::identity1D(comp.getInDimSize(kWarp), kWarp, kWarp) *
+        LinearLayout::identity1D(comp.getInDimSize(kBlock), kBlock, kBlock);
+    if (cache.divideRight(comp, divisor).has_value()) {
       return true;
     }
   }
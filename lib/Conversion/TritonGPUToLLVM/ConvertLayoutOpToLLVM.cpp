@@ -314,12 +314,15 @@ struct ConvertLayoutOpUsingLinearLayoutsConversion
     // because not all destination registers are covered.
     // Since the goal is to cover all of the destination
     // registers, we can instead use `dstLayout . srcLayout^-1`.
-    LinearLayout conversion = dstLayout.invertAndCompose(srcLayout);
-    auto dstToSrc = conversion.divideRight(
+    LinearLayoutCache &cache = getLinearLayoutCache(ctx);
+    LinearLayout conversion = cache.invertAndCompose(dstLayout, srcLayout);
+    auto dstToSrc = cache.divideRight(
+        conversion,
         LinearLayout::identity1D(conversion.getInDimSize(kLane), kLane, kLane) *
-        LinearLayout::identity1D(conversion.getInDimSize(kWarp), kWarp, kWarp) *
-        LinearLayout::identity1D(conversion.getInDimSize(kBlock), kBlock,
-                                 kBlock));
+            LinearLayout::identity1D(conversion.getInDimSize(kWarp), kWarp,
+                                     kWarp) *
+            LinearLayout::identity1D(conversion.getInDimSize(kBlock), kBlock,
+                                     kBlock));
 
     assert(!cvtNeedsSharedMemory(op.getSrc().getType(), op.getType()));
     assert(ArrayRef(to_vector(dstToSrc->getInDimNames())) ==
@@ -355,13 +358,14 @@ struct ConvertLayoutOpUsingLinearLayoutsConversion
   transferWithinBlockOrGroup(ConvertLayoutOp op, const LinearLayout &srcLayout,
                              const LinearLayout &dstLayout, OpAdaptor adaptor,
                              ConversionPatternRewriter &rewriter) const {
-    LinearLayout conversion = srcLayout.invertAndCompose(dstLayout);
+    MLIRContext *ctx = op.getContext();
+    LinearLayoutCache &cache = getLinearLayoutCache(ctx);
+    LinearLayout conversion = cache.invertAndCompose(srcLayout, dstLayout);
 
     // TODO(Keren): LLs support cross-CTA conversions, this function does not
     if (isCrossCTAConversion(conversion))
       return failure();
 
-    MLIRContext *ctx = op.getContext();
     auto loc = op.getLoc();
     auto srcTy = op.getSrc().getType();
     auto dstTy = op.getType();
@@ -476,20 +480,24 @@ struct ConvertLayoutOpUsingLinearLayoutsConversion
     // Input dims: [offset, iteration, block]
     // Output dims: dimN-1, dimN-2, ..., dim0, where N is obtained from repShape
     LinearLayout sharedLayout = chooseShemLayoutForRegToRegConversion(
-        ctx, tensorShape, scratchConfig.repShape, scratchConfig.order);
+        ctx, tensorShape, scratchConfig.repShape, scratchConfig.order,
+        scratchConfig.swizzleVec, scratchConfig.perPhase,
+        scratchConfig.maxPhase);
 
     // Layout for the store from registers to shared memory.
     //
     // Note: If two threads in the same warp write to the same shmem offset, the
     // hardware resolves that without a stall or a bank conflict.  Therefore we
     // don't need to avoid duplicate writes.
-    LinearLayout shmemStoreLayout = srcLayout.invertAndCompose(sharedLayout);
+    LinearLayout shmemStoreLayout =
+        cache.invertAndCompose(srcLayout, sharedLayout);
     const int shmemAllocatedNumElems =
         getNumScratchElements(scratchConfig.paddedRepShape);
     assert(shmemStoreLayout.getOutDimSize(kOffset) <= shmemAllocatedNumElems);
 
     // Layout for the load from shmem to registers.
-    LinearLayout shmemLoadLayout = dstLayout.invertAndCompose(sharedLayout);
+    LinearLayout shmemLoadLayout =
+        cache.invertAndCompose(dstLayout, sharedLayout);
 
     // Check that the `register` fully determines the `iteration`.  That is,
     // each thread does exactly the same reads and writes to shmem on each
@@ -308,7 +308,9 @@ bool emitTransferBetweenRegistersAndShared(
 
   // regToSharedLayout maps from (register, lane, warp, block) to (offsetX1,
   // ..., offsetXN, block), where the offsetX's are in minor-to-major order.
-  LinearLayout regToSharedLayout = regLayout->invertAndCompose(*sharedLayout);
+  LinearLayout regToSharedLayout =
+      triton::gpu::getLinearLayoutCache(ctx).invertAndCompose(*regLayout,
+                                                              *sharedLayout);
 
   // TODO(jlebar): We don't currently support loading from shared memory in a
   // different CTA.  We'd need to emit `mapa.shared::cluster` instructions.
@@ -352,24 +354,83 @@ bool emitTransferBetweenRegistersAndShared(
   auto vecTy = vec_ty(elemLlvmTy, vecElems);
   auto ptrTy = ptr_ty(ctx, /*addressSpace=*/3);
   Value zero = i32_val(0);
-  SmallVector<Value> ret;
+
+  // The multi-dim address is (offsetX1, ..., offsetXN, block), where the
+  // offsets appear in minor-to-major order, and we drop_end to drop block,
+  // which we know from above will be 0.
+  //
+  // As in emitIndices, the address is split in two parts:
+  // L(r, t, w, b) = L(0, t, w, b) xor L(r, 0, 0, 0)
+  // so that the part that depends on the thread is computed once rather than
+  // for every vector, which matters for threads that own large tiles.
+  auto baseShmemOffset =
+      llvm::to_vector(llvm::drop_end(llvm::make_second_range(
+          applyLinearLayout(loc, rewriter, regToSharedLayout,
+                            {{kRegister, zero},
+                             {kLane, laneId},
+                             {kWarp, warpId},
+                             {kBlock, zero}}))));
+  // Reorder strides according to `order`.  This way they match the
+  // multi-dimensional offsets in regToSharedLayout.
+  auto strides = applyPermutation(shmemStrides, sharedOrder);
+
+  // When registers and threads set disjoint bits of each offset, the xor is an
+  // addition, and each vector is at a constant distance from the address of
+  // register 0.
+  SmallVector<int32_t> regBits(rank), threadBits(rank);
+  for (StringAttr inDim : {kRegister, kLane, kWarp}) {
+    auto &bits = inDim == kRegister ? regBits : threadBits;
+    for (int i = 0; i < regToSharedLayout.getInDimSizeLog2(inDim); i++) {
+      auto basis = regToSharedLayout.getBasis(inDim, i);
+      for (int k = 0; k < rank; k++)
+        bits[k] |= basis[k];
+    }
+  }
+  bool disjoint = true;
+  for (int k = 0; k < rank; k++)
+    disjoint &= (regBits[k] & threadBits[k]) == 0;
+  std::optional<SmallVector<int64_t>> constStrides = SmallVector<int64_t>();
+  for (Value stride : strides) {
+    auto constant = stride.getDefiningOp<LLVM::ConstantOp>();
+    if (!constant) {
+      constStrides = std::nullopt;
+      break;
+    }
+    constStrides->push_back(cast<IntegerAttr>(constant.getValue()).getInt());
+  }
+  Value baseAddr;
+  if (disjoint) {
+    auto addr = gep(ptrTy, elemLlvmTy, shmemBase,
+                    dot(rewriter, loc, baseShmemOffset, strides));
+    addr.setInbounds(true);
+    baseAddr = addr;
+  }
+
   for (int i = 0; i < numElems / vecElems; i++) {
-    // Get the address to load/store.  The multi-dim address is (offsetX1, ...,
-    // offsetXN, block), where the offsets appear in minor-to-major order, and
-    // we drop_end to drop block, which we know from above will be 0.
-    auto multiDimShmemOffset =
+    auto regShmemOffset =
         llvm::to_vector(llvm::drop_end(llvm::make_second_range(
-            applyLinearLayout(loc, rewriter, regToSharedLayout,
-                              {{kRegister, i32_val(i * vecElems)},
-                               {kLane, laneId},
-                               {kWarp, warpId},
-                               {kBlock, zero}}))));
-
-    // Reorder strides according to `order`.  This way they match the
-    // multi-dimensional offsets in regToSharedLayout.
-    Value shmemOffset = dot(rewriter, loc, multiDimShmemOffset,
-                            applyPermutation(shmemStrides, sharedOrder));
-    auto vecAddr = gep(ptrTy, elemLlvmTy, shmemBase, shmemOffset);
+            regToSharedLayout.apply({{kRegister, i * vecElems},
+                                     {kLane, 0},
+                                     {kWarp, 0},
+                                     {kBlock, 0}}))));
+    LLVM::GEPOp vecAddr;
+    if (disjoint && constStrides) {
+      int64_t offset = 0;
+      for (int k = 0; k < rank; k++)
+        offset += regShmemOffset[k] * (*constStrides)[k];
+      vecAddr = gep(ptrTy, elemLlvmTy, baseAddr, i32_val(offset));
+    } else if (disjoint) {
+      auto offsets = llvm::to_vector(llvm::map_range(
+          regShmemOffset, [&](int32_t offset) { return i32_val(offset); }));
+      vecAddr = gep(ptrTy, elemLlvmTy, baseAddr,
+                    dot(rewriter, loc, offsets, strides));
+    } else {
+      SmallVector<Value> offsets;
+      for (int k = 0; k < rank; k++)
+        offsets.push_back(xor_(baseShmemOffset[k], i32_val(regShmemOffset[k])));
+      vecAddr = gep(ptrTy, elemLlvmTy, shmemBase,
+                    dot(rewriter, loc, offsets, strides));
+    }
     vecAddr.setInbounds(true);
 
     perVectorCallback(vecTy, vecAddr);
@@ -735,6 +735,12 @@ toLinearLayout(ArrayRef<int64_t> shape, Attribute layout,
   return std::nullopt;
 }
 
+LinearLayoutCache &getLinearLayoutCache(MLIRContext *ctx) {
+  auto *dialect = ctx->getLoadedDialect<TritonGPUDialect>();
+  assert(dialect && "the TritonGPU dialect must be loaded");
+  return dialect->getLinearLayoutCache();
+}
+
 bool isCrossCTAConversion(const LinearLayout &layout) {
   assert(!layout.getInDimNames().empty());
   MLIRContext *ctx = layout.getInDimNames().begin()->getContext();
@@ -756,7 +762,8 @@ bool isCrossCTAConversion(const LinearLayout &layout) {
 
 LinearLayout chooseShemLayoutForRegToRegConversion(
     MLIRContext *ctx, ArrayRef<unsigned> tensorShape,
-    ArrayRef<unsigned> repShape, ArrayRef<unsigned> order) {
+    ArrayRef<unsigned> repShape, ArrayRef<unsigned> order, unsigned swizzleVec,
+    unsigned perPhase, unsigned maxPhase) {
   auto outDimNames = standardOutDimNames(ctx, tensorShape.size());
   LinearLayout layout = LinearLayout::empty();
   SmallVector<StringAttr> kRepDims;
@@ -789,8 +796,37 @@ LinearLayout chooseShemLayoutForRegToRegConversion(
   auto ret = layout.transposeIns(newDims);
   // Reshape layout from [offset0, offset1, ..., rep0, rep1, ...] to
   // [offset, rep, block]
-  return ret.reshapeIns(
+  ret = ret.reshapeIns(
       {{kOffset, totalOffsets}, {kIteration, totalIters}, {kBlock, 1}});
+  if (maxPhase == 1)
+    return ret;
+  // Swizzle the offsets within the buffer; the iterations are left alone.
+  LinearLayout swizzle =
+      getSwizzleLayout(ctx, repShape, order, swizzleVec, perPhase, maxPhase) *
+      LinearLayout::identity1D(totalIters, kIteration, kIteration) *
+      LinearLayout::identity1D(1, kBlock, kBlock);
+  return swizzle.compose(ret);
+}
+
+LinearLayout getSwizzleLayout(MLIRContext *ctx, ArrayRef<unsigned> shape,
+                              ArrayRef<unsigned> order, unsigned vec,
+                              unsigned perPhase, unsigned maxPhase) {
+  assert(llvm::isPowerOf2_32(vec) && llvm::isPowerOf2_32(perPhase) &&
+         llvm::isPowerOf2_32(maxPhase));
+  int numOffsets = product(shape);
+  int numCols = shape.empty() ? 1 : shape[order[0]];
+  int numRows = shape.size() < 2 ? 1 : shape[order[1]];
+  // The phase is linear in the bits of the row, so it is enough to swizzle
+  // each power of two.
+  std::vector<std::vector<int32_t>> bases;
+  for (int offset = 1; offset < numOffsets; offset *= 2) {
+    int row = offset / numCols;
+    int phase = row < numRows ? (row / perPhase) % maxPhase : 0;
+    bases.push_back({offset ^ ((vec * phase) % numCols)});
+  }
+  StringAttr kOffset = S("offset");
+  return LinearLayout({{kOffset, bases}}, {{kOffset, numOffsets}},
+                      /*requireSurjective=*/true);
 }
 
 } // namespace mlir::triton::gpu
@@ -40,6 +40,109 @@ namespace {
 //
 // -----------------------------------------------------------------------------
 
+// Partitions the tensors of a function into the slices that forward
+// propagation connects: a layout set on a value can only reach the values of
+// its slice. Ops other than converts and reshapes free to reorder their
+// elements give their results the layout they already have, so propagating
+// the layouts of a slice without such ops leaves it unchanged. The later runs
+// of the pass thus only revisit the slices that still convert layouts.
+class PropagationSlices {
+public:
+  explicit PropagationSlices(FuncOp funcOp);
+  // Return true if propagation may change the layouts of `value`'s slice.
+  bool mayChange(Value value) { return changingSlices.contains(find(value)); }
+  bool empty() const { return changingSlices.empty(); }
+
+private:
+  Value find(Value value);
+  void join(Value a, Value b);
+
+  // Union-find forest of the values, each slice being represented by its root.
+  DenseMap<Value, Value> parents;
+  DenseSet<Value> changingSlices;
+};
+
+PropagationSlices::PropagationSlices(FuncOp funcOp) {
+  // Join the values the same way LayoutPropagation::propagateToUsers follows
+  // their uses.
+  SmallVector<Value> changingValues;
+  funcOp.walk([&](Operation *op) {
+    if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      for (auto [init, arg, result] :
+           llvm::zip(forOp.getInitArgs(), forOp.getRegionIterArgs(),
+                     forOp.getResults())) {
+        join(init, arg);
+        join(init, result);
+      }
+    } else if (auto whileOp = dyn_cast<scf::WhileOp>(op)) {
+      for (auto [init, arg] :
+           llvm::zip(whileOp.getInits(), whileOp.getBeforeArguments()))
+        join(init, arg);
+    } else if (auto yieldOp = dyn_cast<scf::YieldOp>(op)) {
+      Operation *parent = yieldOp->getParentOp();
+      if (!isa<scf::ForOp, scf::IfOp, scf::WhileOp>(parent))
+        return;
+      for (OpOperand &operand : yieldOp->getOpOperands()) {
+        unsigned i = operand.getOperandNumber();
+        if (i < parent->getNumResults())
+          join(operand.get(), parent->getResult(i));
+        if (auto forOp = dyn_cast<scf::ForOp>(parent))
+          join(operand.get(), forOp.getRegionIterArg(i));
+        if (auto whileOp = dyn_cast<scf::WhileOp>(parent))
+          join(operand.get(), whileOp.getBeforeArguments()[i]);
+      }
+    } else if (auto conditionOp = dyn_cast<scf::ConditionOp>(op)) {
+      auto whileOp = cast<scf::WhileOp>(conditionOp->getParentOp());
+      for (auto [arg, afterArg, result] :
+           llvm::zip(conditionOp.getArgs(), whileOp.getAfterArguments(),
+                     whileOp.getResults())) {
+        join(arg, afterArg);
+        join(arg, result);
+      }
+    } else if (isa<nvidia_gpu::WarpGroupDotWaitOp>(op)) {
+      for (auto [operand, result] :
+           llvm::zip(op->getOperands(), op->getResults()))
+        join(operand, result);
+    } else if (op->hasTrait<OpTrait::SameOperandsAndResultEncoding>() ||
+               op->hasTrait<OpTrait::Elementwise>() ||
+               isa<ReduceOp, ExpandDimsOp, ReshapeOp, TransOp, JoinOp, SplitOp,
+                   ConvertLayoutOp>(op)) {
+      for (Value operand : op->getOperands())
+        for (Value result : op->getResults())
+          join(operand, result);
+      auto reshape = dyn_cast<ReshapeOp>(op);
+      if (isa<ConvertLayoutOp>(op) || (reshape && reshape.getAllowReorder()))
+        changingValues.push_back(op->getResult(0));
+    }
+  });
+  for (Value value : changingValues)
+    changingSlices.insert(find(value));
+}
+
+Value PropagationSlices::find(Value value) {
+  Value root = value;
+  for (auto it = parents.find(root); it != parents.end();
+       it = parents.find(root))
+    root = it->second;
+  // Point the values on the path directly to the root.
+  while (value != root) {
+    Value &parent = parents[value];
+    value = parent;
+    parent = root;
+  }
+  return root;
+}
+
+void PropagationSlices::join(Value a, Value b) {
+  if (!isa<RankedTensorType>(a.getType()) ||
+      !isa<RankedTensorType>(b.getType()))
+    return;
+  Value rootA = find(a);
+  Value rootB = find(b);
+  if (rootA != rootB)
+    parents[rootA] = rootB;
+}
+
 // The current algorithm works by analyzing the IR and doing a one-shot rewrite
 // based on the analysis. The algorithm is as follows.
 //
@@ -48,7 +151,8 @@ namespace {
 //
 // 2. For each anchor, propagate its layout to all its descendants.
 //    An op can have multiple ancestors that are anchors, so at this stage an op
-//    may have multiple layouts associated with it.
+//    may have multiple layouts associated with it. Anchors whose slice cannot
+//    change (see PropagationSlices) are skipped.
 //
 // 3. Resolve conflicts by deciding which of the multiple layouts the op should
 //    keep, inserting convert-layout ops to resolve conflicts.  After this
@@ -66,7 +170,11 @@ public:
     LayoutInfo() {}
     llvm::SmallSetVector<Attribute, 8> encodings;
   };
-  LayoutPropagation(FuncOp F) : funcOp(F) {}
+  LayoutPropagation(FuncOp F) : funcOp(F), slices(F) {}
+  // Return true if propagation may change the layouts of the function.
+  bool hasLayoutsToPropagate() const { return !slices.empty(); }
+  // Return the number of anchors skipped by initAnchorLayout.
+  int64_t getNumSkippedAnchors() const { return numSkippedAnchors; }
   // Find the anchor ops and set their layout in the data structure.
   void initAnchorLayout();
   // Recursively Propagate the layout to all the users of the anchor ops until
@@ -111,6 +219,8 @@ private:
   DenseMap<std::pair<Value, Attribute>, Value> rewriteMapping;
   SetVector<Operation *> opToDelete;
   FuncOp funcOp;
+  PropagationSlices slices;
+  int64_t numSkippedAnchors = 0;
 };
 
 class LayoutRematerialization {
@@ -264,6 +374,10 @@ bool isLayoutAnchor(Operation *op) {
 void LayoutPropagation::initAnchorLayout() {
   auto maybeAddAnchor = [&](Value v) {
     if (auto tensorType = dyn_cast<RankedTensorType>(v.getType())) {
+      if (!slices.mayChange(v)) {
+        ++numSkippedAnchors;
+        return;
+      }
       // Workaround, don't popagate MMA layout unless there is a convert
       // back to mma further down to avoid generating reduction with MMA
       // layout that may have lower performance.
@@ -1186,17 +1300,17 @@ void LayoutRematerialization::hoistConvertOnTopOfExtOrBroadcast(
   rewriteSlice(slice, layout, convertOp, mapping);
 }
 
-void backwardRematerialization(ModuleOp module) {
-  module.walk([](FuncOp funcOp) {
+void backwardRematerialization(Operation *op) {
+  op->walk([](FuncOp funcOp) {
     LayoutRematerialization layoutRemat(funcOp);
     layoutRemat.backwardRematerialization();
     layoutRemat.cleanup();
   });
 }
 
-void hoistConvert(ModuleOp module) {
+void hoistConvert(Operation *op) {
   SmallVector<ConvertLayoutOp> convertOps;
-  module.walk([](FuncOp funcOp) {
+  op->walk([](FuncOp funcOp) {
     LayoutRematerialization layoutRemat(funcOp);
     layoutRemat.hoistConvertOnTopOfExtOrBroadcast();
     layoutRemat.cleanup();
@@ -1210,12 +1324,20 @@ class TritonGPURemoveLayoutConversionsPass
 public:
   void runOnOperation() override {
     MLIRContext *context = &getContext();
-    ModuleOp m = getOperation();
+    // A module, or a function when the pass is nested
+    Operation *m = getOperation();
 
     // 1. Propagate layout forward starting from "anchor" ops.
-    m.walk([](FuncOp funcOp) {
+    m->walk([&](FuncOp funcOp) {
       LayoutPropagation layoutPropagation(funcOp);
+      if (!layoutPropagation.hasLayoutsToPropagate()) {
+        LDBG("Skipping layout propagation of " << funcOp.getName());
+        ++numSkippedFuncs;
+        return;
+      }
+      ++numPropagatedFuncs;
       layoutPropagation.initAnchorLayout();
+      numSkippedAnchors += layoutPropagation.getNumSkippedAnchors();
       layoutPropagation.propagateLayout();
       layoutPropagation.resolveConflicts();
       layoutPropagation.rewrite();
@@ -1223,7 +1345,7 @@ public:
 
     LLVM_DEBUG({
       DBGS() << "Module after propagating layouts forward:\n";
-      m.dump();
+      m->dump();
     });
 
     RewritePatternSet cleanUpPatterns(context);
@@ -1234,7 +1356,7 @@ public:
 
     LLVM_DEBUG({
       DBGS() << "Module after canonicalizing:\n";
-      m.dump();
+      m->dump();
     });
 
     // 2. For remaining convert ops, try to rematerialize the slice of producer
@@ -1242,7 +1364,7 @@ public:
     backwardRematerialization(m);
     LLVM_DEBUG({
       DBGS() << "Module after backward remat:\n";
-      m.dump();
+      m->dump();
     });
 
     // 3. For remaining converts, try to hoist them above cast generating larger
@@ -1250,7 +1372,7 @@ public:
     hoistConvert(m);
     LLVM_DEBUG({
       DBGS() << "Module after hoisting converts:\n";
-      m.dump();
+      m->dump();
     });
 
     // 4. Apply clean up patterns to remove remove dead convert and dead code
@@ -1265,7 +1387,7 @@ public:
     }
     LLVM_DEBUG({
       DBGS() << "Module after final cleanups:\n";
-      m.dump();
+      m->dump();
     });
   }
 };
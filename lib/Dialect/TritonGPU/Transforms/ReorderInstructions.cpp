@@ -59,11 +59,11 @@ public:
   }
 
   void runOnOperation() override {
-    ModuleOp m = getOperation();
+    Operation *m = getOperation();
     mlir::DominanceInfo dom(m);
     // sink conversion after the last dealloc
     // before the first use ancestor in its block
-    m.walk([&](triton::gpu::ConvertLayoutOp op) {
+    m->walk([&](triton::gpu::ConvertLayoutOp op) {
       auto curr = mlir::Block::iterator(op);
       for (; &*curr != getFirstUse(op); curr++)
         if (isa<triton::gpu::LocalDeallocOp>(&*curr))
@@ -75,7 +75,7 @@ public:
     auto moveAfter = [](Operation *lhs, Operation *rhs) {
       lhs->moveAfter(rhs);
     };
-    m.walk([&](Operation *op) {
+    m->walk([&](Operation *op) {
       if (!willIncreaseRegisterPressure(op))
         return;
       auto user_begin = op->user_begin();
@@ -90,7 +90,7 @@ public:
     for (auto &kv : opToMove)
       kv.first->moveBefore(kv.second);
     // Move alloc(load) immediately after dependent load
-    m.walk([&](triton::gpu::LocalAllocOp op) {
+    m->walk([&](triton::gpu::LocalAllocOp op) {
       if (!op.getSrc())
         return;
       Operation *argOp = op.getSrc().getDefiningOp();
@@ -100,7 +100,7 @@ public:
     });
     // Move transpositions just after their definition
     opToMove.clear();
-    m.walk([&](triton::TransOp op) {
+    m->walk([&](triton::TransOp op) {
       Operation *argOp = op.getSrc().getDefiningOp();
       if (!argOp)
         return;
@@ -108,7 +108,7 @@ public:
     });
     // Move `dot` operand so that conversions to opIdx=1 happens after
     // conversions to opIdx=0
-    m.walk([&](triton::gpu::LocalLoadOp op) {
+    m->walk([&](triton::gpu::LocalLoadOp op) {
       auto dstEncoding = mlir::dyn_cast<triton::gpu::DotOperandEncodingAttr>(
           op.getType().getEncoding());
       if (!dstEncoding)
@@ -0,0 +1,98 @@
+#include "triton/Tools/BitMatrix.h"
+
+#include <utility>
+
+namespace mlir::triton {
+
+BitMatrix BitMatrix::identity(int size) {
+  BitMatrix ret(size, size);
+  for (int c = 0; c < size; c++)
+    ret.columns[c] = 1ULL << c;
+  return ret;
+}
+
+BitMatrix BitMatrix::operator*(const BitMatrix &rhs) const {
+  assert(numCols == rhs.numRows && "Incompatible matrix sizes");
+  BitMatrix ret(numRows, rhs.numCols);
+  for (int c = 0; c < rhs.numCols; c++)
+    ret.columns[c] = apply(rhs.columns[c]);
+  return ret;
+}
+
+BitMatrix BitMatrix::transpose() const {
+  BitMatrix ret(numCols, numRows);
+  for (int c = 0; c < numCols; c++) {
+    for (uint64_t col = columns[c]; col != 0; col &= col - 1)
+      ret.columns[__builtin_ctzll(col)] |= 1ULL << c;
+  }
+  return ret;
+}
+
+int BitMatrix::rank() const { return __builtin_popcountll(getPivotColumns()); }
+
+uint64_t BitMatrix::getPivotColumns() const {
+  // reduced[r] is either 0 or a combination of the columns seen so far whose
+  // lowest set bit is r.  A column is in the span of the previous ones iff it
+  // reduces to 0.
+  std::array<uint64_t, kMaxSize> reduced{};
+  uint64_t pivots = 0;
+  for (int c = 0; c < numCols; c++) {
+    uint64_t col = columns[c];
+    while (col != 0) {
+      int r = __builtin_ctzll(col);
+      if (reduced[r] == 0) {
+        reduced[r] = col;
+        pivots |= 1ULL << c;
+        break;
+      }
+      col ^= reduced[r];
+    }
+  }
+  return pivots;
+}
+
+std::optional<BitMatrix> BitMatrix::inverse() const {
+  assert(numRows == numCols && "Only square matrices can be inverted");
+  // Gauss-Jordan elimination on the columns: the column operations that
+  // reduce `m` to the identity turn the identity into the inverse.
+  BitMatrix m = *this;
+  BitMatrix inv = identity(numCols);
+  for (int r = 0; r < numRows; r++) {
+    int pivot = r;
+    while (pivot < numCols && ((m.columns[pivot] >> r) & 1) == 0)
+      pivot++;
+    if (pivot == numCols)
+      return std::nullopt;
+    std::swap(m.columns[r], m.columns[pivot]);
+    std::swap(inv.columns[r], inv.columns[pivot]);
+    for (int c = 0; c < numCols; c++) {
+      if (c != r && ((m.columns[c] >> r) & 1)) {
+        m.columns[c] ^= m.columns[r];
+        inv.columns[c] ^= inv.columns[r];
+      }
+    }
+  }
+  return inv;
+}
+
+bool BitMatrix::operator==(const BitMatrix &other) const {
+  if (numRows != other.numRows || numCols != other.numCols)
+    return false;
+  for (int c = 0; c < numCols; c++) {
+    if (columns[c] != other.columns[c])
+      return false;
+  }
+  return true;
+}
+
+std::string BitMatrix::toString() const {
+  std::string ret;
+  for (int r = 0; r < numRows; r++) {
+    for (int c = 0; c < numCols; c++)
+      ret += get(r, c) ? '1' : '0';
+    ret += '\n';
+  }
+  return ret;
+}
+
+} // namespace mlir::triton
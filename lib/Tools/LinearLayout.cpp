@@ -1,11 +1,11 @@
 #include "triton/Tools/LinearLayout.h"
 
 #include <cstdint>
-#include <set>
 #include <vector>
 
 #include "mlir/IR/BuiltinAttributes.h"
 #include "third_party/f2reduce/f2reduce.h"
+#include "triton/Tools/BitMatrix.h"
 #include "triton/Tools/StrUtil.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetOperations.h"
@@ -32,113 +32,85 @@ BasesT makeBasesMap(
   return ret;
 }
 
-// Dump the matrix to stderr in a human-readable format for debugging.
-void dumpMatrix(uint64_t *m, int numRows, int numCols) {
-  assert(numCols <= 64);
-  for (int r = 0; r < numRows; r++) {
-    llvm::errs() << "0b";
-    for (int c = 0; c < numCols; c++) {
-      llvm::errs() << ((m[r] & (1 << c)) != 0 ? "1" : "0");
-    }
-    llvm::errs() << "\n";
-  }
-}
-
-// Build a matrix of size sum(outDimSizeLog2) x sum(inDimSizeLog2) representing
-// the bases of the given layout.  This can then be used by f2reduce.
+// Build the matrix of `layout`, with one column per basis and one row per bit
+// of the out-dims, i.e. a matrix of size sum(outDimSizeLog2) x
+// sum(inDimSizeLog2).  The rows follow `outDims`, a list of (out-dim,
+// sizeLog2) that must include the out-dims of `layout`.  The bases must fit in
+// the given sizes.
+//
+// Suppose we have a layout specified by the following values.
+//
+//   L(0,1) = (0b01, 0b1)
+//   L(0,2) = (0b10, 0b0)
+//   L(1,0) = (0b10, 0b0)
+//   L(2,0) = (0b11, 0b0)
+//
+// We will create one column per entry above.  The max bit width of the
+// codomain is (2,1), so our matrix will have 2+1=3 rows.  The final matrix
+// will be
+//
+//  | L(0,1)[0] L(0,2)[0] L(1,0)[0] L(2,0)[0] |   | 0b1001 |
+//  |    ↓         ↓         ↓         ↓      |   | 0b0111 |
+//  | L(0,1)[1] L(0,2)[1] L(1,0)[1] L(2,0)[1] | = | 0b1000 |
+//  |    ↓         ↓         ↓         ↓      |
 //
 // This function is called from the constructor of LinearLayout, so be careful
 // not to use any functions that create LLs in here.
-std::unique_ptr<uint64_t[]> getMatrix(const LinearLayout &layout) {
-  int numRows = layout.getTotalOutDimSizeLog2();
-  int numCols = layout.getTotalInDimSizeLog2();
+BitMatrix
+getBitMatrix(const LinearLayout &layout,
+             ArrayRef<std::pair<StringAttr, int32_t /*sizeLog2*/>> outDims) {
+  // Row of the first bit of each out-dim of `layout`, in its order.
+  SmallVector<int> rowOffsets(layout.getNumOutDims(), -1);
+  int numRows = 0;
+  for (auto [outDim, sizeLog2] : outDims) {
+    if (layout.hasOutDim(outDim))
+      rowOffsets[layout.getOutDimIndex(outDim)] = numRows;
+    numRows += sizeLog2;
+  }
+  assert(llvm::all_of(rowOffsets, [](int offset) { return offset >= 0; }));
 
   // Don't handle giant LLs.  This makes some things easier; for example, each
-  // row can be a single uint64_t.
-  assert(numCols <= 64 && "LinearLayout too large");
-  assert(numRows <= 64 && "LinearLayout too large");
-
-  // Suppose we have a layout specified by the following values.
-  //
-  //   L(0,1) = (0b01, 0b1)
-  //   L(0,2) = (0b10, 0b0)
-  //   L(1,0) = (0b10, 0b0)
-  //   L(2,0) = (0b11, 0b0)
-  //
-  // We will create one column per entry above.  The max bit width of the
-  // codomain is (2,1), so our matrix will have 2+1=3 rows.  The final matrix
-  // will be
-  //
-  //  | L(0,1)[0] L(0,2)[0] L(1,0)[0] L(2,0)[0] |   | 0b1001 |
-  //  |    ↓         ↓         ↓         ↓      |   | 0b0111 |
-  //  | L(0,1)[1] L(0,2)[1] L(1,0)[1] L(2,0)[1] | = | 0b1000 |
-  //  |    ↓         ↓         ↓         ↓      |
-  //
-  // Note `new uint64_t[n]()` is zero-initialized, but `new uint64_t[n]` is not.
-  std::unique_ptr<uint64_t[]> m(new uint64_t[numRows]());
-  int r = 0;
-  for (StringAttr outDim : layout.getOutDimNames()) {
-    int c = 0;
-    for (StringAttr inDim : layout.getInDimNames()) {
-      for (int i = 0; i < layout.getInDimSizeLog2(inDim); i++) {
-        uint64_t basis = layout.getBasis(inDim, i, outDim);
-        for (int j = 0; j < layout.getOutDimSizeLog2(outDim); j++) {
-          m[r + j] |= ((basis >> j) & 1) << c;
-        }
-        c++;
+  // column can be a single uint64_t.
+  BitMatrix m(numRows, layout.getTotalInDimSizeLog2());
+  int c = 0;
+  for (const auto &[inDim, inDimBases] : layout.getBases()) {
+    for (const auto &basis : inDimBases) {
+      uint64_t column = 0;
+      for (auto [offset, b] : llvm::zip(rowOffsets, basis)) {
+        column |= uint64_t(b) << offset;
       }
+      m.setColumn(c++, column);
     }
-    r += layout.getOutDimSizeLog2(outDim);
   }
-
   return m;
 }
 
+BitMatrix getBitMatrix(const LinearLayout &layout) {
+  SmallVector<std::pair<StringAttr, int32_t>> outDims;
+  for (StringAttr outDim : layout.getOutDimNames()) {
+    outDims.push_back({outDim, layout.getOutDimSizeLog2(outDim)});
+  }
+  return getBitMatrix(layout, outDims);
+}
+
 // Get a matrix for `layout` with its codomain expanded so it's injective, i.e.
 // each input element maps to a unique output element.  We do this by finding
 // columns that are equal to 0 and adding a new row with a 1 in that column.
-std::tuple<std::unique_ptr<uint64_t[]>, int /*numRows*/, int /*numCols*/>
-getInjectiveMat(const LinearLayout &layout) {
-  int numRows = layout.getTotalOutDimSizeLog2();
-  int numCols = layout.getTotalInDimSizeLog2();
-  std::unique_ptr<uint64_t[]> mat = getMatrix(layout);
-
-  // Bits of mat or-reduced along the columns (so there's just one row).
-  uint64_t colBits = 0;
-  for (int r = 0; r < numRows; r++) {
-    colBits |= mat[r];
-  }
-  auto expanded = std::unique_ptr<uint64_t[]>(new uint64_t[numRows + numCols]);
-  std::memcpy(expanded.get(), mat.get(), numRows * sizeof(uint64_t));
-  for (int c = 0; c < numCols; c++) {
-    if ((colBits & (1 << c)) == 0) {
-      expanded[numRows++] = (1 << c);
+BitMatrix getInjectiveMat(const LinearLayout &layout) {
+  BitMatrix mat = getBitMatrix(layout);
+  int numRows = mat.getNumRows();
+  for (int c = 0; c < mat.getNumCols(); c++) {
+    if (mat.getColumn(c) == 0) {
+      numRows++;
     }
   }
-  return std::make_tuple(std::move(expanded), numRows, numCols);
-}
-
-// Compute the rank of the matrix formed by taking the bases for the given
-// outDim as columns.  In other words, finds the number of linearly-independent
-// bases for this output dimension.
-int getMatrixRank(std::unique_ptr<uint64_t[]> m, int numRows, int numCols) {
-  // f2reduce underflows if the number of cols is 0, return the rank early in
-  // this case.
-  if (numCols == 0) {
-    return 0;
-  }
-  // stride is specified in number of 64-bit words per row, and we pack our
-  // matrix so that there's only one uint64_t per row.
-  assert(numCols <= 64);
-  f2reduce::inplace_rref_strided(m.get(), numRows, numCols, /*stride=*/1);
-
-  // The rank of the reduced matrix is simply the number of nonzero rows.
-  int rank = 0;
-  for (int i = 0; i < numRows; i++) {
-    if (m[i] != 0)
-      rank++;
-  }
-  return rank;
+  BitMatrix expanded(numRows, mat.getNumCols());
+  int r = mat.getNumRows();
+  for (int c = 0; c < mat.getNumCols(); c++) {
+    uint64_t column = mat.getColumn(c);
+    expanded.setColumn(c, column != 0 ? column : 1ULL << r++);
+  }
+  return expanded;
 }
 
 template <typename T, typename U>
@@ -345,10 +317,7 @@ LinearLayout::checkInvariants(bool requireSurjective) {
   // the rank of our matrix using Gaussian elimination, which runs in O(n^3)
   // for an n x n matrix.  Our matrix size is sum(inDimSizeLog2) x
   // sum(outDimSizeLog2), so this should be plenty fast.
-  this->surjective =
-      getMatrixRank(getMatrix(*this), /*numRows=*/getTotalOutDimSizeLog2(),
-                    /*numCols=*/getTotalInDimSizeLog2()) ==
-      getTotalOutDimSizeLog2();
+  this->surjective = getBitMatrix(*this).rank() == getTotalOutDimSizeLog2();
 
   if (requireSurjective && !surjective) {
     return "Layout is expected to be surjective, i.e. every `out` coordinate "
@@ -860,15 +829,20 @@ SmallVector<std::pair<StringAttr, int32_t>>
 LinearLayout::apply(ArrayRef<std::pair<StringAttr, int32_t>> ins) const {
   assertDimsEqualIgnoringOrder(llvm::make_first_range(ins), getInDimNames());
 
-  SmallVector<std::pair<StringAttr, int32_t>> ret;
-  for (StringAttr outDim : getOutDimNames()) {
-    int32_t outVal = 0;
-    for (auto &[inDim, val] : ins) {
-      for (int i = 0; i < getInDimSizeLog2(inDim); i++) {
-        if (val & (1 << i))
-          outVal ^= getBasis(inDim, i, outDim);
+  // XOR the bases selected by the bits of the inputs, all the out-dims at once.
+  SmallVector<int32_t> outVals(getNumOutDims(), 0);
+  for (auto &[inDim, val] : ins) {
+    const auto &inDimBases = bases.find(inDim)->second;
+    for (int i = 0; i < inDimBases.size(); i++) {
+      if (val & (1 << i)) {
+        for (auto [outVal, b] : llvm::zip(outVals, inDimBases[i]))
+          outVal ^= b;
       }
     }
+  }
+
+  SmallVector<std::pair<StringAttr, int32_t>> ret;
+  for (auto [outDim, outVal] : llvm::zip(getOutDimNames(), outVals)) {
     ret.push_back({outDim, outVal});
   }
   return ret;
@@ -880,18 +854,31 @@ LinearLayout LinearLayout::compose(const LinearLayout &outer) const {
     assert(getOutDimSize(outDim) <= outer.getInDimSize(outDim));
   }
 
+  // The composition is the product of the matrices of the two layouts, where
+  // the rows of `this` follow the in-dims of `outer`.
+  SmallVector<std::pair<StringAttr, int32_t>> outerInDims;
+  for (StringAttr inDim : outer.getInDimNames()) {
+    outerInDims.push_back({inDim, outer.getInDimSizeLog2(inDim)});
+  }
+  BitMatrix product = getBitMatrix(outer) * getBitMatrix(*this, outerInDims);
+
+  // Read off the new bases from the columns of the product.
+  SmallVector<std::pair<int /*row*/, int32_t /*mask*/>> outerOutDims;
+  int r = 0;
+  for (StringAttr outDim : outer.getOutDimNames()) {
+    outerOutDims.push_back({r, outer.getOutDimSize(outDim) - 1});
+    r += outer.getOutDimSizeLog2(outDim);
+  }
   BasesT newBases;
+  int c = 0;
   for (const auto &[inDim, inDimBases] : bases) {
     auto &newInDimBases = newBases[inDim];
-    for (const auto &basis : inDimBases) {
-      SmallVector<std::pair<StringAttr, int32_t>> bases;
-      for (auto [outDim, b] : llvm::zip(getOutDimNames(), basis)) {
-        bases.push_back({outDim, b});
+    for (int i = 0; i < inDimBases.size(); i++, c++) {
+      uint64_t column = product.getColumn(c);
+      auto &newBasis = newInDimBases.emplace_back();
+      for (auto [row, mask] : outerOutDims) {
+        newBasis.push_back((column >> row) & mask);
       }
-      auto newBases = outer.apply(bases);
-      auto newBasesRange = llvm::make_second_range(newBases);
-      newInDimBases.push_back(
-          std::vector<int32_t>(newBasesRange.begin(), newBasesRange.end()));
     }
   }
 
@@ -948,59 +935,82 @@ LinearLayout LinearLayout::invertAndCompose(const LinearLayout &outer) const {
   //
   // Thus making A and B injective encodes our desire not to cross blocks,
   // or more generally our desire that C(x) != 0 where possible.
-  auto [matThis, numRowsThis, numColsThis] = getInjectiveMat(*this);
-  auto [matOuter, numRowsOuter, numColsOuter] = getInjectiveMat(
+  BitMatrix matThis = getInjectiveMat(*this);
+  BitMatrix matOuter = getInjectiveMat(
       outer.transposeOuts(llvm::to_vector(this->getOutDimNames())));
-
-  // Concatenate `matOuter` and `matThis` horizontally (i.e. `matThis`
-  // is to the right of `matOuter`).
-  int combinedNumRows = std::max(numRowsThis, numRowsOuter);
-  int combinedNumCols = numColsThis + numColsOuter;
-  assert(combinedNumCols <= 64 && "Can't handle huge layouts");
-
-  std::unique_ptr<uint64_t[]> m(new uint64_t[combinedNumRows]());
-  for (int r = 0; r < numRowsOuter; r++) {
-    m[r] = matOuter[r];
-  }
-  for (int r = 0; r < numRowsThis; r++) {
-    m[r] |= matThis[r] << numColsOuter;
-  }
-
-  // Perform Gaussian elimination on `m`.  Because `outer` was modified to
-  // be bijective, the first half of the matrix should be the identity
-  // matrix.  The remaining half are the bases for the combined
-  // transformation.
-  //
-  // `stride` is specified in number of 64-bit words per row, and we pack
-  // our matrix so that there's only one uint64_t per row.
-  f2reduce::inplace_rref_strided(m.get(), combinedNumRows, combinedNumCols,
-                                 /*stride=*/1);
-
-  // Check that the first half of the matrix is indeed the identity.
-  for (int r = 0; r < std::min(numRowsOuter, numColsOuter); r++) {
-    for (int c = 0; c < std::min(numColsOuter, numRowsOuter); c++) {
-      if (((m[r] >> c) & 1) != (r == c ? 1 : 0)) {
-        llvm::report_fatal_error("First half of the matrix was not the "
-                                 "identity, bug in invertAndCompose");
-      }
-    }
-  }
+  int numRowsThis = matThis.getNumRows();
+  int numColsThis = matThis.getNumCols();
+  int numRowsOuter = matOuter.getNumRows();
+  int numColsOuter = matOuter.getNumCols();
 
   // We need names for the in/out dim of the flattened layout we're going to
-  // read off from `m`.  These could be anything, doesn't matter.
+  // read off.  These could be anything, doesn't matter.
   StringAttr inDim1D = *getInDimNames().begin();
   StringAttr outDim1D = *getOutDimNames().begin();
 
-  // Read off the new bases.  These are for a flattened 1D -> 1D
-  // transformation from `this`'s in-dims to `outer`'s in-dims.
+  // The new bases are for a flattened 1D -> 1D transformation from `this`'s
+  // in-dims to `outer`'s in-dims.
   BasesT newBases;
   auto &bs = newBases[inDim1D];
-  for (int c = 0; c < numColsThis; c++) {
-    int32_t basis = 0;
+
+  if (numRowsOuter == numColsOuter && numRowsThis <= numRowsOuter) {
+    // Common case: the injective `outer` is a bijection, so the bases are the
+    // columns of outer^-1 * this.  This is what the Gaussian elimination below
+    // computes, without going through the rows of the matrices.
+    std::optional<BitMatrix> inverse = matOuter.inverse();
+    if (!inverse) {
+      llvm::report_fatal_error("Injective outer layout is not invertible, "
+                               "bug in invertAndCompose");
+    }
+    for (int c = 0; c < numColsThis; c++) {
+      bs.push_back({int32_t(inverse->apply(matThis.getColumn(c)))});
+    }
+  } else {
+    BitMatrix rowsThis = matThis.transpose();
+    BitMatrix rowsOuter = matOuter.transpose();
+
+    // Concatenate `matOuter` and `matThis` horizontally (i.e. `matThis`
+    // is to the right of `matOuter`).
+    int combinedNumRows = std::max(numRowsThis, numRowsOuter);
+    int combinedNumCols = numColsThis + numColsOuter;
+    assert(combinedNumCols <= 64 && "Can't handle huge layouts");
+
+    std::unique_ptr<uint64_t[]> m(new uint64_t[combinedNumRows]());
     for (int r = 0; r < numRowsOuter; r++) {
-      basis |= (m[r] >> (numColsOuter + c) & 1) << r;
+      m[r] = rowsOuter.getColumn(r);
+    }
+    for (int r = 0; r < numRowsThis; r++) {
+      m[r] |= rowsThis.getColumn(r) << numColsOuter;
+    }
+
+    // Perform Gaussian elimination on `m`.  Because `outer` was modified to
+    // be injective, the first half of the matrix should be the identity
+    // matrix.  The remaining half are the bases for the combined
+    // transformation.
+    //
+    // `stride` is specified in number of 64-bit words per row, and we pack
+    // our matrix so that there's only one uint64_t per row.
+    f2reduce::inplace_rref_strided(m.get(), combinedNumRows, combinedNumCols,
+                                   /*stride=*/1);
+
+    // Check that the first half of the matrix is indeed the identity.
+    for (int r = 0; r < std::min(numRowsOuter, numColsOuter); r++) {
+      for (int c = 0; c < std::min(numColsOuter, numRowsOuter); c++) {
+        if (((m[r] >> c) & 1) != (r == c ? 1 : 0)) {
+          llvm::report_fatal_error("First half of the matrix was not the "
+                                   "identity, bug in invertAndCompose");
+        }
+      }
+    }
+
+    // Read off the new bases.
+    for (int c = 0; c < numColsThis; c++) {
+      int32_t basis = 0;
+      for (int r = 0; r < numRowsOuter; r++) {
+        basis |= (m[r] >> (numColsOuter + c) & 1) << r;
+      }
+      bs.push_back({basis});
     }
-    bs.push_back({basis});
   }
 
   LinearLayout flatComposed(std::move(newBases),
@@ -1020,31 +1030,16 @@ LinearLayout LinearLayout::invertAndCompose(const LinearLayout &outer) const {
 
 llvm::MapVector<StringAttr, int32_t>
 LinearLayout::getFreeVariableMasks() const {
-  std::unique_ptr<uint64_t[]> mat = getMatrix(*this);
-  int numRows = getTotalOutDimSizeLog2();
-  int numCols = getTotalInDimSizeLog2();
-
-  // stride is specified in number of 64-bit words per row, and we pack our
-  // matrix so that there's only one uint64_t per row.
-  assert(numCols <= 64);
-  f2reduce::inplace_rref_strided(mat.get(), numRows, numCols, /*stride=*/1);
-
-  // For each row in the RREF matrix, identify the column with the first "1".
-  // These columns correspond to the basic (i.e. non-free) variables.
-  std::set<int32_t> basicVars;
-  for (int r = 0; r < numRows; r++) {
-    if (mat[r] == 0) {
-      continue;
-    }
-    basicVars.insert(__builtin_ctzll(mat[r]));
-  }
+  // The basic (i.e. non-free) variables are the pivot columns of the RREF of
+  // the matrix, i.e. the bases that are not in the span of the previous ones.
+  uint64_t basicVars = getBitMatrix(*this).getPivotColumns();
 
   llvm::MapVector<StringAttr, int32_t> ret;
   int c = 0;
   for (StringAttr dim : getInDimNames()) {
     int32_t mask = 0;
     for (int i = 0; i < getInDimSizeLog2(dim); i++, c++) {
-      if (basicVars.count(c) == 0) {
+      if (((basicVars >> c) & 1) == 0) {
         mask |= (1 << i);
       }
     }
@@ -1053,7 +1048,7 @@ LinearLayout::getFreeVariableMasks() const {
   return ret;
 }
 
-bool operator==(LinearLayout lhs, LinearLayout rhs) {
+bool operator==(const LinearLayout &lhs, const LinearLayout &rhs) {
   if (!lhs.equalIgnoringOutDimSizes(rhs))
     return false;
 
@@ -1080,6 +1075,19 @@ bool LinearLayout::equalIgnoringOutDimSizes(const LinearLayout &other) const {
   return true;
 }
 
+llvm::hash_code hash_value(const LinearLayout &layout) {
+  llvm::hash_code hash = llvm::hash_value(layout.bases.size());
+  for (const auto &[inDim, inDimBases] : layout.bases) {
+    hash = llvm::hash_combine(hash, inDim);
+    for (const auto &basis : inDimBases)
+      hash = llvm::hash_combine(
+          hash, llvm::hash_combine_range(basis.begin(), basis.end()));
+  }
+  for (const auto &[outDim, size] : layout.outDims)
+    hash = llvm::hash_combine(hash, outDim, size);
+  return hash;
+}
+
 std::string LinearLayout::toString() const {
   // Start with a newline because we print out a bulleted list; it doesn't
   // make sense for the first line of this list to be on the same line as
@@ -0,0 +1,79 @@
+#include "triton/Tools/LinearLayoutCache.h"
+
+#include <mutex>
+
+namespace mlir::triton {
+
+template <typename ComputeFn>
+std::optional<LinearLayout>
+LinearLayoutCache::getOrCompute(Op op, const LinearLayout &lhs,
+                                const LinearLayout &rhs, ComputeFn &&compute) {
+  size_t hash = llvm::hash_combine(op, lhs, rhs);
+  auto find = [&]() -> const Entry * {
+    auto [begin, end] = entries.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+      const Entry &entry = it->second;
+      if (entry.op == op && entry.lhs == lhs && entry.rhs == rhs)
+        return &entry;
+    }
+    return nullptr;
+  };
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (const Entry *entry = find()) {
+      ++numHits;
+      return entry->result;
+    }
+  }
+  // Compute outside of the lock.  Threads that miss on the same key
+  // concurrently compute the same result, only the first one is kept.
+  ++numMisses;
+  std::optional<LinearLayout> result = compute();
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  if (!find()) {
+    if (entries.size() >= maxSize)
+      entries.clear();
+    entries.emplace(hash, Entry{op, lhs, rhs, result});
+  }
+  return result;
+}
+
+LinearLayout LinearLayoutCache::compose(const LinearLayout &inner,
+                                        const LinearLayout &outer) {
+  return *getOrCompute(Op::Compose, inner, outer,
+                       [&]() { return inner.compose(outer); });
+}
+
+LinearLayout LinearLayoutCache::invertAndCompose(const LinearLayout &inner,
+                                                 const LinearLayout &outer) {
+  return *getOrCompute(Op::InvertAndCompose, inner, outer,
+                       [&]() { return inner.invertAndCompose(outer); });
+}
+
+LinearLayout LinearLayoutCache::multiply(const LinearLayout &inner,
+                                         const LinearLayout &outer) {
+  return *getOrCompute(Op::Multiply, inner, outer,
+                       [&]() { return inner * outer; });
+}
+
+std::optional<LinearLayout>
+LinearLayoutCache::divideRight(const LinearLayout &dividend,
+                               const LinearLayout &divisor) {
+  return getOrCompute(Op::DivideRight, dividend, divisor, [&]() {
+    return LinearLayout(dividend).divideRight(divisor);
+  });
+}
+
+size_t LinearLayoutCache::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+  return entries.size();
+}
+
+void LinearLayoutCache::clear() {
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  entries.clear();
+  numHits = 0;
+  numMisses = 0;
+}
+
+} // namespace mlir::triton
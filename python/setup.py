@@ -586,7 +586,7 @@ class plugin_egginfo(egg_info):
 
 
 package_data = {
-    "triton/tools": ["compile.h", "compile.c"],
+    "triton/tools": ["compile.h", "compile.c", "triton_bundle.h", "triton_bundle.c"],
     **{f"triton/backends/{b.name}": b.package_data
        for b in backends},
 }
@@ -0,0 +1,343 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace py = pybind11;
+
+namespace {
+
+// A file of the store, mapped over an address range large enough for the
+// largest store. It is unmapped once neither the store nor a view uses it.
+struct StoreFile {
+  // Size of the address range the file is mapped to
+  static constexpr size_t MaxSize = size_t(64) << 30;
+
+  int fd;
+  dev_t dev;
+  ino_t ino;
+  const char *base;
+
+  StoreFile(int fd, dev_t dev, ino_t ino, const char *base)
+      : fd(fd), dev(dev), ino(ino), base(base) {}
+
+  ~StoreFile() {
+    munmap(const_cast<char *>(base), MaxSize);
+    close(fd);
+  }
+
+  StoreFile(const StoreFile &) = delete;
+  StoreFile &operator=(const StoreFile &) = delete;
+};
+
+// Data of a record, which keeps the mapping of its file alive.
+struct StoreView {
+  std::shared_ptr<const StoreFile> file;
+  std::string_view data;
+};
+
+// A single-file, append-only store of cache entries.
+//
+// The file starts with a header followed by records, each made of a record
+// header, the key and the data, padded to 8 bytes:
+//
+//   [FileHeader][RecordHeader key data pad][RecordHeader key data pad]...
+//
+// The file header holds the end of the last complete record. Readers map the
+// file once and index the records in memory, so lookups do not touch the file
+// system and return views of the mapped data. A miss only reads the end of the
+// records from the mapped header, and indexes the records appended since.
+// Writers append under an exclusive `flock` and then publish the new end, so
+// several processes can share a store. Bytes past the end, e.g. a record torn
+// by an interrupted writer, are ignored by readers and truncated by the next
+// writer. Keys are expected to be content addressed: a key that is already
+// indexed is not looked up again in the file, so only the records written by
+// this store replace the ones indexed before.
+//
+// `compact` replaces the file by a new one with only the records to keep.
+// Readers keep using the file they mapped, and writers switch to the new one.
+class KernelStore {
+public:
+  explicit KernelStore(std::string path) : path(std::move(path)) { open(); }
+
+  KernelStore(const KernelStore &) = delete;
+  KernelStore &operator=(const KernelStore &) = delete;
+
+  // Returns the data of `key`, or std::nullopt if it is not in the store.
+  std::optional<StoreView> get(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+      // The key may have been added since the records were indexed
+      refresh();
+      it = index.find(key);
+    }
+    if (it == index.end())
+      return std::nullopt;
+    return StoreView{file, it->second};
+  }
+
+  void put(const std::string &key, std::string_view data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lockCurrentFile();
+    try {
+      refresh();
+      RecordHeader header;
+      header.keySize = key.size();
+      header.dataSize = data.size();
+      uint64_t end = indexedSize + recordSize(header);
+      if (end > StoreFile::MaxSize)
+        throw std::runtime_error(path + " is full");
+      // Drop the records torn by interrupted writers
+      struct stat st;
+      if (fstat(file->fd, &st) == 0 &&
+          static_cast<uint64_t>(st.st_size) > indexedSize &&
+          ftruncate(file->fd, indexedSize) != 0)
+        throw std::runtime_error("Failed to truncate " + path);
+      std::string record(recordSize(header), '\0');
+      writeRecord(record.data(), key, data);
+      writeAt(file->fd, indexedSize, record.data(), record.size());
+      writeAt(file->fd, offsetof(FileHeader, end), &end, sizeof(end));
+      refresh();
+    } catch (...) {
+      flock(file->fd, LOCK_UN);
+      throw;
+    }
+    flock(file->fd, LOCK_UN);
+  }
+
+  // Replaces the file by one with the records whose key satisfies `keep`, and
+  // returns the size of the new file.
+  size_t compact(const std::function<bool(const std::string &)> &keep) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lockCurrentFile();
+    std::string tmpPath =
+        path + ".tmp.pid_" + std::to_string(getpid()) + "_compact";
+    int fd = -1;
+    try {
+      refresh();
+      fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+      if (fd < 0)
+        throw std::runtime_error("Failed to open " + tmpPath);
+      FileHeader fileHeader;
+      std::string records;
+      for (auto &[key, data] : index) {
+        if (!keep(key))
+          continue;
+        RecordHeader header;
+        header.keySize = key.size();
+        header.dataSize = data.size();
+        size_t offset = records.size();
+        records.resize(offset + recordSize(header));
+        writeRecord(records.data() + offset, key, data);
+      }
+      fileHeader.end = sizeof(fileHeader) + records.size();
+      writeAt(fd, 0, &fileHeader, sizeof(fileHeader));
+      writeAt(fd, sizeof(fileHeader), records.data(), records.size());
+      close(fd);
+      fd = -1;
+      if (rename(tmpPath.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Failed to replace " + path);
+    } catch (...) {
+      if (fd >= 0) {
+        close(fd);
+        unlink(tmpPath.c_str());
+      }
+      flock(file->fd, LOCK_UN);
+      throw;
+    }
+    flock(file->fd, LOCK_UN);
+    open();
+    refresh();
+    return indexedSize;
+  }
+
+  // Returns the number of distinct keys indexed so far.
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh();
+    return index.size();
+  }
+
+private:
+  static constexpr char Magic[8] = {'T', 'R', 'I', 'T', 'O', 'N', 'K', 'S'};
+  static constexpr uint32_t Version = 2;
+  static constexpr uint32_t RecordMagic = 0x7472656b; // "kert"
+
+  struct FileHeader {
+    char magic[8];
+    uint32_t version = Version;
+    uint32_t reserved = 0;
+    // End of the last complete record
+    uint64_t end = sizeof(FileHeader);
+    FileHeader() { std::memcpy(magic, Magic, sizeof(magic)); }
+  };
+
+  struct RecordHeader {
+    uint32_t magic = RecordMagic;
+    uint32_t keySize = 0;
+    uint64_t dataSize = 0;
+  };
+
+  static size_t recordSize(const RecordHeader &header) {
+    auto size = sizeof(RecordHeader) + header.keySize + header.dataSize;
+    return (size + 7) & ~size_t(7);
+  }
+
+  // Writes the record of `key` to `dest`, which holds `recordSize` zeros.
+  static void writeRecord(char *dest, std::string_view key,
+                          std::string_view data) {
+    RecordHeader header;
+    header.keySize = key.size();
+    header.dataSize = data.size();
+    std::memcpy(dest, &header, sizeof(header));
+    std::memcpy(dest + sizeof(header), key.data(), key.size());
+    std::memcpy(dest + sizeof(header) + key.size(), data.data(), data.size());
+  }
+
+  static void writeAt(int fd, size_t offset, const void *data, size_t size) {
+    auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+      auto written = pwrite(fd, bytes, size, offset);
+      if (written < 0)
+        throw std::runtime_error("Failed to write the kernel store");
+      bytes += written;
+      offset += written;
+      size -= written;
+    }
+  }
+
+  // Takes the `flock` of the file at `path`, switching to it first if it
+  // replaced ours, e.g. when it was compacted or removed.
+  void lockCurrentFile() {
+    while (true) {
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0 || st.st_dev != file->dev ||
+          st.st_ino != file->ino) {
+        open();
+        continue;
+      }
+      flock(file->fd, LOCK_EX);
+      // The file may have been replaced while we waited for the lock
+      if (stat(path.c_str(), &st) == 0 && st.st_dev == file->dev &&
+          st.st_ino == file->ino)
+        return;
+      flock(file->fd, LOCK_UN);
+    }
+  }
+
+  // Opens and maps the file, creating it if needed. The file used before is
+  // unmapped once the views into it are released.
+  void open() {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Failed to open " + path);
+    flock(fd, LOCK_EX);
+    try {
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+        throw std::runtime_error("Failed to open " + path);
+      FileHeader header;
+      bool hasHeader = static_cast<size_t>(st.st_size) >= sizeof(header);
+      if (hasHeader) {
+        if (pread(fd, &header, sizeof(header), 0) != sizeof(header))
+          throw std::runtime_error("Failed to read " + path);
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+          throw std::runtime_error(path + " is not a kernel store");
+      }
+      if (!hasHeader || header.version != Version) {
+        // A new file, or one written by another version of the store
+        header = FileHeader();
+        if (ftruncate(fd, 0) != 0)
+          throw std::runtime_error("Failed to truncate " + path);
+        writeAt(fd, 0, &header, sizeof(header));
+      }
+      void *addr =
+          mmap(nullptr, StoreFile::MaxSize, PROT_READ, MAP_SHARED, fd, 0);
+      if (addr == MAP_FAILED)
+        throw std::runtime_error("Failed to map " + path);
+      flock(fd, LOCK_UN);
+      file = std::make_shared<StoreFile>(fd, st.st_dev, st.st_ino,
+                                         static_cast<char *>(addr));
+    } catch (...) {
+      flock(fd, LOCK_UN);
+      close(fd);
+      throw;
+    }
+    index.clear();
+    indexedSize = sizeof(FileHeader);
+  }
+
+  // Indexes the records appended since the last call.
+  void refresh() {
+    const char *base = file->base;
+    auto *header = reinterpret_cast<const FileHeader *>(base);
+    uint64_t end = __atomic_load_n(&header->end, __ATOMIC_ACQUIRE);
+    if (end > StoreFile::MaxSize)
+      end = StoreFile::MaxSize;
+    size_t offset = indexedSize;
+    while (offset + sizeof(RecordHeader) <= end) {
+      RecordHeader header;
+      std::memcpy(&header, base + offset, sizeof(header));
+      if (header.magic != RecordMagic || header.dataSize > end - offset ||
+          offset + recordSize(header) > end)
+        break;
+      auto *key = base + offset + sizeof(RecordHeader);
+      index[std::string(key, header.keySize)] =
+          std::string_view(key + header.keySize, header.dataSize);
+      offset += recordSize(header);
+    }
+    indexedSize = offset;
+  }
+
+  const std::string path;
+  std::mutex mutex;
+  std::shared_ptr<StoreFile> file;
+  // End of the last indexed record
+  size_t indexedSize = 0;
+  std::unordered_map<std::string, std::string_view> index;
+};
+
+} // namespace
+
+void init_triton_cache(py::module &&m) {
+  // The data of a record, exposed as a read-only buffer
+  py::class_<StoreView>(m, "view", py::buffer_protocol(), py::module_local())
+      .def_buffer([](StoreView &self) {
+        return py::buffer_info(const_cast<char *>(self.data.data()), 1,
+                               py::format_descriptor<uint8_t>::format(),
+                               self.data.size(), /*readonly=*/true);
+      });
+
+  py::class_<KernelStore>(m, "store", py::module_local())
+      .def(py::init<std::string>())
+      .def("get",
+           [](KernelStore &self, const std::string &key) -> py::object {
+             auto view = self.get(key);
+             if (!view)
+               return py::none();
+             return py::memoryview(py::cast(std::move(*view)));
+           })
+      .def("put",
+           [](KernelStore &self, const std::string &key, py::bytes data) {
+             self.put(key, std::string_view(data));
+           })
+      .def("compact", &KernelStore::compact)
+      .def("__len__", &KernelStore::size);
+}
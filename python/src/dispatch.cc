@@ -0,0 +1,391 @@
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <pybind11/pybind11.h>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+// A parameter of a JIT function, see `KernelParam`.
+struct Param {
+  py::object name;
+  bool isConstexpr;
+  bool specialize;
+  bool align;
+  bool isConst;
+  std::string annotationType;
+  // Null if the parameter has no default value
+  py::object defaultValue;
+};
+
+// A kernel compiled for a specialization key, and how to launch it.
+struct Entry {
+  py::object kernel;
+  py::object launch;
+  py::object function;
+  py::object packedMetadata;
+  // The kernel is only launched while it is still in the cache of the JIT
+  // function, under its Python key
+  py::object cache;
+  py::object key;
+};
+
+// The launch fast path of a JIT function on one device.
+//
+// `run` does what `JITFunction.run` does for a kernel that is already
+// compiled: it binds the arguments to the parameters, computes the
+// specialization key of the call, looks the kernel up, checks the used
+// globals, evaluates the grid and calls the launcher. Calls it can't handle
+// (unknown keys, launch hooks, arguments of unexpected types) return None and
+// take the Python path, which compiles the kernel and `add`s it here.
+//
+// The key mirrors the one built in Python by `mangle_type` and
+// `compute_spec_key`, but is a tuple rather than a string so that computing
+// it doesn't format the constexpr values.
+class Dispatcher {
+public:
+  Dispatcher(py::list params, py::object mangleType, py::object compiledKernel)
+      : mangleType(std::move(mangleType)),
+        compiledKernel(std::move(compiledKernel)) {
+    for (py::handle p : params) {
+      auto t = p.cast<py::tuple>();
+      Param param;
+      param.name = t[0];
+      param.isConstexpr = t[1].cast<bool>();
+      param.specialize = t[2].cast<bool>();
+      param.align = t[3].cast<bool>();
+      param.isConst = t[4].cast<bool>();
+      param.annotationType = t[5].cast<std::string>();
+      if (t[6].cast<bool>())
+        param.defaultValue = t[7];
+      paramIndex[param.name] = py::int_(this->params.size());
+      if (!param.isConstexpr)
+        numNonConstexpr++;
+      this->params.push_back(std::move(param));
+    }
+  }
+
+  // args: grid, stream, then the arguments of the JIT function.
+  py::object run(py::args args, py::kwargs kwargs) {
+    if (!compiledKernel.attr("launch_enter_hook").is_none())
+      return py::none();
+    std::vector<PyObject *> values;
+    py::list excess;
+    if (!bind(args.ptr(), 2, kwargs.ptr(), values, excess))
+      return py::none();
+    py::object key = makeKey(values, excess);
+    if (!key)
+      return py::none();
+    PyObject *index = PyDict_GetItemWithError(entryIndex.ptr(), key.ptr());
+    if (!index) {
+      // Unhashable constexpr values
+      PyErr_Clear();
+      return py::none();
+    }
+    const Entry &entry = entries[PyLong_AsSize_t(index)];
+    PyObject *cached =
+        PyDict_GetItemWithError(entry.cache.ptr(), entry.key.ptr());
+    if (cached != entry.kernel.ptr() || !globalsUnchanged()) {
+      PyErr_Clear();
+      return py::none();
+    }
+
+    PyObject *grid[3];
+    py::object gridSeq = evalGrid(args[0], values);
+    if (!gridSeq)
+      return py::none();
+    Py_ssize_t gridSize = PySequence_Fast_GET_SIZE(gridSeq.ptr());
+    py::int_ one(1);
+    for (Py_ssize_t i = 0; i < 3; i++)
+      grid[i] = i < gridSize ? PySequence_Fast_GET_ITEM(gridSeq.ptr(), i)
+                             : one.ptr();
+
+    py::object exitHook = compiledKernel.attr("launch_exit_hook");
+    PyObject *launchArgs[9] = {grid[0],
+                               grid[1],
+                               grid[2],
+                               args[1].ptr(),
+                               entry.function.ptr(),
+                               entry.packedMetadata.ptr(),
+                               Py_None,
+                               Py_None,
+                               exitHook.ptr()};
+    py::tuple callArgs(9 + numNonConstexpr);
+    size_t n = 0;
+    for (PyObject *arg : launchArgs) {
+      Py_INCREF(arg);
+      PyTuple_SET_ITEM(callArgs.ptr(), n++, arg);
+    }
+    for (size_t i = 0; i < params.size(); i++) {
+      if (params[i].isConstexpr)
+        continue;
+      Py_INCREF(values[i]);
+      PyTuple_SET_ITEM(callArgs.ptr(), n++, values[i]);
+    }
+    py::object ret = py::reinterpret_steal<py::object>(
+        PyObject_Call(entry.launch.ptr(), callArgs.ptr(), nullptr));
+    if (!ret)
+      throw py::error_already_set();
+    return entry.kernel;
+  }
+
+  // args: the kernel, its launcher, the cache of the JIT function and the key
+  // of the kernel in it, the used globals as (globals, name, value) tuples,
+  // then the arguments the kernel was launched with.
+  void add(py::args args, py::kwargs kwargs) {
+    std::vector<PyObject *> values;
+    py::list excess;
+    if (!bind(args.ptr(), 5, kwargs.ptr(), values, excess))
+      return;
+    py::object key = makeKey(values, excess);
+    if (!key)
+      return;
+    Entry entry;
+    entry.kernel = args[0];
+    entry.launch = args[1];
+    entry.function = entry.kernel.attr("function");
+    entry.packedMetadata = entry.kernel.attr("packed_metadata");
+    entry.cache = args[2];
+    entry.key = args[3];
+    usedGlobals.clear();
+    for (py::handle g : args[4]) {
+      auto t = g.cast<py::tuple>();
+      usedGlobals.push_back({t[0], t[1], t[2]});
+    }
+    PyObject *index = PyDict_GetItemWithError(entryIndex.ptr(), key.ptr());
+    if (index) {
+      entries[PyLong_AsSize_t(index)] = std::move(entry);
+      return;
+    }
+    if (PyErr_Occurred()) {
+      PyErr_Clear();
+      return;
+    }
+    entryIndex[key] = py::int_(entries.size());
+    entries.push_back(std::move(entry));
+  }
+
+  size_t size() const { return entries.size(); }
+
+private:
+  // Binds the arguments of a call, starting at `first` in `args`, to the
+  // parameters and fills in the defaults. Keyword arguments that aren't
+  // parameters are compile options, they are added to `excess`. Returns false
+  // if the arguments don't match the parameters.
+  bool bind(PyObject *args, Py_ssize_t first, PyObject *kwargs,
+            std::vector<PyObject *> &values, py::list &excess) {
+    Py_ssize_t numArgs = PyTuple_GET_SIZE(args) - first;
+    if (numArgs < 0 || numArgs > (Py_ssize_t)params.size())
+      return false;
+    values.assign(params.size(), nullptr);
+    for (Py_ssize_t i = 0; i < numArgs; i++)
+      values[i] = PyTuple_GET_ITEM(args, first + i);
+    PyObject *name, *value;
+    Py_ssize_t pos = 0;
+    while (kwargs && PyDict_Next(kwargs, &pos, &name, &value)) {
+      PyObject *index = PyDict_GetItem(paramIndex.ptr(), name);
+      if (!index) {
+        excess.append(py::make_tuple(py::handle(name), keyOf(value)));
+        continue;
+      }
+      size_t i = PyLong_AsSize_t(index);
+      if (values[i])
+        return false;
+      values[i] = value;
+    }
+    for (size_t i = 0; i < params.size(); i++) {
+      if (values[i])
+        continue;
+      if (!params[i].defaultValue)
+        return false;
+      values[i] = params[i].defaultValue.ptr();
+    }
+    return true;
+  }
+
+  // The part of the key for a constexpr value. Values that compare equal but
+  // print differently (1 and True, 0.0 and -0.0) are different keys in Python.
+  static py::object keyOf(PyObject *value) {
+    py::handle type((PyObject *)Py_TYPE(value));
+    if (PyFloat_CheckExact(value)) {
+      double d = PyFloat_AS_DOUBLE(value);
+      uint64_t bits;
+      std::memcpy(&bits, &d, sizeof(bits));
+      return py::make_tuple(type, py::int_(bits));
+    }
+    return py::make_tuple(type, py::handle(value));
+  }
+
+  // Returns a null object if an argument can't be handled here.
+  py::object makeKey(const std::vector<PyObject *> &values,
+                     const py::list &excess) {
+    std::string signature;
+    std::string specs;
+    py::list constexprs;
+    for (size_t i = 0; i < params.size(); i++) {
+      const Param &param = params[i];
+      PyObject *value = values[i];
+      if (param.isConstexpr) {
+        constexprs.append(keyOf(value));
+        continue;
+      }
+      if (!param.annotationType.empty())
+        signature += param.annotationType;
+      else if (!mangle(value, param.isConst, signature))
+        return py::object();
+      signature += ',';
+      if (param.specialize) {
+        char spec;
+        if (!specialize(value, param.align, spec))
+          return py::object();
+        specs += spec;
+      }
+    }
+    return py::make_tuple(py::str(signature + specs), py::tuple(constexprs),
+                          py::tuple(excess));
+  }
+
+  // See `mangle_type`.
+  bool mangle(PyObject *arg, bool isConst, std::string &out) {
+    if (arg == Py_None) {
+      out += "none";
+    } else if (PyBool_Check(arg)) {
+      out += "i1";
+    } else if (PyLong_Check(arg)) {
+      int overflow;
+      long long v = PyLong_AsLongLongAndOverflow(arg, &overflow);
+      if (overflow == 0 && v >= INT32_MIN && v <= INT32_MAX) {
+        out += "i32";
+      } else if (overflow > 0) {
+        PyLong_AsUnsignedLongLong(arg);
+        if (PyErr_Occurred()) {
+          PyErr_Clear();
+          out += "i64";
+        } else {
+          out += "u64";
+        }
+      } else {
+        out += "i64";
+      }
+    } else if (PyFloat_Check(arg)) {
+      out += "fp32";
+    } else if (PyObject_HasAttrString(arg, "tma_desc_cpu_ptr")) {
+      out += "nvTmaDesc";
+    } else {
+      PyObject *dtype = PyObject_GetAttrString(arg, "dtype");
+      if (!dtype) {
+        PyErr_Clear();
+        return false;
+      }
+      auto dtypeKey = std::make_pair(dtype, isConst);
+      auto it = dtypeNames.find(dtypeKey);
+      if (it == dtypeNames.end()) {
+        try {
+          auto name = mangleType(py::handle(arg), isConst).cast<std::string>();
+          it = dtypeNames.emplace(dtypeKey, name).first;
+        } catch (py::error_already_set &) {
+          Py_DECREF(dtype);
+          return false;
+        }
+        // Keep the dtype alive so that its address stays a valid key
+        Py_INCREF(dtype);
+      }
+      Py_DECREF(dtype);
+      out += it->second;
+    }
+    return true;
+  }
+
+  // See `compute_spec_key`.
+  static bool specialize(PyObject *arg, bool align, char &spec) {
+    spec = 'N';
+    if (PyLong_Check(arg)) {
+      int overflow;
+      long long v = PyLong_AsLongLongAndOverflow(arg, &overflow);
+      unsigned long long low = PyLong_AsUnsignedLongLongMask(arg);
+      if (align && low % 16 == 0)
+        spec = 'D';
+      else if (overflow == 0 && v == 1)
+        spec = '1';
+      return true;
+    }
+    if (!align)
+      return true;
+    PyObject *dataPtr = PyObject_GetAttrString(arg, "data_ptr");
+    if (!dataPtr) {
+      PyErr_Clear();
+      return true;
+    }
+    PyObject *ptr = PyObject_CallObject(dataPtr, nullptr);
+    Py_DECREF(dataPtr);
+    if (!ptr || !PyLong_Check(ptr)) {
+      PyErr_Clear();
+      Py_XDECREF(ptr);
+      return false;
+    }
+    if (PyLong_AsUnsignedLongLongMask(ptr) % 16 == 0)
+      spec = 'D';
+    Py_DECREF(ptr);
+    return true;
+  }
+
+  bool globalsUnchanged() const {
+    for (const auto &[globals, name, value] : usedGlobals) {
+      PyObject *current = PyDict_GetItemWithError(globals.ptr(), name.ptr());
+      if (!current ||
+          PyObject_RichCompareBool(current, value.ptr(), Py_NE) != 0)
+        return false;
+    }
+    return true;
+  }
+
+  // Returns the grid as a sequence of 1 to 3 sizes, or a null object to let
+  // the Python path report an invalid grid. Errors raised by a callable grid
+  // are propagated.
+  py::object evalGrid(py::handle grid,
+                      const std::vector<PyObject *> &values) const {
+    py::object ret = py::reinterpret_borrow<py::object>(grid);
+    if (PyCallable_Check(grid.ptr())) {
+      // Arguments are passed as a dict to `grid`, by contract.
+      py::dict boundArgs;
+      for (size_t i = 0; i < params.size(); i++)
+        boundArgs[params[i].name] = py::handle(values[i]);
+      ret = grid(boundArgs);
+    }
+    ret = py::reinterpret_steal<py::object>(
+        PySequence_Fast(ret.ptr(), "grid must be a sequence"));
+    if (!ret || PySequence_Fast_GET_SIZE(ret.ptr()) == 0) {
+      PyErr_Clear();
+      return py::object();
+    }
+    return ret;
+  }
+
+  std::vector<Param> params;
+  size_t numNonConstexpr = 0;
+  py::dict paramIndex;
+  py::object mangleType;
+  py::object compiledKernel;
+  // Key -> index in `entries`
+  py::dict entryIndex;
+  std::vector<Entry> entries;
+  // Of the last kernel added; they are the same for all kernels of a function
+  std::vector<std::tuple<py::object, py::object, py::object>> usedGlobals;
+  std::map<std::pair<PyObject *, bool>, std::string> dtypeNames;
+};
+
+} // namespace
+
+void init_triton_dispatch(py::module &&m) {
+  py::class_<Dispatcher>(m, "dispatcher", py::module_local())
+      .def(py::init<py::list, py::object, py::object>())
+      .def("run", &Dispatcher::run)
+      .def("add", &Dispatcher::add)
+      .def("__len__", &Dispatcher::size);
+}
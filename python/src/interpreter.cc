@@ -1,9 +1,14 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 namespace py = pybind11;
 
@@ -302,6 +307,171 @@ makeAtomicRMWOp(pybind11::dtype dtype, const uint64_t *ptr, const void *val,
   return atomic_op;
 }
 
+// Bit layout of a floating point type
+struct FloatFormat {
+  int bitwidth;
+  int mantissaWidth;
+  int exponentBias;
+
+  int exponentWidth() const { return bitwidth - mantissaWidth - 1; }
+};
+
+// Shifts that follow numpy semantics: shifting by a negative amount or by at
+// least the bit width yields 0.
+inline uint64_t shiftLeft(uint64_t value, int64_t shift) {
+  return shift >= 0 && shift < 64 ? value << shift : 0;
+}
+
+inline uint64_t shiftRight(uint64_t value, int64_t shift) {
+  return shift >= 0 && shift < 64 ? value >> shift : 0;
+}
+
+inline uint64_t lowBits(int width) { return shiftLeft(1, width) - 1; }
+
+// Converts the bits of a float of format `in` to a float of format `out`.
+// This is the element-wise version of `_convert_float_numpy` in
+// interpreter.py and must produce the same bits.
+inline uint64_t convertFloat(uint64_t inputBits, FloatFormat in,
+                             FloatFormat out, bool rtne) {
+  uint64_t sign = (inputBits >> (in.bitwidth - 1)) & 0x01;
+  uint64_t significand = inputBits & lowBits(in.mantissaWidth);
+  int64_t rawExponent =
+      (inputBits >> in.mantissaWidth) & lowBits(in.exponentWidth());
+  int64_t exponent = rawExponent;
+  if (exponent == 0) {
+    // Normalize subnormals: shift the most significant bit of the significand
+    // into the implicit bit and adjust the exponent accordingly
+    if (significand == 0) {
+      exponent = in.exponentBias - out.exponentBias;
+    } else {
+      int msb = 63 - __builtin_clzll(significand);
+      int bitPos = in.mantissaWidth - msb;
+      exponent = 1 - bitPos;
+      significand = (significand << bitPos) & lowBits(in.mantissaWidth);
+    }
+  }
+  // Prevent overflow and underflow
+  int64_t maxExponent = lowBits(out.exponentWidth());
+  uint64_t outputExponent = std::max<int64_t>(
+      0, std::min<int64_t>(exponent - in.exponentBias + out.exponentBias,
+                           maxExponent));
+  uint64_t outputSignificand;
+  if (in.bitwidth > out.bitwidth) { // Downcast
+    int cut = in.mantissaWidth - out.mantissaWidth;
+    outputSignificand =
+        shiftRight(significand, cut) & lowBits(out.mantissaWidth);
+    if (rtne && (significand & shiftLeft(1, cut - 1)))
+      outputSignificand += 1;
+  } else { // Upcast
+    outputSignificand =
+        shiftLeft(significand, out.mantissaWidth - in.mantissaWidth) &
+        lowBits(out.mantissaWidth);
+  }
+  if (outputExponent == 0 && rawExponent != 0) {
+    // Underflow: convert the normal input to a subnormal output
+    int64_t shift =
+        (1 - out.exponentBias) - (rawExponent - in.exponentBias);
+    outputSignificand = shiftRight(outputSignificand, shift) |
+                        shiftLeft(1, out.mantissaWidth - shift);
+  }
+  return (sign << (out.bitwidth - 1)) |
+         (outputExponent << out.mantissaWidth) | outputSignificand;
+}
+
+template <typename InT, typename OutT>
+void convertFloats(const void *input, void *output, size_t numel,
+                   FloatFormat in, FloatFormat out, bool rtne) {
+  auto *inputBits = static_cast<const InT *>(input);
+  auto *outputBits = static_cast<OutT *>(output);
+  for (size_t i = 0; i < numel; ++i)
+    outputBits[i] =
+        static_cast<OutT>(convertFloat(inputBits[i], in, out, rtne));
+}
+
+template <typename InT>
+void convertFloatsFrom(const void *input, void *output, size_t numel,
+                       FloatFormat in, FloatFormat out, bool rtne) {
+  switch (out.bitwidth) {
+  case 8:
+    return convertFloats<InT, uint8_t>(input, output, numel, in, out, rtne);
+  case 16:
+    return convertFloats<InT, uint16_t>(input, output, numel, in, out, rtne);
+  case 32:
+    return convertFloats<InT, uint32_t>(input, output, numel, in, out, rtne);
+  case 64:
+    return convertFloats<InT, uint64_t>(input, output, numel, in, out, rtne);
+  default:
+    throw std::invalid_argument("Unsupported float bitwidth");
+  }
+}
+
+// Maps an item size to an unsigned integer type of that size, so that copies
+// of elements compile to single moves.
+template <size_t ItemSize> struct UIntOfSize;
+template <> struct UIntOfSize<1> { using type = uint8_t; };
+template <> struct UIntOfSize<2> { using type = uint16_t; };
+template <> struct UIntOfSize<4> { using type = uint32_t; };
+template <> struct UIntOfSize<8> { using type = uint64_t; };
+
+template <size_t ItemSize>
+void maskedLoad(const uint64_t *ptrs, const bool *mask, const void *other,
+                void *ret, size_t numel) {
+  using T = typename UIntOfSize<ItemSize>::type;
+  auto *otherData = static_cast<const T *>(other);
+  auto *retData = static_cast<T *>(ret);
+  for (size_t i = 0; i < numel; ++i) {
+    T value;
+    if (mask[i])
+      std::memcpy(&value, reinterpret_cast<const void *>(ptrs[i]), ItemSize);
+    else
+      value = otherData[i];
+    retData[i] = value;
+  }
+}
+
+template <size_t ItemSize>
+void maskedStore(const uint64_t *ptrs, const void *value, const bool *mask,
+                 size_t numel) {
+  using T = typename UIntOfSize<ItemSize>::type;
+  auto *valueData = static_cast<const T *>(value);
+  for (size_t i = 0; i < numel; ++i) {
+    if (mask[i])
+      std::memcpy(reinterpret_cast<void *>(ptrs[i]), &valueData[i], ItemSize);
+  }
+}
+
+#define DISPATCH_ITEM_SIZE(ITEM_SIZE, FN, ...)                                 \
+  switch (ITEM_SIZE) {                                                         \
+  case 1:                                                                      \
+    FN<1>(__VA_ARGS__);                                                        \
+    break;                                                                     \
+  case 2:                                                                      \
+    FN<2>(__VA_ARGS__);                                                        \
+    break;                                                                     \
+  case 4:                                                                      \
+    FN<4>(__VA_ARGS__);                                                        \
+    break;                                                                     \
+  case 8:                                                                      \
+    FN<8>(__VA_ARGS__);                                                        \
+    break;                                                                     \
+  default:                                                                     \
+    throw std::invalid_argument("Unsupported item size");                      \
+  }
+
+template <typename T> T umulhi(T lhs, T rhs) {
+  if constexpr (std::is_signed_v<T>)
+    return static_cast<T>((static_cast<__int128>(lhs) * rhs) >> 64);
+  else
+    return static_cast<T>((static_cast<unsigned __int128>(lhs) * rhs) >> 64);
+}
+
+template <typename T>
+using c_array_of = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+py::array ensureContiguous(py::array array) {
+  return py::array::ensure(array, py::array::c_style);
+}
+
 } // namespace
 
 void init_triton_interpreter(py::module &&m) {
@@ -327,42 +497,133 @@ void init_triton_interpreter(py::module &&m) {
       .value("UMAX", RMWOp::UMAX)
       .export_values();
 
+  py::class_<FloatFormat>(m, "float_format", py::module_local())
+      .def(py::init<int, int, int>(), py::arg("bitwidth"),
+           py::arg("mantissa_width"), py::arg("exponent_bias"));
+
   m.def("load",
-        [](py::array_t<uint64_t> ptr, py::array_t<bool> mask, py::array other,
+        [](c_array_of<uint64_t> ptr, c_array_of<bool> mask, py::array other,
            py::dtype ret_dtype) -> py::array {
-          int numel = ptr.size();
+          size_t numel = ptr.size();
           auto shape =
               std::vector<ptrdiff_t>(ptr.shape(), ptr.shape() + ptr.ndim());
-          py::array ret(ret_dtype, py::array::ShapeContainer{numel});
-          py::array_t<uint64_t> reshaped_ptr = ptr.reshape({numel});
-          py::array_t<bool> reshaped_mask = mask.reshape({numel});
-          py::array reshaped_others = other.reshape({numel});
-          for (size_t i = 0; i < ptr.size(); ++i) {
-            if (reshaped_mask.at(i))
-              memcpy(ret.mutable_data(i),
-                     reinterpret_cast<void *>(reshaped_ptr.at(i)),
-                     ret_dtype.itemsize());
-            else
-              memcpy(ret.mutable_data(i), reshaped_others.data(i),
-                     ret_dtype.itemsize());
+          py::array ret(ret_dtype, shape);
+          auto contiguous_other = ensureContiguous(other);
+          auto *ptr_data = ptr.data();
+          auto *mask_data = mask.data();
+          auto *other_data = contiguous_other.data();
+          auto *ret_data = ret.mutable_data();
+          auto itemsize = ret_dtype.itemsize();
+          {
+            py::gil_scoped_release release;
+            DISPATCH_ITEM_SIZE(itemsize, maskedLoad, ptr_data, mask_data,
+                               other_data, ret_data, numel);
           }
-          return ret.reshape(shape);
+          return ret;
         });
 
-  m.def("store",
-        [](py::array_t<uint64_t> ptr, py::array value, py::array_t<bool> mask) {
-          int numel = ptr.size();
-          py::array_t<uint64_t> reshaped_ptr = ptr.reshape({numel});
-          py::array_t<int8_t> reshaped_mask = mask.reshape({numel});
-          py::array reshaped_value = value.reshape({numel});
-          for (size_t i = 0; i < ptr.size(); ++i) {
-            if (reshaped_mask.at(i)) {
-              memcpy(reinterpret_cast<void *>(reshaped_ptr.mutable_at(i)),
-                     reshaped_value.data(i), value.dtype().itemsize());
+  m.def("store", [](c_array_of<uint64_t> ptr, py::array value,
+                    c_array_of<bool> mask) {
+    size_t numel = ptr.size();
+    auto contiguous_value = ensureContiguous(value);
+    auto *ptr_data = ptr.data();
+    auto *value_data = contiguous_value.data();
+    auto *mask_data = mask.data();
+    auto itemsize = value.dtype().itemsize();
+    py::gil_scoped_release release;
+    DISPATCH_ITEM_SIZE(itemsize, maskedStore, ptr_data, value_data, mask_data,
+                       numel);
+  });
+
+  m.def("convert_float",
+        [](py::array input, FloatFormat in, FloatFormat out,
+           bool rtne) -> py::array {
+          auto contiguous_input = ensureContiguous(input);
+          if (contiguous_input.itemsize() * 8 != in.bitwidth)
+            throw std::invalid_argument("Input item size mismatch");
+          auto shape = std::vector<ptrdiff_t>(input.shape(),
+                                              input.shape() + input.ndim());
+          py::array ret(py::dtype("uint" + std::to_string(out.bitwidth)),
+                        shape);
+          size_t numel = input.size();
+          auto *input_data = contiguous_input.data();
+          auto *ret_data = ret.mutable_data();
+          {
+            py::gil_scoped_release release;
+            switch (in.bitwidth) {
+            case 8:
+              convertFloatsFrom<uint8_t>(input_data, ret_data, numel, in, out,
+                                         rtne);
+              break;
+            case 16:
+              convertFloatsFrom<uint16_t>(input_data, ret_data, numel, in,
+                                          out, rtne);
+              break;
+            case 32:
+              convertFloatsFrom<uint32_t>(input_data, ret_data, numel, in,
+                                          out, rtne);
+              break;
+            case 64:
+              convertFloatsFrom<uint64_t>(input_data, ret_data, numel, in,
+                                          out, rtne);
+              break;
+            default:
+              throw std::invalid_argument("Unsupported float bitwidth");
             }
           }
+          return ret;
         });
 
+  m.def("erf", [](py::array arg) -> py::array {
+    auto apply = [](auto array) -> py::array {
+      using T = typename decltype(array)::value_type;
+      py::array_t<T> ret(std::vector<ptrdiff_t>(
+          array.shape(), array.shape() + array.ndim()));
+      size_t numel = array.size();
+      auto *arg_data = array.data();
+      auto *ret_data = ret.mutable_data();
+      {
+        py::gil_scoped_release release;
+        // Compute in double precision like math.erf
+        for (size_t i = 0; i < numel; ++i)
+          ret_data[i] =
+              static_cast<T>(std::erf(static_cast<double>(arg_data[i])));
+      }
+      return ret;
+    };
+    if (arg.dtype().is(py::dtype::of<float>()))
+      return apply(c_array_of<float>(arg));
+    if (arg.dtype().is(py::dtype::of<double>()))
+      return apply(c_array_of<double>(arg));
+    throw std::invalid_argument("Unsupported data type");
+  });
+
+  m.def("umulhi", [](py::array lhs, py::array rhs) -> py::array {
+    auto apply = [](auto lhs, py::array rhs) -> py::array {
+      using T = typename decltype(lhs)::value_type;
+      auto contiguous_rhs = c_array_of<T>(rhs);
+      if (contiguous_rhs.size() != lhs.size())
+        throw std::invalid_argument("Operand size mismatch");
+      py::array_t<T> ret(
+          std::vector<ptrdiff_t>(lhs.shape(), lhs.shape() + lhs.ndim()));
+      size_t numel = lhs.size();
+      auto *lhs_data = lhs.data();
+      auto *rhs_data = contiguous_rhs.data();
+      auto *ret_data = ret.mutable_data();
+      {
+        py::gil_scoped_release release;
+        for (size_t i = 0; i < numel; ++i)
+          ret_data[i] = umulhi(lhs_data[i], rhs_data[i]);
+      }
+      return ret;
+    };
+    if (lhs.dtype().is(py::dtype::of<int64_t>()))
+      return apply(c_array_of<int64_t>(lhs), rhs);
+    if (lhs.dtype().is(py::dtype::of<uint64_t>()))
+      return apply(c_array_of<uint64_t>(lhs), rhs);
+    throw std::invalid_argument("Unsupported data type");
+  });
+
   m.def("atomic_rmw",
         [](RMWOp rmw_op, py::array_t<uint64_t> ptr, py::array val,
            py::array_t<bool> mask, MemSemantic sem) -> py::array {
@@ -406,7 +667,10 @@ void init_triton_interpreter(py::module &&m) {
 
 #undef MAKE_ATOMIC_RMW_OP
 
-          atomic_op->apply();
+          {
+            py::gil_scoped_release release;
+            atomic_op->apply();
+          }
           return ret.reshape(shape);
         });
 
@@ -426,10 +690,13 @@ void init_triton_interpreter(py::module &&m) {
           memcpy(static_cast<void *>(ret.mutable_data()),
                  static_cast<const void *>(reshaped_cmp.data()),
                  itemsize * numel);
-          AtomicCASOp(reshaped_ptr.data(), ret.mutable_data(),
-                      static_cast<const void *>(reshaped_val.data()), itemsize,
-                      numel, order)
-              .apply();
+          AtomicCASOp atomic_op(reshaped_ptr.data(), ret.mutable_data(),
+                                static_cast<const void *>(reshaped_val.data()),
+                                itemsize, numel, order);
+          {
+            py::gil_scoped_release release;
+            atomic_op.apply();
+          }
           return ret.reshape(shape);
         });
 }
@@ -24,6 +24,7 @@
 #include "mlir/Transforms/LocationSnapshot.h"
 #include "mlir/Transforms/Passes.h"
 
+#include "telemetry.h"
 #include "triton/Analysis/Allocation.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/Triton/IR/Types.h"
@@ -31,6 +32,10 @@
 #include "triton/Tools/Sys/GetEnv.hpp"
 #include "llvm/Support/SourceMgr.h"
 
+#include <mutex>
+#include <pthread.h>
+#include <vector>
+
 namespace {
 
 namespace py = pybind11;
@@ -135,6 +140,188 @@ void outputWarning(Location loc, const std::string &msg) {
                /*stack_level=*/2);
 }
 
+// Reports the passes run by a pass manager to the telemetry of the thread
+// that started it. Adaptors, which only run nested pipelines, are skipped so
+// that the time of a pass is not also attributed to its parent.
+class PassTelemetryInstrumentation : public PassInstrumentation {
+public:
+  explicit PassTelemetryInstrumentation(PassTelemetry &telemetry)
+      : telemetry(telemetry) {}
+
+  void runBeforePass(Pass *pass, Operation *op) override {
+    if (pass->getArgument().empty())
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    starts[{pass, op}] = PassTelemetry::Clock::now();
+  }
+
+  void runAfterPass(Pass *pass, Operation *op) override {
+    if (pass->getArgument().empty())
+      return;
+    PassTelemetry::Clock::time_point start;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      start = starts.lookup({pass, op});
+      starts.erase({pass, op});
+    }
+    int64_t numOps = 0;
+    op->walk([&](Operation *) { ++numOps; });
+    telemetry.record(pass->getArgument().str(), start, numOps);
+  }
+
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    starts.erase({pass, op});
+  }
+
+private:
+  PassTelemetry &telemetry;
+  // Nested passes run concurrently on the functions of a module.
+  std::mutex mutex;
+  llvm::DenseMap<std::pair<Pass *, Operation *>,
+                 PassTelemetry::Clock::time_point>
+      starts;
+};
+
+void loadDialects(MLIRContext &context) {
+  DialectRegistry registry;
+  registry.insert<TritonDialect, ::mlir::triton::gpu::TritonGPUDialect,
+                  math::MathDialect, arith::ArithDialect, index::IndexDialect,
+                  scf::SCFDialect, ::mlir::gpu::GPUDialect,
+                  cf::ControlFlowDialect, LLVM::LLVMDialect>();
+  registerBuiltinDialectTranslation(registry);
+  registerLLVMDialectTranslation(registry);
+  mlir::LLVM::registerInlinerInterface(registry);
+  context.appendDialectRegistry(registry);
+  context.loadAllAvailableDialects();
+}
+
+// The MLIR contexts compilations run in. Setting up a context (loading the
+// dialects, growing the uniquing tables of attributes and types, starting its
+// thread pool) is a visible part of compiling a small kernel, so back-to-back
+// compilations reuse them. Contexts are pooled under the key the caller
+// loaded them for (the backend), and are retired after `maxUses`
+// compilations so that the attributes and types uniqued for earlier kernels
+// don't accumulate forever.
+//
+// Idle contexts keep their threads. The threads are stopped before the
+// process forks, since the child wouldn't have them, and restarted when the
+// context is next acquired.
+class ContextPool {
+public:
+  static constexpr int maxUses = 64;
+  static constexpr size_t maxIdlePerKey = 16;
+
+  static ContextPool &get() {
+    // Never destroyed: the contexts are Python objects, which can't be
+    // released once the interpreter is finalized.
+    static ContextPool *pool = [] {
+      auto *pool = new ContextPool();
+      pthread_atfork(&ContextPool::prepareFork, &ContextPool::finishFork,
+                     &ContextPool::finishFork);
+      return pool;
+    }();
+    return *pool;
+  }
+
+  // Returns an idle context loaded for `key`, or a new context on which the
+  // Triton dialects are loaded and `load` is called to load the others.
+  py::object acquire(const std::string &key, const py::function &load) {
+    py::object context;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+        if (it->key != key)
+          continue;
+        context = std::move(it->object);
+        idle.erase(std::next(it).base());
+        break;
+      }
+    }
+    if (context) {
+      auto &ctx = context.cast<MLIRContext &>();
+      if (!ctx.isMultithreadingEnabled())
+        ctx.enableMultithreading();
+      return context;
+    }
+    auto *ctx = new MLIRContext();
+    context = py::cast(ctx, py::return_value_policy::take_ownership);
+    loadDialects(*ctx);
+    load(context);
+    std::lock_guard<std::mutex> lock(mutex);
+    uses[ctx] = 0;
+    return context;
+  }
+
+  // Returns a context to the pool once a compilation is done with it.
+  void release(const std::string &key, py::object context) {
+    auto &ctx = context.cast<MLIRContext &>();
+    // The diagnostic handlers `enable_debug` registers can't be removed.
+    bool reusable = !::triton::tools::getBoolEnv("MLIR_ENABLE_DIAGNOSTICS");
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = uses.find(&ctx);
+      if (it == uses.end())
+        return;
+      size_t numIdle = llvm::count_if(
+          idle, [&](const Entry &entry) { return entry.key == key; });
+      if (reusable && ++it->second < maxUses && numIdle < maxIdlePerKey) {
+        idle.push_back({key, &ctx, std::move(context)});
+        return;
+      }
+      uses.erase(it);
+    }
+    // The context is destroyed when the last module it owns is, possibly
+    // after the process forked: stop its threads now.
+    ctx.disableMultithreading();
+  }
+
+  // Drops a context instead of returning it to the pool, e.g. after a failed
+  // compilation, which may have left it in any state.
+  void retire(py::object context) {
+    auto &ctx = context.cast<MLIRContext &>();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      uses.erase(&ctx);
+    }
+    ctx.disableMultithreading();
+  }
+
+  // Drops the idle contexts.
+  void clear() {
+    std::vector<Entry> entries;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      entries.swap(idle);
+      for (const Entry &entry : entries)
+        uses.erase(entry.context);
+    }
+    for (Entry &entry : entries)
+      entry.context->disableMultithreading();
+  }
+
+private:
+  struct Entry {
+    std::string key;
+    MLIRContext *context;
+    py::object object;
+  };
+
+  static void prepareFork() {
+    ContextPool &pool = get();
+    pool.mutex.lock();
+    for (Entry &entry : pool.idle)
+      entry.context->disableMultithreading();
+  }
+
+  static void finishFork() { get().mutex.unlock(); }
+
+  std::mutex mutex;
+  std::vector<Entry> idle;
+  // Number of compilations run in each context handed out by the pool.
+  llvm::DenseMap<MLIRContext *, int> uses;
+};
+
 } // anonymous namespace
 
 /*****************************************************************************/
@@ -219,18 +406,19 @@ void init_triton_ir(py::module &&m) {
                                          py::module_local())
       .def(py::init<llvm::SourceMgr &, MLIRContext *>());
 
-  m.def("load_dialects", [](MLIRContext &context) {
-    DialectRegistry registry;
-    registry.insert<TritonDialect, ::mlir::triton::gpu::TritonGPUDialect,
-                    math::MathDialect, arith::ArithDialect, index::IndexDialect,
-                    scf::SCFDialect, ::mlir::gpu::GPUDialect,
-                    cf::ControlFlowDialect, LLVM::LLVMDialect>();
-    registerBuiltinDialectTranslation(registry);
-    registerLLVMDialectTranslation(registry);
-    mlir::LLVM::registerInlinerInterface(registry);
-    context.appendDialectRegistry(registry);
-    context.loadAllAvailableDialects();
+  m.def("load_dialects", &loadDialects);
+
+  m.def("acquire_context",
+        [](const std::string &key, const py::function &load) {
+          return ContextPool::get().acquire(key, load);
+        });
+  m.def("release_context", [](const std::string &key, py::object context) {
+    ContextPool::get().release(key, std::move(context));
   });
+  m.def("retire_context", [](py::object context) {
+    ContextPool::get().retire(std::move(context));
+  });
+  m.def("clear_context_pool", []() { ContextPool::get().clear(); });
 
   py::class_<Type>(m, "type", py::module_local())
       .def("is_integer",
@@ -1670,9 +1858,38 @@ void init_triton_ir(py::module &&m) {
           self.enableTiming();
         }
 
-        if (failed(self.run(mod.getOperation())))
+        if (PassTelemetry::isEnabled()) {
+          self.addInstrumentation(
+              std::make_unique<PassTelemetryInstrumentation>(
+                  PassTelemetry::get()));
+        }
+
+        LogicalResult result = success();
+        {
+          // Passes don't call back into Python, so other threads can compile
+          // modules owned by different contexts in the meantime.
+          py::gil_scoped_release allow_threads;
+          result = self.run(mod.getOperation());
+        }
+        if (failed(result))
           throw std::runtime_error("PassManager::run failed");
       });
+
+  // Returns the statistics of the MLIR and LLVM passes run on this thread
+  // since the last call, when TRITON_COMPILE_TELEMETRY is set.
+  m.def("take_pass_telemetry", []() {
+    py::list ret;
+    for (const PassRecord &record : PassTelemetry::get().take()) {
+      py::dict entry;
+      entry["pass"] = record.pass;
+      entry["time"] = record.seconds;
+      entry["runs"] = record.runs;
+      entry["ops"] = record.numOps;
+      entry["peak_rss"] = record.peakRssKb;
+      ret.append(entry);
+    }
+    return ret;
+  });
 }
 
 void init_triton_env_vars(py::module &m) {
@@ -1,8 +1,10 @@
 ﻿#include "mlir/IR/BuiltinOps.h" // mlir::ModuleOp
 #include "mlir/Target/LLVMIR/LLVMTranslationInterface.h"
 #include "mlir/Target/LLVMIR/ModuleTranslation.h"
+#include "telemetry.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -24,6 +26,7 @@
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include <csignal>
+#include <mutex>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <stdexcept>
@@ -39,6 +42,30 @@ struct BreakStructPhiNodesPass : PassInfoMixin<BreakStructPhiNodesPass> {
 
 using namespace llvm;
 
+// LLVM command line options are process-wide. Modules may be compiled from
+// several threads at once (the GIL is released), so updates are serialized.
+static std::mutex &getOptionsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+using mlir::triton::PassTelemetry;
+
+// Returns the number of instructions in the unit of IR a pass ran on.
+static int64_t getInstructionCount(const Any &ir) {
+  if (const auto *mod = llvm::any_cast<const Module *>(&ir))
+    return (*mod)->getInstructionCount();
+  if (const auto *func = llvm::any_cast<const Function *>(&ir))
+    return (*func)->getInstructionCount();
+  if (const auto *loop = llvm::any_cast<const Loop *>(&ir)) {
+    int64_t count = 0;
+    for (const BasicBlock *block : (*loop)->blocks())
+      count += block->size();
+    return count;
+  }
+  return 0;
+}
+
 std::string translateLLVMIRToASM(llvm::Module &module,
                                  const std::string &triple,
                                  const std::string &proc,
@@ -47,6 +74,7 @@ std::string translateLLVMIRToASM(llvm::Module &module,
                                  bool enable_fp_fusion, bool isObject) {
   using namespace mlir;
   // options
+  std::unique_lock<std::mutex> optionsLock(getOptionsMutex());
   auto options = llvm::cl::getRegisteredOptions();
   for (std::string flag : flags) {
     auto *shortPtr = static_cast<llvm::cl::opt<bool> *>(options[flag]);
@@ -76,6 +104,7 @@ std::string translateLLVMIRToASM(llvm::Module &module,
       }
     }
   }
+  optionsLock.unlock();
 
   // inline everything
   for (llvm::Function &f : module.functions())
@@ -92,7 +121,14 @@ std::string translateLLVMIRToASM(llvm::Module &module,
     llvm::TimePassesPerRun = true;
   }
 
+  const bool enabledTelemetry = PassTelemetry::isEnabled();
+  auto start = PassTelemetry::Clock::now();
   pm.run(module);
+  // The legacy pass managers are not instrumented pass by pass, each of them
+  // is reported as a whole.
+  if (enabledTelemetry)
+    PassTelemetry::get().record("always-inline", start,
+                                module.getInstructionCount());
 
   SmallString<0> timePassesStr;
   raw_svector_ostream reportStream(timePassesStr);
@@ -137,7 +173,11 @@ std::string translateLLVMIRToASM(llvm::Module &module,
     auto fileType = isObject ? llvm::CodeGenFileType::ObjectFile
                              : llvm::CodeGenFileType::AssemblyFile;
     machine->addPassesToEmitFile(pass, pstream, nullptr, fileType);
+    start = PassTelemetry::Clock::now();
     pass.run(module);
+    if (enabledTelemetry)
+      PassTelemetry::get().record("codegen", start,
+                                  module.getInstructionCount());
 
     if (enabledTiming) {
       reportAndResetTimings(&reportStream);
@@ -248,7 +288,7 @@ void init_triton_llvm(py::module &&m) {
       [](mlir::ModuleOp &mod, llvm::LLVMContext &ctx) {
         return mlir::translateModuleToLLVMIR(mod, ctx);
       },
-      py::keep_alive<0, 2>());
+      py::keep_alive<0, 2>(), py::call_guard<py::gil_scoped_release>());
 
   m.def("attach_datalayout", [](llvm::Module *mod, const std::string triple,
                                 const std::string proc,
@@ -269,11 +309,14 @@ void init_triton_llvm(py::module &&m) {
 
   m.def("optimize_module", [](llvm::Module *mod,
                               const llvm::OptimizationLevel &opt) {
+    // when allow_threads goes out of scope, gil will be acquired again
+    py::gil_scoped_release allow_threads;
     if (mlir::triton::tools::getBoolEnv("DISABLE_LLVM_OPT"))
       return;
     // Check to see if we are passing a list of flags to disable optimizations.
     auto flagList = mlir::triton::tools::getStrEnv("DISABLE_LLVM_OPT");
     if (!flagList.empty()) {
+      std::lock_guard<std::mutex> lock(getOptionsMutex());
       auto options = llvm::cl::getRegisteredOptions();
       llvm::SmallVector<StringRef, 3> split;
       StringRef(flagList.c_str()).split(split, ',');
@@ -296,6 +339,7 @@ void init_triton_llvm(py::module &&m) {
     StandardInstrumentations standardInstr(mod->getContext(),
                                            /*DebugLogging*/ true);
     if (mlir::triton::tools::getBoolEnv("LLVM_IR_ENABLE_DUMP")) {
+      std::lock_guard<std::mutex> lock(getOptionsMutex());
       auto optMap = llvm::cl::getRegisteredOptions();
       auto optIt = optMap.find("print-after-all");
       if (optIt != optMap.end()) {
@@ -306,6 +350,39 @@ void init_triton_llvm(py::module &&m) {
       instrCbPtr = &passInstrCb;
     }
 
+    // Pass managers and adaptors only run nested passes, which are reported
+    // on their own.
+    std::vector<PassTelemetry::Clock::time_point> passStarts;
+    auto isReported = [](StringRef pass) {
+      return !isSpecialPass(
+          pass, {"PassManager", "PassAdaptor", "AnalysisManagerProxy"});
+    };
+    if (PassTelemetry::isEnabled()) {
+      PassTelemetry &telemetry = PassTelemetry::get();
+      passInstrCb.registerBeforeNonSkippedPassCallback(
+          [&](StringRef pass, Any) {
+            if (isReported(pass))
+              passStarts.push_back(PassTelemetry::Clock::now());
+          });
+      passInstrCb.registerAfterPassCallback(
+          [&](StringRef pass, Any ir, const PreservedAnalyses &) {
+            if (!isReported(pass))
+              return;
+            telemetry.record(pass.str(), passStarts.back(),
+                             getInstructionCount(ir));
+            passStarts.pop_back();
+          });
+      // The IR the pass ran on is gone, e.g. a deleted function.
+      passInstrCb.registerAfterPassInvalidatedCallback(
+          [&](StringRef pass, const PreservedAnalyses &) {
+            if (!isReported(pass))
+              return;
+            telemetry.record(pass.str(), passStarts.back(), 0);
+            passStarts.pop_back();
+          });
+      instrCbPtr = &passInstrCb;
+    }
+
     PipelineTuningOptions tuningOptions;
     tuningOptions.LoopUnrolling = true;
     tuningOptions.LoopInterleaving = true;
@@ -387,6 +464,29 @@ void init_triton_llvm(py::module &&m) {
       },
       ret::take_ownership);
 
+  // Same as above, but consumes an in-memory module (e.g. the one produced by
+  // `to_module` + `optimize_module`) instead of re-parsing its textual form.
+  // The module is mutated in place (target triple, data layout, inlining), so
+  // callers must not reuse it afterwards.
+  m.def(
+      "translate_to_asm",
+      [](llvm::Module *module, std::string triple, std::string proc,
+         std::string features, std::vector<std::string> flags,
+         bool enable_fp_fusion, bool isObject) -> py::object {
+        std::string obj;
+        {
+          // when allow_threads goes out of scope, gil will be released
+          py::gil_scoped_release allow_threads;
+          obj = translateLLVMIRToASM(*module, triple, proc, features, flags,
+                                     enable_fp_fusion, isObject);
+        }
+        if (isObject)
+          return py::bytes(obj);
+        else
+          return py::str(obj);
+      },
+      ret::take_ownership);
+
   m.def("init_targets", []() {
     static std::once_flag init_flag;
     std::call_once(init_flag, []() {
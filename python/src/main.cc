@@ -36,6 +36,8 @@ namespace py = pybind11;
 #define INIT_BACKEND(name) init_triton_##name(m.def_submodule(#name));
 
 void init_triton_env_vars(pybind11::module &m);
+void init_triton_cache(pybind11::module &&m);
+void init_triton_dispatch(pybind11::module &&m);
 void init_triton_ir(pybind11::module &&m);
 void init_triton_llvm(pybind11::module &&m);
 void init_triton_interpreter(pybind11::module &&m);
@@ -51,5 +53,7 @@ PYBIND11_MODULE(libtriton, m) {
   init_triton_passes(m.def_submodule("passes"));
   init_triton_interpreter(m.def_submodule("interpreter"));
   init_triton_llvm(m.def_submodule("llvm"));
+  init_triton_cache(m.def_submodule("cache"));
+  init_triton_dispatch(m.def_submodule("dispatch"));
   FOR_EACH_P(INIT_BACKEND, TRITON_BACKENDS_TUPLE)
 }
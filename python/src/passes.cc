@@ -7,6 +7,7 @@
 #include "triton/Analysis/Membar.h"
 #include "triton/Conversion/TritonGPUToLLVM/Passes.h"
 #include "triton/Conversion/TritonToTritonGPU/Passes.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/Triton/Transforms/Passes.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "triton/Target/LLVMIR/Passes.h"
@@ -17,7 +18,13 @@ namespace py = pybind11;
 
 void init_triton_analysis(py::module &&m) {
   py::class_<mlir::ModuleAllocation>(m, "allocation", py::module_local())
-      .def(py::init<mlir::ModuleOp>());
+      .def(py::init<mlir::ModuleOp>())
+      .def("get_shared_memory_size",
+           [](mlir::ModuleAllocation &self) {
+             return self.getSharedMemorySize();
+           })
+      .def("get_peak_live_size", &mlir::ModuleAllocation::getPeakLiveSize)
+      .def("get_fragmentation", &mlir::ModuleAllocation::getFragmentation);
   py::class_<mlir::ModuleMembarAnalysis>(m, "membar", py::module_local())
       .def(py::init<mlir::ModuleAllocation *>())
       .def("run", &mlir::ModuleMembarAnalysis::run);
@@ -50,15 +57,15 @@ void init_triton_passes_ttgpuir(py::module &&m) {
   ADD_PASS_WRAPPER_0("add_optimize_thread_locality",
                      createTritonGPUOptimizeThreadLocality);
   ADD_PASS_OPTION_WRAPPER_1("add_pipeline", createTritonGPUPipeline, int);
-  ADD_PASS_WRAPPER_0("add_prefetch", createTritonGPUPrefetch);
+  ADD_FUNCTION_PASS_WRAPPER_0("add_prefetch", createTritonGPUPrefetch);
   ADD_PASS_WRAPPER_0("add_accelerate_matmul", createTritonGPUAccelerateMatmul);
-  ADD_PASS_WRAPPER_0("add_reorder_instructions",
-                     createTritonGPUReorderInstructions);
+  ADD_FUNCTION_PASS_WRAPPER_0("add_reorder_instructions",
+                              createTritonGPUReorderInstructions);
   ADD_PASS_WRAPPER_0("add_f32_dot_tc", createTritonGPUF32DotTC);
   ADD_PASS_OPTION_WRAPPER_1("add_optimize_dot_operands",
                             createTritonGPUOptimizeDotOperands, bool);
-  ADD_PASS_WRAPPER_0("add_remove_layout_conversions",
-                     createTritonGPURemoveLayoutConversions);
+  ADD_FUNCTION_PASS_WRAPPER_0("add_remove_layout_conversions",
+                              createTritonGPURemoveLayoutConversions);
   ADD_PASS_WRAPPER_0("add_reduce_data_duplication",
                      createTritonGPUReduceDataDuplication);
   ADD_PASS_WRAPPER_0("add_allocate_shared_memory",
@@ -1,6 +1,14 @@
 #define ADD_PASS_WRAPPER_0(name, builder)                                      \
   m.def(name, [](mlir::PassManager &pm) { pm.addPass(builder()); })
 
+// Function-local passes are nested on `tt.func`, so that the pass manager runs
+// them on the functions of a module in parallel. Adjacent nested passes form a
+// single pipeline per function.
+#define ADD_FUNCTION_PASS_WRAPPER_0(name, builder)                             \
+  m.def(name, [](mlir::PassManager &pm) {                                      \
+    pm.addNestedPass<mlir::triton::FuncOp>(builder());                         \
+  })
+
 #define ADD_PASS_WRAPPER_1(name, builder, ty0)                                 \
   m.def(name,                                                                  \
         [](mlir::PassManager &pm, ty0 val0) { pm.addPass(builder(val0)); })
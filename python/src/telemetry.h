@@ -0,0 +1,88 @@
+#ifndef TRITON_PYTHON_SRC_TELEMETRY_H
+#define TRITON_PYTHON_SRC_TELEMETRY_H
+
+#include "triton/Tools/Sys/GetEnv.hpp"
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mlir::triton {
+
+// Per-pass statistics gathered while compiling with
+// TRITON_COMPILE_TELEMETRY=1. A pass that runs several times (e.g. once per
+// function) is reported once, with its runs accumulated.
+struct PassRecord {
+  std::string pass;
+  // Wall time spent in the pass, over all of its runs.
+  double seconds = 0;
+  int64_t runs = 0;
+  // Number of operations (MLIR) or instructions (LLVM) in the IR the pass ran
+  // on, summed over its runs and measured after each of them.
+  int64_t numOps = 0;
+  // Peak resident set size of the process after the last run of the pass.
+  int64_t peakRssKb = 0;
+};
+
+// Collects the records of the passes run on behalf of one thread. Pass
+// managers may run nested passes on worker threads, so recording is
+// serialized; the records are handed back to Python on the compiling thread.
+class PassTelemetry {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static bool isEnabled() {
+    return tools::getBoolEnv("TRITON_COMPILE_TELEMETRY");
+  }
+
+  static PassTelemetry &get() {
+    static thread_local PassTelemetry telemetry;
+    return telemetry;
+  }
+
+  static int64_t getPeakRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+      return 0;
+    // ru_maxrss is in kilobytes on Linux.
+    return usage.ru_maxrss;
+  }
+
+  void record(const std::string &pass, Clock::time_point start,
+              int64_t numOps) {
+    double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    int64_t peakRssKb = getPeakRssKb();
+    std::lock_guard<std::mutex> lock(mutex);
+    PassRecord *entry = nullptr;
+    for (PassRecord &r : records)
+      if (r.pass == pass)
+        entry = &r;
+    if (!entry)
+      entry = &records.emplace_back(PassRecord{pass});
+    entry->seconds += seconds;
+    entry->runs += 1;
+    entry->numOps += numOps;
+    entry->peakRssKb = peakRssKb;
+  }
+
+  // Returns the records gathered since the last call, in the order the passes
+  // first ran.
+  std::vector<PassRecord> take() {
+    std::vector<PassRecord> result;
+    std::lock_guard<std::mutex> lock(mutex);
+    result.swap(records);
+    return result;
+  }
+
+private:
+  std::mutex mutex;
+  std::vector<PassRecord> records;
+};
+
+} // namespace mlir::triton
+
+#endif // TRITON_PYTHON_SRC_TELEMETRY_H
@@ -1,3 +1,5 @@
+import time
+
 import pytest
 import torch
 
@@ -265,3 +267,34 @@ def test_reductions(N, dtype_str):
     cur_gpu_util = cur_gpu_perf / max_gpu_perf
     print_perf(ms, cur_gpu_util, ref_gpu_util)
     triton.testing.assert_close(cur_gpu_util, ref_gpu_util, atol=0.02, rtol=0.01)
+
+
+#######################
+# Compilation setup
+#######################
+
+
+def test_context_setup():
+    # Overhead of setting up the MLIR context of a compilation, with and without the context pool
+    ir = triton._C.libtriton.ir
+    target = triton.runtime.driver.active.get_current_target()
+    backend = triton.compiler.compiler.make_backend(target)
+    n = 100
+
+    start = time.perf_counter()
+    for _ in range(n):
+        context = ir.context()
+        ir.load_dialects(context)
+        backend.load_dialects(context)
+        context.disable_multithreading()
+    fresh_ms = (time.perf_counter() - start) * 1e3 / n
+
+    ir.clear_context_pool()
+    ir.release_context(target.backend, ir.acquire_context(target.backend, backend.load_dialects))
+    start = time.perf_counter()
+    for _ in range(n):
+        ir.release_context(target.backend, ir.acquire_context(target.backend, backend.load_dialects))
+    pooled_ms = (time.perf_counter() - start) * 1e3 / n
+
+    print(f'fresh: {fresh_ms:.3f} ms \t pooled: {pooled_ms:.3f} ms', end='\t')
+    assert pooled_ms < fresh_ms
@@ -86,6 +86,40 @@ def test_hooks(device):
         assert values["has_exception"] is False
 
 
+def test_pipeline_compile(device):
+    N = 4096
+    src = torch.zeros(N, device=device)
+
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 4096}), triton.Config(kwargs={'BLOCK_SIZE': 32})]
+    exceptions = []
+
+    def _post_hook(*args, exception):
+        if exception is not None:
+            exceptions.append(exception)
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, post_hook=_post_hook, pipeline_compile=True)
+    @triton.jit
+    def _kernel(src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.arange(0, BLOCK_SIZE)
+        max_iters = tl.cdiv(N, BLOCK_SIZE)
+        # Same as in `test_hooks`, the first config is out of resources on NVIDIA GPUs
+        for _ in tl.range(max_iters, num_stages=100):
+            x = tl.load(src + offsets, mask=offsets < N)
+            tl.store(src + offsets, x + 1, mask=offsets < N)
+            offsets += BLOCK_SIZE
+
+    _kernel[(1, )](src, N)
+    assert list(_kernel.configs_timings.keys()) == configs
+    # The config that doesn't fit is discarded before being launched
+    assert not exceptions
+    if triton.runtime.driver.active.get_current_target().backend == "cuda":
+        assert _kernel.configs_timings[configs[0]] == [float("inf")] * 3
+        assert _kernel.best_config == configs[1]
+    src.zero_()
+    _kernel[(1, )](src, N)
+    triton.testing.assert_close(src, torch.ones_like(src))
+
+
 @pytest.mark.parametrize('with_perf_model', [False, True])
 def test_prune_configs(with_perf_model: bool, device: str):
     N = 1024
@@ -130,3 +164,34 @@ def test_prune_configs(with_perf_model: bool, device: str):
         assert records['run_early_config_prune']
         assert records['capture_kwargs']
         assert records['capture_named_args']
+
+
+def test_cache_results(device, fresh_triton_cache):
+    N = 1024
+    src = torch.randn(N, device=device)
+    dst = torch.empty(N, device=device)
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 32}), triton.Config(kwargs={'BLOCK_SIZE': 128})]
+
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    # A new autotuner stands for a new process, which reuses the stored result
+    benchmarked = []
+    for _ in range(2):
+        kernel = triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, cache_results=True)(_kernel)
+        bench = kernel._bench
+        kernel._bench = lambda *args, config, **kwargs: benchmarked.append(config) or bench(
+            *args, config=config, **kwargs)
+        kernel[grid](dst, src, N)
+        torch.testing.assert_close(src, dst)
+    assert benchmarked == configs
+    assert kernel.best_config in configs
+
+    from triton.runtime.cache import AutotuneDatabase
+    (key, entry), = AutotuneDatabase().items()
+    assert entry["name"] == "_kernel"
+    assert entry["config"] == str(kernel.best_config)
@@ -104,3 +104,36 @@ def test_python_func_in_visit_call(device):
     x = torch.randn(4, device=device)
     out = torch.zeros_like(x)
     test_py_call_const_kernel[(4, )](x, out, 4, 4)
+
+
+def test_context_pool():
+    ir = triton._C.libtriton.ir
+    target = triton.runtime.driver.active.get_current_target()
+    backend = triton.compiler.compiler.make_backend(target)
+    ir.clear_context_pool()
+    loaded = []
+
+    def load_dialects(context):
+        loaded.append(context)
+        backend.load_dialects(context)
+
+    context = ir.acquire_context("test", load_dialects)
+    ir.release_context("test", context)
+    # The idle context is handed out again, with its dialects loaded
+    assert ir.acquire_context("test", load_dialects) is context
+    # Contexts are only handed out once at a time
+    other = ir.acquire_context("test", load_dialects)
+    assert other is not context
+    assert loaded == [context, other]
+    ir.release_context("test", other)
+    ir.release_context("test", context)
+    # Contexts are pooled by key
+    assert ir.acquire_context("other", load_dialects) not in [context, other]
+    ir.clear_context_pool()
+    assert ir.acquire_context("test", load_dialects) not in [context, other]
+    # A retired context is never pooled again
+    retired = ir.acquire_context("test", load_dialects)
+    ir.retire_context(retired)
+    ir.release_context("test", retired)
+    assert ir.acquire_context("test", load_dialects) is not retired
+    ir.clear_context_pool()
@@ -1,7 +1,11 @@
+import hashlib
 import importlib.util
 import itertools
+import os
+import pathlib
 import shutil
 import tempfile
+import threading
 
 import pytest
 import torch
@@ -577,3 +581,414 @@ def test_hooks(fresh_triton_cache) -> None:
     assert specialization_data is not None and specialization_data_compiled == specialization_data
     assert is_warmup is True
     assert key in kernel_add.cache[torch.cuda.current_device()]
+
+
+def test_async_compile(device, fresh_triton_cache) -> None:
+
+    @triton.jit(async_compile=True)
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    @triton.jit
+    def fallback_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    a = torch.randn(33, device=device)
+    b = torch.randn(33, device=device)
+    o = torch.zeros(33, device=device)
+    # Without anything to launch meanwhile, the first launch waits for the compilation
+    general = kernel_add[(1, )](a[1:], b[1:], o[1:], 16)
+    assert torch.equal(o[1:17], a[1:17] + b[1:17])
+
+    # Hold the background compilations back
+    release = threading.Event()
+    compile = kernel_add.compile
+
+    def wait_and_compile(*args, **kwargs):
+        release.wait()
+        return compile(*args, **kwargs)
+
+    kernel_add.compile = wait_and_compile
+    # The kernel compiled without `divisible_by_16` runs while the aligned specialization compiles
+    assert kernel_add[(1, )](a, b, o, 16) is general
+    assert torch.equal(o[:16], a[:16] + b[:16])
+    # Otherwise the fallback runs
+    fallback = fallback_add.warmup(a, b, o, 32, grid=(1, ))
+    kernel_add.set_fallback(fallback_add)
+    o.zero_()
+    assert kernel_add[(1, )](a, b, o, 32) is fallback
+    assert torch.equal(o[:32], a[:32] + b[:32])
+
+    release.set()
+    current_device = triton.runtime.driver.active.get_current_device()
+    for future in list(kernel_add.compiling[current_device].values()):
+        future.result()
+    assert len(kernel_add.compiling[current_device]) == 0
+    assert len(kernel_add.cache[current_device]) == 3
+    specialized = kernel_add[(1, )](a, b, o, 16)
+    assert specialized is not general and specialized in kernel_add.cache[current_device].values()
+
+
+def test_fast_dispatch(device, fresh_triton_cache) -> None:
+
+    @triton.jit
+    def kernel_fill(o, value, n, BLOCK: tl.constexpr):
+        idx = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        tl.store(o + idx, value, mask=idx < n)
+
+    counter = 0
+
+    def inc_counter(*args, **kwargs):
+        nonlocal counter
+        counter += 1
+
+    JITFunction.cache_hook = inc_counter
+    o = torch.zeros(100, dtype=torch.int32, device=device)
+    grid = lambda meta: (triton.cdiv(meta["n"], meta["BLOCK"]), )
+    first = kernel_fill[grid](o, 3, 100, BLOCK=32)
+    current_device = triton.runtime.driver.active.get_current_device()
+    assert len(kernel_fill.dispatchers[current_device]) == 1
+
+    # Launches with the same specialization don't go through the Python binder
+    binder = kernel_fill.binder
+
+    def fail(*args, **kwargs):
+        raise AssertionError("slow path")
+
+    kernel_fill.binder = fail
+    assert kernel_fill[grid](o, 5, 100, BLOCK=32) is first
+    assert torch.all(o == 5)
+    with pytest.raises(AssertionError, match="slow path"):
+        kernel_fill[grid](o, 1, 100, BLOCK=32)
+    with pytest.raises(AssertionError, match="slow path"):
+        kernel_fill[grid](o, 5, 100, BLOCK=64)
+    kernel_fill.binder = binder
+    assert counter == 1
+
+    # Kernels dropped from the cache are compiled again
+    kernel_fill.cache[current_device].clear()
+    assert kernel_fill[grid](o, 7, 100, BLOCK=32) is not first
+    assert torch.all(o == 7)
+    JITFunction.cache_hook = None
+    assert counter == 2
+
+
+def test_compile_batch(fresh_triton_cache) -> None:
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    srcs = [
+        triton.compiler.ASTSource(fn=kernel_add, signature={0: "*fp32", 1: "*fp32", 2: "*fp32"}, constants={3: n})
+        for n in [16, 32, 64, 128]
+    ]
+    options = [{"num_warps": num_warps} for num_warps in [1, 2, 4, 8]]
+    kernels = triton.compile_batch(srcs, options=options, max_workers=4)
+    assert [kernel.metadata.num_warps for kernel in kernels] == [1, 2, 4, 8]
+    assert len({kernel.hash for kernel in kernels}) == len(srcs)
+    # Batched and sequential compilations produce the same kernels
+    shutil.rmtree(fresh_triton_cache)
+    for src, opts, kernel in zip(srcs, options, kernels):
+        assert triton.compile(src, options=opts).asm == kernel.asm
+
+
+def test_compile_telemetry(fresh_triton_cache, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_COMPILE_TELEMETRY", "1")
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    src = triton.compiler.ASTSource(fn=kernel_add, signature={0: "*fp32", 1: "*fp32", 2: "*fp32"}, constants={3: 32})
+    telemetry = triton.compile(src).metadata.compile_telemetry
+    stages = [record["stage"] for record in telemetry]
+    assert stages[0] == "source"
+    assert {"ttir", "ttgir", "llir"} <= set(stages)
+    assert all(record["time"] >= 0 for record in telemetry)
+    passes = {record["pass"]: record for stage in telemetry for record in stage["passes"]}
+    # MLIR passes, LLVM passes and code generation are all reported
+    assert {"tritongpu-coalesce", "canonicalize", "InstCombinePass", "codegen"} <= set(passes)
+    for record in passes.values():
+        assert record["time"] >= 0 and record["runs"] >= 1 and record["peak_rss"] > 0
+    assert passes["tritongpu-coalesce"]["ops"] > 0
+    # The telemetry of the compilation is kept with the cached kernel
+    assert triton.compile(src).metadata.compile_telemetry == telemetry
+
+
+def test_kernel_store(tmp_path) -> None:
+    from triton._C.libtriton import cache
+    path = str(tmp_path / "kernels.store")
+    store = cache.store(path)
+    assert store.get("a") is None
+    store.put("a", b"abc")
+    store.put("b", b"\x00" * 13)
+    assert bytes(store.get("a")) == b"abc"
+    # Records written by another store are visible after a miss
+    other = cache.store(path)
+    assert bytes(other.get("b")) == b"\x00" * 13
+    other.put("c", b"xyz")
+    assert bytes(store.get("c")) == b"xyz"
+    assert len(store) == 3
+    # Records appended after a torn record are visible
+    with open(path, "ab") as f:
+        f.write(b"torn")
+    assert store.get("d") is None
+    other.put("d", b"d")
+    assert bytes(store.get("d")) == b"d"
+    # A removed store is started again by the next writer, and the views of the old one stay valid
+    view = store.get("a")
+    os.remove(path)
+    store.put("e", b"e")
+    assert bytes(view) == b"abc"
+    assert cache.store(path).get("a") is None and bytes(cache.store(path).get("e")) == b"e"
+    # Compaction drops the records of the other keys, and the views of the old file stay valid
+    view = store.get("e")
+    assert other.compact(lambda key: key != "e") == os.path.getsize(path)
+    assert cache.store(path).get("e") is None
+    assert bytes(view) == b"e"
+    # Writers switch to the compacted file
+    store.put("f", b"f")
+    assert bytes(cache.store(path).get("f")) == b"f"
+
+
+def test_mmap_cache_manager(fresh_triton_cache, monkeypatch) -> None:
+    # Restore the default cache manager after the test
+    for name in ["__cache_cls", "__cache_cls_nme"]:
+        monkeypatch.setattr(triton.runtime.cache, name, getattr(triton.runtime.cache, name))
+    monkeypatch.setenv("TRITON_CACHE_MANAGER", "triton.runtime.cache:MmapCacheManager")
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    src = triton.compiler.ASTSource(fn=kernel_add, signature={0: "*fp32", 1: "*fp32", 2: "*fp32"}, constants={3: 32})
+    kernel = triton.compile(src)
+    assert os.path.exists(os.path.join(fresh_triton_cache, "kernels.store"))
+    # The cached kernel is loaded from the store
+    cached_kernel = triton.compile(src)
+    assert isinstance(cached_kernel.kernel, memoryview)
+    assert bytes(cached_kernel.kernel) == bytes(kernel.kernel)
+    assert cached_kernel.metadata == kernel.metadata
+
+
+def test_mmap_cache_eviction(fresh_triton_cache, monkeypatch) -> None:
+    from triton._C.libtriton import cache
+    from triton.runtime.cache import STORE_NAME, MmapCacheManager, _base64, evict
+    monkeypatch.setattr(MmapCacheManager, "_stores", {})
+    monkeypatch.setenv("TRITON_CACHE_COMPRESS", "1")
+
+    def make_manager(i):
+        return MmapCacheManager(_base64(hashlib.sha256(str(i).encode()).hexdigest()))
+
+    managers = [make_manager(i) for i in range(3)]
+    for i, manager in enumerate(managers):
+        manager.put(b"x" * 1000, "kernel.cubin")
+        manager.put_group("kernel.json", {"kernel.cubin": manager.get_file("kernel.cubin")})
+        os.utime(manager.cache_dir, (i, i))
+    # The records of the store are never compressed, and are returned without a copy
+    data = managers[0].get_group_contents("kernel.json")["kernel.cubin"]
+    assert isinstance(data, memoryview) and bytes(data) == b"x" * 1000
+    # The store counts towards the size of the cache
+    store_path = os.path.join(fresh_triton_cache, STORE_NAME)
+    store_size = os.path.getsize(store_path)
+    files_size = sum(f.stat().st_size for m in managers for f in os.scandir(m.cache_dir))
+    assert evict(fresh_triton_cache, store_size + files_size) == 0
+    # Evicting a key drops its records from the store, and keeps the others
+    assert evict(fresh_triton_cache, store_size + files_size - 1) > 0
+    assert [os.path.exists(m.cache_dir) for m in managers] == [False, True, True]
+    assert os.path.getsize(store_path) < store_size
+    assert len(cache.store(store_path)) == 4
+    assert bytes(make_manager(1).get_group_contents("kernel.json")["kernel.cubin"]) == b"x" * 1000
+    # With a maximum size, the keys removed since the store was compacted aren't served from it
+    monkeypatch.setenv("TRITON_CACHE_MAX_SIZE", "1M")
+    shutil.rmtree(managers[1].cache_dir)
+    assert make_manager(1).get_group_contents("kernel.json") is None
+    assert make_manager(2).get_group_contents("kernel.json") is not None
+
+
+def test_lazy_artifacts(fresh_triton_cache, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_IR", "all")
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    src = triton.compiler.ASTSource(fn=kernel_add, signature={0: "*fp32", 1: "*fp32", 2: "*fp32"}, constants={3: 32})
+    kernel = triton.compile(src)
+    read_bytes = pathlib.Path.read_bytes
+    reads = []
+
+    def counting_read_bytes(path):
+        reads.append(path.suffix)
+        return read_bytes(path)
+
+    monkeypatch.setattr(pathlib.Path, "read_bytes", counting_read_bytes)
+    cached_kernel = triton.compile(src)
+    # Only the metadata and the binary are read on a cache hit
+    assert not {".ttir", ".ttgir", ".llir"} & set(reads)
+    assert cached_kernel.asm["ttgir"] == kernel.asm["ttgir"]
+    assert ".ttgir" in reads
+    assert set(cached_kernel.asm) == set(kernel.asm)
+    # Kernels with the same metadata fields share their type
+    assert type(cached_kernel.metadata) is type(kernel.metadata)
+
+
+def test_ir_retention(fresh_triton_cache, monkeypatch) -> None:
+    monkeypatch.delenv("TRITON_CACHE_IR", raising=False)
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    def cached_files():
+        return {os.path.splitext(f)[1] for _, _, files in os.walk(fresh_triton_cache) for f in files}
+
+    src = triton.compiler.ASTSource(fn=kernel_add, signature={0: "*fp32", 1: "*fp32", 2: "*fp32"}, constants={3: 32})
+    kernel = triton.compile(src)
+    binary_ext = f".{triton.compiler.make_backend(kernel.metadata.target).binary_ext}"
+    # Only the binary and the metadata are stored by default, the IR of a new kernel stays in memory
+    assert cached_files() == {".json", binary_ext}
+    assert kernel.asm.regenerate is None
+    assert "tt.func" in kernel.asm["ttgir"]
+    # Looking up the stages of a kernel loaded from the cache doesn't compile it again
+    cached_kernel = triton.compile(src)
+    assert "ttgir" in cached_kernel.asm and "unknown" not in cached_kernel.asm
+    assert set(cached_kernel.asm) == set(kernel.asm)
+    assert cached_kernel.asm.regenerate is not None
+    # The IR is regenerated in memory when it is accessed, and isn't added to the cache
+    assert cached_kernel.asm["ttgir"] == kernel.asm["ttgir"]
+    assert bytes(cached_kernel.asm[binary_ext[1:]]) == bytes(kernel.asm[binary_ext[1:]])
+    assert cached_files() == {".json", binary_ext}
+
+
+def test_ir_loc_uncompressed(fresh_triton_cache, monkeypatch) -> None:
+    from triton.runtime.cache import COMPRESSED_MAGIC
+    monkeypatch.setenv("TRITON_CACHE_COMPRESS", "1")
+    monkeypatch.setenv("USE_IR_LOC", "ttir")
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    src = triton.compiler.ASTSource(fn=kernel_add, signature={0: "*fp32", 1: "*fp32", 2: "*fp32"}, constants={3: 32})
+    triton.compile(src)
+    ttir_paths = [
+        os.path.join(root, f) for root, _, files in os.walk(fresh_triton_cache) for f in files if f.endswith(".ttir")
+    ]
+    assert len(ttir_paths) == 1
+    # The locations of the kernel point into the file, which is stored as text
+    data = pathlib.Path(ttir_paths[0]).read_bytes()
+    assert not data.startswith(COMPRESSED_MAGIC)
+    assert "tt.func" in data.decode("utf-8")
+
+
+def test_cache_compression(fresh_triton_cache, monkeypatch) -> None:
+    from triton.runtime.cache import COMPRESSED_MAGIC, FileCacheManager, read_file
+
+    # Files are stored as is by default
+    path = FileCacheManager(hashlib.sha256(b"default").hexdigest()).put("x" * 1000, "kernel.ttir")
+    assert pathlib.Path(path).read_bytes() == b"x" * 1000
+    monkeypatch.setenv("TRITON_CACHE_COMPRESS", "1")
+    manager = FileCacheManager(hashlib.sha256(b"compressed").hexdigest())
+    path = manager.put("x" * 1000, "kernel.ttir")
+    data = pathlib.Path(path).read_bytes()
+    assert data.startswith(COMPRESSED_MAGIC) and len(data) < 100
+    assert read_file(path) == b"x" * 1000
+    # Shared libraries are loaded from their path
+    assert pathlib.Path(manager.put(b"\x7fELF", "launcher.so")).read_bytes() == b"\x7fELF"
+    # Uncompressed files are read as is
+    assert read_file(FileCacheManager(hashlib.sha256(b"default").hexdigest()).get_file("kernel.ttir")) == b"x" * 1000
+
+
+def test_cache_eviction(fresh_triton_cache, monkeypatch) -> None:
+    from triton.runtime.cache import FileCacheManager, _base64, evict
+    monkeypatch.setenv("TRITON_CACHE_COMPRESS", "0")
+
+    def make_manager(i):
+        return FileCacheManager(_base64(hashlib.sha256(str(i).encode()).hexdigest()))
+
+    managers = [make_manager(i) for i in range(4)]
+    for i, manager in enumerate(managers):
+        manager.put(b"x" * 1000, "kernel.cubin")
+        manager.put_group("kernel.json", {"kernel.cubin": manager.get_file("kernel.cubin")})
+        os.utime(manager.cache_dir, (i, i))
+    # A cache hit makes a key the most recently used
+    monkeypatch.setenv("TRITON_CACHE_MAX_SIZE", "1M")
+    assert make_manager(0).get_group("kernel.json")
+    assert evict(fresh_triton_cache, 2500) > 0
+    assert [os.path.exists(m.cache_dir) for m in managers] == [True, False, False, True]
+    # Writing to a cache larger than its maximum size evicts the least recently used keys
+    monkeypatch.setenv("TRITON_CACHE_MAX_SIZE", "1K")
+    monkeypatch.setattr(FileCacheManager, "_written_since_eviction", None)
+    manager = make_manager(4)
+    manager.put(b"x" * 1000, "kernel.cubin")
+    assert os.path.exists(manager.cache_dir)
+    assert not any(os.path.exists(m.cache_dir) for m in managers)
+
+
+def test_autotune_database(tmp_path):
+    from triton.runtime.cache import AutotuneDatabase
+    db = AutotuneDatabase(str(tmp_path / "db"))
+    key = AutotuneDatabase.make_key("fn", (1024, "torch.float32"), "backend", "cuda:90:H100", ["a", "b"])
+    assert key != AutotuneDatabase.make_key("fn", (2048, "torch.float32"), "backend", "cuda:90:H100", ["a", "b"])
+    assert key != AutotuneDatabase.make_key("fn", (1024, "torch.float32"), "backend", "cuda:80:A100", ["a", "b"])
+    assert db.get(key) is None
+    db.put(key, {"config": "a"})
+    assert db.get(key) == {"config": "a"}
+    assert list(db.items()) == [(key, {"config": "a"})]
+
+    # Export to another database, which keeps its own results unless overwritten
+    other = AutotuneDatabase(str(tmp_path / "other"))
+    other.put(key, {"config": "b"})
+    assert db.export_to(str(tmp_path / "export.json")) == 1
+    assert other.import_from(str(tmp_path / "export.json"), overwrite=False) == 0
+    assert other.get(key) == {"config": "b"}
+    assert other.import_from(str(tmp_path / "export.json")) == 1
+    assert other.get(key) == {"config": "a"}
+
+    (tmp_path / "bad.json").write_text('{"version": 1, "entries": {"../key": {}}}')
+    with pytest.raises(ValueError):
+        other.import_from(str(tmp_path / "bad.json"))
+
+
+def test_autotune_database_concurrent_writers(tmp_path):
+    import threading
+    from triton.runtime.cache import AutotuneDatabase
+    db = AutotuneDatabase(str(tmp_path))
+    key = AutotuneDatabase.make_key("fn", (), "backend", "device", [])
+    entries = [{"config": str(i), "timings": [float(i)] * 1000} for i in range(4)]
+    stop = threading.Event()
+    partial = []
+
+    def read():
+        while not stop.is_set():
+            entry = db.get(key)
+            if entry is not None and entry not in entries:
+                partial.append(entry)
+
+    def write(entry):
+        for _ in range(50):
+            db.put(key, entry)
+
+    reader = threading.Thread(target=read)
+    reader.start()
+    writers = [threading.Thread(target=write, args=(entry, )) for entry in entries]
+    for writer in writers:
+        writer.start()
+    for writer in writers:
+        writer.join()
+    stop.set()
+    reader.join()
+    assert not partial
+    assert db.get(key) in entries
+    # No temporary file is left behind
+    assert os.listdir(tmp_path) == [f"{key}.json"]
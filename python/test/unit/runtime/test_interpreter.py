@@ -0,0 +1,139 @@
+import itertools
+import timeit
+
+import numpy as np
+import pytest
+import torch
+
+import triton.language as tl
+from triton._C.libtriton import interpreter as _interpreter
+from triton._C.libtriton import ir as _ir
+from triton.runtime.errors import InterpreterError
+from triton.runtime.interpreter import (InterpretedFunction, _convert_float, _convert_float_numpy, np_erf_fp32,
+                                        np_erf_fp64, np_umulhi_u64)
+
+float_dtypes = [
+    tl.float32, tl.float16, tl.bfloat16, tl.float8e5, tl.float8e5b16, tl.float8e4nv, tl.float8e4b8, tl.float8e4b15
+]
+
+
+def all_values(dtype):
+    # Every bit pattern of 8 and 16-bit types, random ones for wider types
+    bitwidth = dtype.primitive_bitwidth
+    uint_dtype = getattr(np, f"uint{bitwidth}")
+    if bitwidth <= 16:
+        return np.arange(1 << bitwidth, dtype=np.uint64).astype(uint_dtype)
+    return np.random.default_rng(0).integers(0, 1 << bitwidth, size=1 << 16, dtype=np.uint64).astype(uint_dtype)
+
+
+@pytest.mark.parametrize("src_dtype, dst_dtype", [(src, dst)
+                                                  for src, dst in itertools.permutations(float_dtypes, 2)
+                                                  if src.primitive_bitwidth != dst.primitive_bitwidth])
+@pytest.mark.parametrize("rounding_mode", [None, _ir.ROUNDING_MODE.RTNE])
+def test_convert_float(src_dtype, dst_dtype, rounding_mode):
+    data = all_values(src_dtype).reshape(16, -1)
+    expected = _convert_float_numpy(data, src_dtype, dst_dtype, rounding_mode)
+    actual = _convert_float(data, src_dtype, dst_dtype, rounding_mode)
+    assert actual.shape == data.shape
+    np.testing.assert_array_equal(actual, expected)
+
+
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_erf(dtype):
+    data = np.linspace(-4, 4, 1025, dtype=dtype).reshape(25, 41)
+    expected = np_erf_fp32(data) if dtype == np.float32 else np_erf_fp64(data)
+    np.testing.assert_array_equal(_interpreter.erf(data), expected)
+
+
+def test_umulhi():
+    rng = np.random.default_rng(0)
+    lhs, rhs = (rng.integers(0, np.iinfo(np.uint64).max, size=1024, dtype=np.uint64) for _ in range(2))
+    np.testing.assert_array_equal(_interpreter.umulhi(lhs, rhs), np_umulhi_u64(lhs, rhs))
+    signed = np.array([-1, -(1 << 62), 1 << 62, 3], dtype=np.int64)
+    np.testing.assert_array_equal(_interpreter.umulhi(signed, signed[::-1].copy()), [-1, -(1 << 60), -(1 << 60), -1])
+
+
+@pytest.mark.parametrize("dtype", [np.int8, np.float16, np.float32, np.int64])
+def test_masked_load_store(dtype):
+    src = np.arange(64).astype(dtype)
+    dst = np.zeros_like(src)
+    # Reversed and strided pointers
+    offsets = np.arange(63, -1, -1, dtype=np.uint64)[::2]
+    mask = offsets % 3 != 0
+    other = np.broadcast_to(np.array(-1, dtype=dtype), offsets.shape)
+    ptrs = src.ctypes.data + offsets * src.itemsize
+    loaded = _interpreter.load(ptrs, mask, other, src.dtype)
+    np.testing.assert_array_equal(loaded, np.where(mask, src[offsets.astype(np.int64)], other))
+    _interpreter.store(dst.ctypes.data + offsets * dst.itemsize, loaded, mask)
+    expected = np.zeros_like(src)
+    expected[offsets[mask].astype(np.int64)] = src[offsets[mask].astype(np.int64)]
+    np.testing.assert_array_equal(dst, expected)
+
+
+def _histogram_kernel(x_ptr, hist_ptr, out_ptr, BLOCK: tl.constexpr):
+    pid = tl.program_id(0) * tl.num_programs(1) + tl.program_id(1)
+    offsets = pid * BLOCK + tl.arange(0, BLOCK)
+    x = tl.load(x_ptr + offsets)
+    tl.atomic_add(hist_ptr + x % 16, 1)
+    tl.store(out_ptr + offsets, x * 2)
+
+
+@pytest.mark.parametrize("num_threads", [1, 4])
+def test_grid_threads(num_threads, monkeypatch):
+    monkeypatch.setenv("TRITON_INTERPRET_NUM_THREADS", str(num_threads))
+    BLOCK = 32
+    x = torch.randint(0, 1024, (64 * 3 * BLOCK, ), dtype=torch.int32)
+    hist = torch.zeros(16, dtype=torch.int32)
+    out = torch.empty_like(x)
+    InterpretedFunction(_histogram_kernel)[(64, 3)](x, hist, out, BLOCK=BLOCK)
+    assert torch.equal(hist, torch.bincount(x % 16, minlength=16).to(torch.int32))
+    assert torch.equal(out, x * 2)
+
+
+def _failing_kernel(x_ptr):
+    raise ValueError("program failed")
+
+
+def test_grid_threads_error(monkeypatch):
+    monkeypatch.setenv("TRITON_INTERPRET_NUM_THREADS", "4")
+    with pytest.raises(InterpreterError):
+        InterpretedFunction(_failing_kernel)[(8, )](torch.zeros(1))
+
+
+def benchmark(numel=1 << 20, repeat=5):
+    """
+    Compares the C++ fast paths of the interpreter to the numpy implementations.
+    """
+    rng = np.random.default_rng(0)
+    fp32 = rng.standard_normal(numel, dtype=np.float32)
+    fp8 = _convert_float(fp32, tl.float32, tl.float8e4nv, None)
+    u64 = rng.integers(0, np.iinfo(np.uint64).max, size=numel, dtype=np.uint64)
+    buffer = rng.standard_normal(numel, dtype=np.float32)
+    ptrs = buffer.ctypes.data + rng.permutation(numel).astype(np.uint64) * buffer.itemsize
+    mask = rng.random(numel) < 0.9
+    other = np.zeros(numel, dtype=np.float32)
+
+    def numpy_load():
+        ret = other.copy()
+        offsets = ((ptrs[mask] - buffer.ctypes.data) // buffer.itemsize).astype(np.int64)
+        ret[mask] = buffer[offsets]
+        return ret
+
+    cases = {
+        "fp32 -> bf16": (lambda: _convert_float_numpy(fp32, tl.float32, tl.bfloat16, _ir.ROUNDING_MODE.RTNE),
+                         lambda: _convert_float(fp32, tl.float32, tl.bfloat16, _ir.ROUNDING_MODE.RTNE)),
+        "fp8e4nv -> fp16": (lambda: _convert_float_numpy(fp8, tl.float8e4nv, tl.float16, None),
+                            lambda: _convert_float(fp8, tl.float8e4nv, tl.float16, None)),
+        "erf fp32": (lambda: np_erf_fp32(fp32), lambda: _interpreter.erf(fp32)),
+        "umulhi u64": (lambda: np_umulhi_u64(u64, u64), lambda: _interpreter.umulhi(u64, u64)),
+        "masked load": (numpy_load, lambda: _interpreter.load(ptrs, mask, other, other.dtype)),
+    }
+    print(f"{'op':<20}{'numpy (ms)':>12}{'c++ (ms)':>12}{'speedup':>10}")
+    for name, (numpy_fn, cpp_fn) in cases.items():
+        numpy_ms = min(timeit.repeat(numpy_fn, number=1, repeat=repeat)) * 1e3
+        cpp_ms = min(timeit.repeat(cpp_fn, number=1, repeat=repeat)) * 1e3
+        print(f"{name:<20}{numpy_ms:>12.2f}{cpp_ms:>12.2f}{numpy_ms / cpp_ms:>9.1f}x")
+
+
+if __name__ == "__main__":
+    benchmark()
@@ -0,0 +1,306 @@
+import ctypes
+import shutil
+import subprocess
+
+import pytest
+
+# Stub of the CUDA driver API, which records the last launch
+STUB_LIBCUDA = r"""
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  unsigned gridDimX, gridDimY, gridDimZ;
+  unsigned blockDimX, blockDimY, blockDimZ;
+  unsigned sharedMemBytes;
+  void *hStream;
+  char *attrs;
+  unsigned numAttrs;
+} CUlaunchConfig;
+
+uint64_t last_function, last_stream;
+unsigned last_grid[3], last_block[3], last_cluster[3], last_shared;
+void **last_params;
+int num_launches, num_launches_ex;
+
+int cuLaunchKernel(void *f, unsigned gx, unsigned gy, unsigned gz, unsigned bx, unsigned by, unsigned bz,
+                   unsigned shared, void *stream, void **params, void **extra) {
+  if ((uint64_t)f == 0xbad)
+    return 700;
+  last_function = (uint64_t)f;
+  last_stream = (uint64_t)stream;
+  last_grid[0] = gx, last_grid[1] = gy, last_grid[2] = gz;
+  last_block[0] = bx, last_block[1] = by, last_block[2] = bz;
+  last_shared = shared;
+  last_params = params;
+  num_launches++;
+  return 0;
+}
+
+int cuLaunchKernelEx(const CUlaunchConfig *config, void *f, void **params, void **extra) {
+  int ret = cuLaunchKernel(f, config->gridDimX, config->gridDimY, config->gridDimZ, config->blockDimX,
+                           config->blockDimY, config->blockDimZ, config->sharedMemBytes, config->hStream, params,
+                           extra);
+  // The value of the first attribute, the cluster dimensions, is 8 bytes after its id
+  const unsigned *cluster = (const unsigned *)(config->attrs + 8);
+  last_cluster[0] = cluster[0], last_cluster[1] = cluster[1], last_cluster[2] = cluster[2];
+  num_launches_ex++;
+  return ret;
+}
+
+int cuPointerGetAttribute(void *data, int attribute, uint64_t ptr) {
+  // Host pointers are rejected, device pointers are offset to check the translation
+  if (ptr == 0xcafe)
+    return 1;
+  *(uint64_t *)data = ptr + 1;
+  return 0;
+}
+
+int cuGetErrorString(int error, const char **str) {
+  *str = "stub error";
+  return 0;
+}
+
+typedef struct {
+  void *func;
+  unsigned gridDimX, gridDimY, gridDimZ;
+  unsigned blockDimX, blockDimY, blockDimZ;
+  unsigned sharedMemBytes;
+  void **kernelParams;
+  void **extra;
+} CUDA_KERNEL_NODE_PARAMS;
+
+// Graphs record the function, grid, first parameter and dependency of their nodes, which are indices plus one
+uint64_t node_function[16], node_param[16], last_graph_stream;
+unsigned node_grid[16][3], node_cluster[16][3];
+int node_dependency[16], num_nodes, num_instantiations, num_graph_launches;
+
+static void set_node(int i, const CUDA_KERNEL_NODE_PARAMS *params) {
+  node_function[i] = (uint64_t)params->func;
+  node_grid[i][0] = params->gridDimX, node_grid[i][1] = params->gridDimY, node_grid[i][2] = params->gridDimZ;
+  node_param[i] = *(uint64_t *)params->kernelParams[0];
+}
+
+int cuGraphCreate(void **graph, unsigned flags) {
+  *graph = (void *)1;
+  num_nodes = 0;
+  return 0;
+}
+
+int cuGraphDestroy(void *graph) { return 0; }
+
+int cuGraphAddKernelNode(void **node, void *graph, void **deps, size_t num_deps,
+                         const CUDA_KERNEL_NODE_PARAMS *params) {
+  if ((uint64_t)params->func == 0xbad)
+    return 700;
+  int i = num_nodes++;
+  node_dependency[i] = num_deps ? (int)(uint64_t)deps[0] - 1 : -1;
+  node_cluster[i][0] = node_cluster[i][1] = node_cluster[i][2] = 0;
+  set_node(i, params);
+  *node = (void *)(uint64_t)(i + 1);
+  return 0;
+}
+
+int cuGraphKernelNodeSetAttribute(void *node, int attribute, const unsigned *value) {
+  // CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION
+  if (attribute == 4) {
+    unsigned *cluster = node_cluster[(uint64_t)node - 1];
+    cluster[0] = value[0], cluster[1] = value[1], cluster[2] = value[2];
+  }
+  return 0;
+}
+
+int cuGraphInstantiateWithFlags(void **exec, void *graph, unsigned long long flags) {
+  *exec = (void *)2;
+  num_instantiations++;
+  return 0;
+}
+
+int cuGraphExecDestroy(void *exec) { return 0; }
+
+int cuGraphExecKernelNodeSetParams(void *exec, void *node, const CUDA_KERNEL_NODE_PARAMS *params) {
+  set_node((uint64_t)node - 1, params);
+  return 0;
+}
+
+int cuGraphLaunch(void *exec, void *stream) {
+  last_graph_stream = (uint64_t)stream;
+  num_graph_launches++;
+  return 0;
+}
+"""
+
+
+@pytest.fixture(scope="module")
+def libcuda(tmp_path_factory):
+    cc = shutil.which("cc") or shutil.which("gcc") or shutil.which("clang")
+    if cc is None:
+        pytest.skip("a C compiler is needed to build the stub driver")
+    tmp_path = tmp_path_factory.mktemp("libcuda")
+    src = tmp_path / "stub.c"
+    src.write_text(STUB_LIBCUDA)
+    path = str(tmp_path / "libcuda.so.1")
+    subprocess.check_call([cc, "-shared", "-fPIC", str(src), "-o", path])
+    return path, ctypes.CDLL(path)
+
+
+def make_launcher(signature, libcuda):
+    from triton._C.libtriton import nvidia
+    return nvidia.launcher.KernelLauncher(signature, libcuda[0])
+
+
+class Tensor:
+
+    def __init__(self, ptr):
+        self.ptr = ptr
+
+    def data_ptr(self):
+        return self.ptr
+
+
+def read_params(lib, types):
+    params = ctypes.POINTER(ctypes.c_void_p).in_dll(lib, "last_params")
+    return [ctypes.cast(params[i], ctypes.POINTER(ty))[0] for i, ty in enumerate(types)]
+
+
+def read_array(lib, name):
+    return tuple((ctypes.c_uint * 3).in_dll(lib, name))
+
+
+def test_launch(libcuda):
+    lib = libcuda[1]
+    launcher = make_launcher("PiK-fbd", libcuda)
+    launcher.launch(2, 3, 4, 5, 6, (4, 1, 1024, 1, 1, 1), None, None, None, Tensor(0x1000), -7, 2**64 - 1, None, 1.5,
+                    -3, 0.25)
+    assert read_array(lib, "last_grid") == (2, 3, 4)
+    assert read_array(lib, "last_block") == (128, 1, 1)
+    assert ctypes.c_uint.in_dll(lib, "last_shared").value == 1024
+    assert ctypes.c_uint64.in_dll(lib, "last_stream").value == 5
+    assert ctypes.c_uint64.in_dll(lib, "last_function").value == 6
+    params = read_params(lib, [ctypes.c_uint64, ctypes.c_int32, ctypes.c_uint64, ctypes.c_float, ctypes.c_int8,
+                               ctypes.c_double])
+    assert params == [0x1001, -7, 2**64 - 1, 1.5, -3, 0.25]
+
+
+def test_launch_pointers(libcuda):
+    lib = libcuda[1]
+    launcher = make_launcher("PPPT", libcuda)
+    desc = ctypes.create_string_buffer(256)
+    desc_ptr = (ctypes.addressof(desc) + 63) // 64 * 64
+
+    class TmaDesc:
+
+        def tma_desc_cpu_ptr(self):
+            return desc_ptr
+
+    launcher.launch(1, 1, 1, 0, 1, (1, 1, 0, 1, 1, 1), None, None, None, 0x2000, None, Tensor(0), TmaDesc())
+    params = ctypes.POINTER(ctypes.c_void_p).in_dll(lib, "last_params")
+    # Ints are passed as is, None and null tensors are null pointers
+    assert read_params(lib, [ctypes.c_uint64] * 3) == [0x2000, 0, 0]
+    assert params[3] == desc_ptr
+
+
+def test_launch_cluster(libcuda):
+    lib = libcuda[1]
+    launcher = make_launcher("i", libcuda)
+    num_launches_ex = ctypes.c_int.in_dll(lib, "num_launches_ex").value
+    launcher.launch(2, 3, 1, 0, 1, (8, 2, 0, 2, 1, 1), None, None, None, 42)
+    assert ctypes.c_int.in_dll(lib, "num_launches_ex").value == num_launches_ex + 1
+    assert read_array(lib, "last_grid") == (4, 3, 1)
+    assert read_array(lib, "last_block") == (256, 1, 1)
+    assert read_array(lib, "last_cluster") == (2, 1, 1)
+    assert read_params(lib, [ctypes.c_int32]) == [42]
+
+
+def test_launch_hooks(libcuda):
+    lib = libcuda[1]
+    launcher = make_launcher("", libcuda)
+    calls = []
+    launcher.launch(1, 1, 1, 0, 1, (1, 1, 0, 1, 1, 1), "metadata", lambda m: calls.append(("enter", m)),
+                    lambda m: calls.append(("exit", m)))
+    assert calls == [("enter", "metadata"), ("exit", "metadata")]
+    # Empty grids are not launched
+    num_launches = ctypes.c_int.in_dll(lib, "num_launches").value
+    launcher.launch(0, 1, 1, 0, 1, (1, 1, 0, 1, 1, 1), None, None, None)
+    assert ctypes.c_int.in_dll(lib, "num_launches").value == num_launches
+
+
+def test_launch_errors(libcuda):
+    metadata = (1, 1, 0, 1, 1, 1)
+    launcher = make_launcher("Pb", libcuda)
+    with pytest.raises(ValueError, match="cannot be accessed from Triton"):
+        launcher.launch(1, 1, 1, 0, 1, metadata, None, None, None, Tensor(0xcafe), 0)
+    with pytest.raises(TypeError, match="must return 64-bit int"):
+        launcher.launch(1, 1, 1, 0, 1, metadata, None, None, None, Tensor(1.0), 0)
+    with pytest.raises(TypeError, match="Pointer argument must be either uint64 or have data_ptr method"):
+        launcher.launch(1, 1, 1, 0, 1, metadata, None, None, None, object(), 0)
+    with pytest.raises(OverflowError):
+        launcher.launch(1, 1, 1, 0, 1, metadata, None, None, None, 0, 128)
+    with pytest.raises(TypeError, match="expects 11 arguments"):
+        launcher.launch(1, 1, 1, 0, 1, metadata, None, None, None, 0)
+    with pytest.raises(RuntimeError, match=r"Triton Error \[CUDA\]: stub error"):
+        launcher.launch(1, 1, 1, 0, 0xbad, metadata, None, None, None, 0, 0)
+    with pytest.raises(ValueError, match="Invalid kernel signature"):
+        make_launcher("Px", libcuda)
+
+
+def read_counter(lib, name):
+    return ctypes.c_int.in_dll(lib, name).value
+
+
+def test_launch_graph(libcuda):
+    from triton._C.libtriton import nvidia
+    lib = libcuda[1]
+    graph = nvidia.launcher.LaunchGraph(libcuda[0])
+    launcher = make_launcher("P-i", libcuda)
+    cluster_launcher = make_launcher("K", libcuda)
+    metadata = (4, 1, 0, 1, 1, 1)
+    num_launches = read_counter(lib, "num_launches")
+    graph.begin_capture()
+    launcher.launch(2, 1, 1, 0, 6, metadata, None, None, None, Tensor(0x1000), 16, 1)
+    # Empty grids are not recorded
+    launcher.launch(0, 1, 1, 0, 6, metadata, None, None, None, Tensor(0x1000), 16, 1)
+    cluster_launcher.launch(2, 3, 1, 0, 7, (8, 2, 0, 2, 1, 1), None, None, None, 42)
+    graph.end_capture()
+    # Nothing is launched while capturing
+    assert read_counter(lib, "num_launches") == num_launches
+    assert len(graph) == 2
+    assert list((ctypes.c_int * 2).in_dll(lib, "node_dependency")) == [-1, 0]
+    assert list((ctypes.c_uint64 * 2).in_dll(lib, "node_function")) == [6, 7]
+    assert list((ctypes.c_uint64 * 2).in_dll(lib, "node_param")) == [0x1001, 42]
+    grids = (ctypes.c_uint * 3 * 2).in_dll(lib, "node_grid")
+    clusters = (ctypes.c_uint * 3 * 2).in_dll(lib, "node_cluster")
+    assert tuple(grids[0]) == (2, 1, 1) and tuple(clusters[0]) == (0, 0, 0)
+    assert tuple(grids[1]) == (4, 3, 1) and tuple(clusters[1]) == (2, 1, 1)
+
+    num_instantiations = read_counter(lib, "num_instantiations")
+    num_graph_launches = read_counter(lib, "num_graph_launches")
+    graph.replay(5)
+    graph.replay(5)
+    assert read_counter(lib, "num_instantiations") == num_instantiations + 1
+    assert read_counter(lib, "num_graph_launches") == num_graph_launches + 2
+    assert ctypes.c_uint64.in_dll(lib, "last_graph_stream").value == 5
+
+    # Arguments are updated without capturing again
+    graph.update(0, Tensor(0x2000), 16, 1)
+    graph.update(1, 43)
+    assert list((ctypes.c_uint64 * 2).in_dll(lib, "node_param")) == [0x2001, 43]
+    graph.replay(5)
+    assert read_counter(lib, "num_instantiations") == num_instantiations + 1
+
+    with pytest.raises(IndexError):
+        graph.update(2, 43)
+    with pytest.raises(TypeError, match="expects 1 arguments"):
+        graph.update(1, 43, 44)
+    with pytest.raises(RuntimeError, match=r"Triton Error \[CUDA\]: stub error"):
+        graph.begin_capture()
+        try:
+            launcher.launch(1, 1, 1, 0, 0xbad, metadata, None, None, None, Tensor(0x1000), 16, 1)
+        finally:
+            graph.end_capture()
+    # Capturing again starts a new graph
+    graph.begin_capture()
+    with pytest.raises(RuntimeError, match="already being captured"):
+        graph.begin_capture()
+    graph.end_capture()
+    assert len(graph) == 0
@@ -112,7 +112,16 @@ def gen_kernel_library(dir, libname):
     subprocess.run(command, check=True, cwd=dir)
 
 
-def gen_test_bin(dir, M, N, K, exe="test", algo_id=0):
+def gen_test_bin(dir, M, N, K, exe="test", algo_id=0, bundle=None):
+    if bundle is not None:
+        open_bundle = f"""
+  tt_bundle *bundle;
+  CUresult err_bundle = tt_bundle_open("{bundle}", &bundle);
+  assert(err_bundle == CUDA_SUCCESS);
+  tt_bundle_set_default(bundle);"""
+        close_bundle = "tt_bundle_close(bundle);"
+    else:
+        open_bundle = close_bundle = ""
     test_src = f"""
 int main(int argc, char **argv) {{
   int M = {M}, N = {N}, K = {K};
@@ -129,7 +138,7 @@ int main(int argc, char **argv) {{
   cuMemAlloc(&A, M * K * 2);
   cuMemAlloc(&B, K * N * 2);
   cuMemAlloc(&C, M * N * 4);
-  cuStreamCreate(&stream, 0);
+  cuStreamCreate(&stream, 0);{open_bundle}
   load_matmul_fp16();
 
   // initialize input data
@@ -164,6 +173,7 @@ int main(int argc, char **argv) {{
 
   // free cuda handles
   unload_matmul_fp16();
+  {close_bundle}
   cuMemFree(A);
   cuMemFree(B);
   cuMemFree(C);
@@ -171,6 +181,8 @@ int main(int argc, char **argv) {{
 }}
 """
     src = test_utils_src + test_src
+    if bundle is not None:
+        src = '#include "triton_bundle.h"\n' + src
     with open(os.path.join(dir, "test.c"), "w") as file:
         file.write(src)
 
@@ -195,7 +207,7 @@ def write_triton_kernels(dir, src, util_src):
     return kernel_path
 
 
-def _compile_kernel(dir, signature, kernel_name, out_name, out_path, num_warps, grid, kernel_path):
+def _compile_kernel(dir, signature, kernel_name, out_name, out_path, num_warps, grid, kernel_path, bundle=False):
     compiler_path = os.path.join(triton.tools.__path__[0], "compile.py")
 
     subprocess.run(
@@ -215,7 +227,7 @@ def _compile_kernel(dir, signature, kernel_name, out_name, out_path, num_warps,
             "-g",
             grid,
             kernel_path,
-        ],
+        ] + (["--bundle"] if bundle else []),
         check=True,
         cwd=dir,
     )
@@ -239,7 +251,7 @@ def compile_aot_kernel_no_specialization(dir, kernel_path, dtype, BM, BN, BK):
     )
 
 
-def compile_aot_kernels(dir, kernel_path, dtype, BM, BN, BK, ha_hb_hints):
+def compile_aot_kernels(dir, kernel_path, dtype, BM, BN, BK, ha_hb_hints, bundle=False):
     # compile all desired configs
     for ha in ha_hb_hints:
         for hb in ha_hb_hints:
@@ -255,6 +267,7 @@ def compile_aot_kernels(dir, kernel_path, dtype, BM, BN, BK, ha_hb_hints):
                 num_warps=1,
                 grid=grid,
                 kernel_path=kernel_path,
+                bundle=bundle,
             )
 
 
@@ -266,6 +279,13 @@ def link_aot_kernels(dir):
     subprocess.run([sys.executable, linker_path] + h_files + ["-o", "kernel"], check=True, cwd=dir)
 
 
+def bundle_aot_kernels(dir):
+    bundler_path = os.path.join(triton.tools.__path__[0], "bundle.py")
+
+    h_files = glob.glob(os.path.join(dir, "*.h"))
+    subprocess.run([sys.executable, bundler_path] + h_files + ["-o", "kernels.bundle"], check=True, cwd=dir)
+
+
 def generate_matmul_test_data(dir, M, N, K):
     a = np.random.randn(M * K).astype(np.float16).reshape((M, K))
     b = np.random.randn(M * K).astype(np.float16).reshape((K, N))
@@ -340,6 +360,58 @@ def test_compile_link_matmul():
         np.testing.assert_allclose(c_tri, c_ref * c_ref, atol=1e-4, rtol=0.0)
 
 
+def test_compile_link_matmul_bundle():
+    np.random.seed(3)
+
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        dtype = "fp16"
+        BM, BN, BK = 16, 16, 16
+
+        kernel_path = write_triton_kernels(tmp_dir, kernel_src, kernel_utils_src)
+        compile_aot_kernels(tmp_dir, kernel_path, dtype, BM, BN, BK, ha_hb_hints=["", ":16"], bundle=True)
+        link_aot_kernels(tmp_dir)
+        bundle_aot_kernels(tmp_dir)
+        # The cubins are not embedded in the sources
+        assert not any("_cubin[" in open(path).read() for path in glob.glob(os.path.join(tmp_dir, "matmul_*.c")))
+
+        # compile test case
+        M, N, K = 16, 16, 16
+        gen_kernel_library(tmp_dir, "libkernel.so")
+        gen_test_bin(tmp_dir, M, N, K, bundle="kernels.bundle")
+
+        # initialize test data
+        a, b, a_path, b_path, c_path = generate_matmul_test_data(tmp_dir, M, N, K)
+
+        # run test case
+        env = os.environ.copy()
+        env["LD_LIBRARY_PATH"] = tmp_dir
+        subprocess.run(["./test", a_path, b_path, c_path], env=env, check=True, cwd=tmp_dir)
+
+        # read data and compare against reference
+        c = np.genfromtxt(c_path, delimiter=",", dtype=np.int32)
+        c_tri = c.reshape((M, N)).view(np.float32)
+        c_ref = np.matmul(a.astype(np.float32), b.astype(np.float32))
+        np.testing.assert_allclose(c_tri, c_ref * c_ref, atol=1e-4, rtol=0.0)
+
+
+def test_kernel_bundle(tmp_path):
+    from triton.tools.bundle import ALIGNMENT, read_bundle, write_bundle
+    kernels = {
+        ("matmul", "0a1b2c3d_0d1d"): b"\x01" * 10,
+        ("matmul", "4e5f6a7b_0d1"): b"\x02" * 5000,
+        # Identical binaries are stored once
+        ("matmul_copy", "0a1b2c3d_0d1d"): b"\x01" * 10,
+    }
+    path = tmp_path / "kernels.bundle"
+    write_bundle(kernels, path)
+    assert read_bundle(path) == kernels
+    data = path.read_bytes()
+    assert data.count(b"\x01" * 10) == 1
+    # Binaries are page-aligned, so that they are loaded straight from the mapped bundle
+    assert data.index(b"\x01" * 10) % ALIGNMENT == 0
+    assert data.index(b"\x02" * 5000) % ALIGNMENT == 0
+
+
 def test_launcher_has_no_available_kernel():
     np.random.seed(3)
 
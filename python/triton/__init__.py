@@ -18,7 +18,7 @@ from .runtime import (
     MockTensor,
 )
 from .runtime.jit import jit
-from .compiler import compile, CompilationError
+from .compiler import compile, compile_batch, CompilationError
 from .errors import TritonError
 
 from . import language
@@ -30,6 +30,7 @@ __all__ = [
     "cdiv",
     "CompilationError",
     "compile",
+    "compile_batch",
     "Config",
     "heuristics",
     "impl",
@@ -1,4 +1,7 @@
-from .compiler import CompiledKernel, ASTSource, compile, AttrsDescriptor, make_backend, LazyDict
+from .compiler import CompiledKernel, ASTSource, compile, compile_batch, AttrsDescriptor, make_backend, LazyDict
 from .errors import CompilationError
 
-__all__ = ["compile", "make_backend", "ASTSource", "AttrsDescriptor", "CompiledKernel", "CompilationError", "LazyDict"]
+__all__ = [
+    "compile", "compile_batch", "make_backend", "ASTSource", "AttrsDescriptor", "CompiledKernel", "CompilationError",
+    "LazyDict"
+]
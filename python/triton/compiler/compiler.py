@@ -6,8 +6,11 @@ from ..backends import backends
 from ..backends.compiler import GPUTarget
 from .. import __version__
 from ..runtime.autotuner import OutOfResources
-from ..runtime.cache import get_cache_manager, get_dump_manager, get_override_manager
+from ..runtime.cache import get_cache_manager, get_dump_manager, get_override_manager, read_group_files
 from ..runtime.driver import driver
+from collections import ChainMap, namedtuple
+from collections.abc import KeysView, Mapping
+from concurrent.futures import ThreadPoolExecutor
 # TODO: this shouldn't be here
 from dataclasses import dataclass
 from .code_generator import ast_to_ttir
@@ -15,6 +18,7 @@ from pathlib import Path
 import re
 import functools
 import os
+import time
 
 
 @dataclass
@@ -224,10 +228,13 @@ def filter_traceback(e: BaseException):
         e.__traceback__ = frames[0]
 
 
-def compile(src, target=None, options=None):
+def compile(src, target=None, options=None, retain_ir=None, _in_memory=False):
     if target is None:
         target = driver.active.get_current_target()
     assert isinstance(target, GPUTarget), "target must be of GPUTarget type"
+    # The IR stages that aren't stored in the cache are regenerated by compiling the kernel again. With `_in_memory`,
+    # the cache is neither read nor written, and all the stages are kept in memory.
+    regenerate = functools.partial(compile, src, target, options, _in_memory=True)
     backend = make_backend(target)
     ir_source = not isinstance(src, ASTSource)
     # create backend
@@ -246,20 +253,40 @@ def compile(src, target=None, options=None):
     enable_override = os.environ.get("TRITON_KERNEL_OVERRIDE", "0") == "1"
     enable_ir_dump = os.environ.get("TRITON_KERNEL_DUMP", "0") == "1"
     fn_override_manager = get_override_manager(src.hash()) if enable_override else None
-    fn_dump_manager = get_dump_manager(src.hash()) if enable_ir_dump else None
+    fn_dump_manager = get_dump_manager(src.hash()) if enable_ir_dump and not _in_memory else None
     # Pre-truncate the file name here to avoid hitting the 255 character limit on common platforms.
     # The final file name in the cache will have a format of f"{filename}.{ext}.tmp.pid_{pid}_{uuid}".
     # A PID string can be 5-character long. A UUID string has typically 36 characters. Let's truncate
     # the file name to 150 characters to be safe.
     file_name = src.name[:150]
     metadata_filename = f"{file_name}.json"
-    metadata_group = fn_cache_manager.get_group(metadata_filename) or {}
-    metadata_path = metadata_group.get(metadata_filename)
+    stages = dict()
+    backend.add_stages(stages, options)
+    first_stage = list(stages.keys()).index(src.ext)
+    # when the source is an IR file, don't apply the passes related to this stage. This makes it easier to write IR level tests.
+    if ir_source:
+        first_stage += 1
+    stage_exts = list(stages.keys())[first_stage:]
+    # Only the binary, the metadata and the IR stages in `retain_ir` (`TRITON_CACHE_IR` by default), a comma-separated
+    # list of extensions or "all", are stored in the cache. The others are kept in memory, and regenerated in memory
+    # when a kernel loaded from the cache needs them.
+    use_ir_loc = os.environ.get("USE_IR_LOC", None)
+    if retain_ir is None:
+        retain_ir = os.environ.get("TRITON_CACHE_IR", "")
+    stored_stages = [
+        ext for ext in stage_exts
+        if retain_ir == "all" or ext in retain_ir.split(",") or ext in [backend.binary_ext, use_ir_loc]
+    ] if not _in_memory else []
     always_compile = os.environ.get("TRITON_ALWAYS_COMPILE", "0") == "1"
-    if not always_compile and metadata_path is not None:
-        # cache hit!
-        metadata = json.loads(Path(metadata_path).read_text())
-        return CompiledKernel(src, metadata_group, hash)
+    if not always_compile and not _in_memory:
+        group_contents = fn_cache_manager.get_group_contents(metadata_filename)
+        if group_contents is not None and metadata_filename in group_contents and all(
+                f"{file_name}.{ext}" in group_contents for ext in stored_stages):
+            # cache hit!
+            return CompiledKernel(src, group_contents, hash, regenerate, stage_exts)
+    metadata_group = {} if _in_memory else fn_cache_manager.get_group(metadata_filename) or {}
+    # contents of the stages that aren't stored in the cache
+    artifacts = dict()
     # initialize metadata
     metadata = {
         "hash": hash,
@@ -268,49 +295,95 @@ def compile(src, target=None, options=None):
         **env_vars,
     }
     # run compilation pipeline  and populate metadata
-    stages = dict()
-    backend.add_stages(stages, options)
-    first_stage = list(stages.keys()).index(src.ext)
-    # when the source is an IR file, don't apply the passes related to this stage. This makes it easier to write IR level tests.
-    if ir_source:
-        first_stage += 1
-    context = ir.context()
-    ir.load_dialects(context)
-    backend.load_dialects(context)
     codegen_fns = backend.get_codegen_implementation()
     module_map = backend.get_module_map()
+    # With TRITON_COMPILE_TELEMETRY, the wall time of each stage and the statistics of the passes it ran are stored
+    # in the `compile_telemetry` metadata of the kernel.
+    telemetry = metadata.get("TRITON_COMPILE_TELEMETRY") == "true"
+    if telemetry:
+        # Drop the records of passes run by this thread outside of a compilation
+        ir.take_pass_telemetry()
+        metadata["compile_telemetry"] = []
+
+    def record_stage(stage, start):
+        if telemetry:
+            metadata["compile_telemetry"].append({
+                "stage": stage,
+                "time": time.perf_counter() - start,
+                "passes": ir.take_pass_telemetry(),
+            })
+
+    # Contexts are reused across compilations, with their dialects loaded
+    context = ir.acquire_context(target.backend, backend.load_dialects)
     try:
-        module = src.make_ir(options, codegen_fns, module_map, context)
-    except Exception as e:
-        filter_traceback(e)
+        start = time.perf_counter()
+        try:
+            module = src.make_ir(options, codegen_fns, module_map, context)
+        except Exception as e:
+            filter_traceback(e)
+            raise
+        record_stage("source", start)
+        for ext, compile_ir in list(stages.items())[first_stage:]:
+            start = time.perf_counter()
+            next_module = compile_ir(module, metadata)
+            record_stage(ext, start)
+            ir_filename = f"{file_name}.{ext}"
+            if (fn_override_manager is not None and (full_name := fn_override_manager.get_file(ir_filename)) is not None):
+                print(f"\nOverriding kernel with file {full_name}")
+                next_module = parse(full_name, ext, context)
+            if ext == use_ir_loc and not _in_memory:
+                # The new locations point into this file, which must stay readable
+                metadata_group[ir_filename] = fn_cache_manager.put(next_module, ir_filename, compress=False)
+            elif ext in stored_stages:
+                metadata_group[ir_filename] = fn_cache_manager.put(next_module, ir_filename)
+            else:
+                # The binary is kept as is, and the IR is printed
+                artifacts[ir_filename] = next_module if isinstance(next_module, bytes) else str(next_module).encode()
+            if fn_dump_manager is not None:
+                fn_dump_manager.put(next_module, ir_filename)
+            # use an env variable to parse ir from file
+            if use_ir_loc == ext:
+                ir_full_name = metadata_group.get(ir_filename) or fn_cache_manager.get_file(ir_filename)
+                next_module.create_location_snapshot(ir_full_name)
+                print(f"Creating new locations for {ir_full_name}")
+            module = next_module
+        # write-back metadata
+        if _in_memory:
+            artifacts[metadata_filename] = json.dumps(metadata, default=vars).encode("utf-8")
+        else:
+            metadata_group[metadata_filename] = fn_cache_manager.put(json.dumps(metadata, default=vars),
+                                                                     metadata_filename, binary=False)
+            fn_cache_manager.put_group(metadata_filename, metadata_group)
+    except BaseException:
+        # The context may be left in any state, and its threads must be stopped before the process forks
+        ir.retire_context(context)
         raise
-    use_ir_loc = os.environ.get("USE_IR_LOC", None)
-    for ext, compile_ir in list(stages.items())[first_stage:]:
-        next_module = compile_ir(module, metadata)
-        ir_filename = f"{file_name}.{ext}"
-        if (fn_override_manager is not None and (full_name := fn_override_manager.get_file(ir_filename)) is not None):
-            print(f"\nOverriding kernel with file {full_name}")
-            next_module = parse(full_name, ext, context)
-        metadata_group[ir_filename] = fn_cache_manager.put(next_module, ir_filename)
-        if fn_dump_manager is not None:
-            fn_dump_manager.put(next_module, ir_filename)
-        # use an env variable to parse ir from file
-        if use_ir_loc == ext:
-            ir_full_name = fn_cache_manager.get_file(ir_filename)
-            next_module.create_location_snapshot(ir_full_name)
-            print(f"Creating new locations for {ir_full_name}")
-        module = next_module
-    # write-back metadata
-    metadata_group[metadata_filename] = fn_cache_manager.put(json.dumps(metadata, default=vars), metadata_filename,
-                                                             binary=False)
-    fn_cache_manager.put_group(metadata_filename, metadata_group)
-    # Compilation completed, disabling multithreading in context.
-    # This is needed to safely finalize threads pool inside context: if current process forks before
-    # python GC deletes context object, thread pool in child process will be invalid, which could
+    # Compilation completed, return the context to the pool. The thread pool of a context is finalized when it is
+    # retired, and before the process forks: a thread pool inherited by a child process would be invalid, which could
     # lead to child crash or hang.
-    context.disable_multithreading()
+    ir.release_context(target.backend, context)
     # return handle to compiled kernel
-    return CompiledKernel(src, metadata_group, hash)
+    return CompiledKernel(src, ChainMap(artifacts, read_group_files(metadata_group)), hash, stages=stage_exts)
+
+
+def compile_batch(srcs, target=None, options=None, max_workers=None):
+    """
+    Compiles several sources concurrently and returns their kernels in order.
+
+    Every source is compiled with its own MLIR and LLVM contexts. The MLIR pass
+    pipelines, LLVM optimization and code generation release the GIL, so these
+    stages run in parallel on up to `max_workers` threads (one per CPU by
+    default). `options` is either a single dict used for all the sources or a
+    list with one dict per source.
+    """
+    if target is None:
+        target = driver.active.get_current_target()
+    if options is None or isinstance(options, dict):
+        options = [options] * len(srcs)
+    assert len(options) == len(srcs), "options must be given for every source"
+    with ThreadPoolExecutor(max_workers=max_workers or os.cpu_count()) as executor:
+        futures = [executor.submit(compile, src, target, opts) for src, opts in zip(srcs, options)]
+        return [future.result() for future in futures]
 
 
 def make_backend(target):
@@ -337,6 +410,57 @@ class LazyDict:
         self.extras.append((func, args))
 
 
+@functools.lru_cache()
+def kernel_metadata_type(fields):
+    # Kernels compiled with the same options share their metadata type
+    return namedtuple('KernelMetadata', fields)
+
+
+class KernelAsm(Mapping):
+    """
+    The artifacts of a kernel, keyed by extension: the binary, kept as is, which avoids a copy when it is
+    memory-mapped, and the text of each level of IR generated during compilation, decoded when first accessed.
+    `stages` are the extensions of all the stages of the kernel, by default the ones in `metadata_group`. The stages
+    missing from `metadata_group` are generated in memory by calling `regenerate`, when one of them is accessed;
+    looking up or listing the stages doesn't generate them.
+    """
+
+    def __init__(self, metadata_group, binary_ext, regenerate=None, stages=None):
+        self.files = {Path(c).suffix[1:]: c for c in metadata_group if not c.endswith(".json")}
+        self.stages = list(stages if stages is not None else self.files)
+        self.metadata_group = metadata_group
+        self.binary_ext = binary_ext
+        self.regenerate = regenerate
+        self.text = dict()
+
+    def __getitem__(self, ext):
+        if ext not in self.stages:
+            raise KeyError(ext)
+        if ext not in self.files and self.regenerate is not None:
+            asm = self.regenerate().asm
+            self.files = {**asm.files, **self.files}
+            self.metadata_group = ChainMap(self.metadata_group, asm.metadata_group)
+            self.regenerate = None
+        if ext == self.binary_ext:
+            return self.metadata_group[self.files[ext]]
+        text = self.text.get(ext)
+        if text is None:
+            text = self.text[ext] = bytes(self.metadata_group[self.files[ext]]).decode("utf-8")
+        return text
+
+    def __contains__(self, ext):
+        return ext in self.stages
+
+    def keys(self):
+        return KeysView(self)
+
+    def __iter__(self):
+        return iter(self.stages)
+
+    def __len__(self):
+        return len(self.stages)
+
+
 class CompiledKernel:
 
     # Hooks for external tools to monitor the execution of triton kernels
@@ -344,29 +468,24 @@ class CompiledKernel:
     launch_enter_hook = None
     launch_exit_hook = None
 
-    def __init__(self, src, metadata_group, hash):
-        from collections import namedtuple
-        metadata_path = next((Path(p) for c, p in metadata_group.items() if c.endswith(".json")))
-        metadata = json.loads(metadata_path.read_text())
+    def __init__(self, src, metadata_group, hash, regenerate=None, stages=None):
+        # `metadata_group` maps the name of each file of the kernel to its contents (bytes-like), which may only be
+        # read when accessed: only the metadata and the binary are needed to launch the kernel. `regenerate` compiles
+        # the kernel again in memory, with all of the `stages` it has, when `metadata_group` doesn't hold them.
+        metadata = json.loads(bytes(metadata_group[next(c for c in metadata_group if c.endswith(".json"))]))
         metadata['cluster_dims'] = tuple(metadata['cluster_dims'])
         # JSON serialization dumps the target as a dict. Restore it to a GPUTarget.
         target = metadata['target']
         metadata['target'] = GPUTarget(target['backend'], target['arch'], target['warp_size'])
-        KernelMetadata = namedtuple('KernelMetadata', sorted(list(metadata.keys())))
+        KernelMetadata = kernel_metadata_type(tuple(sorted(metadata.keys())))
         self.metadata = KernelMetadata(**metadata)
         backend = make_backend(self.metadata.target)
         self.packed_metadata = backend.pack_metadata(self.metadata)
         self.src = src
         self.hash = hash
         self.name = self.metadata.name
-        # stores the text of each level of IR that was generated during compilation
-        asm_files = [Path(p) for c, p in metadata_group.items() if not c.endswith(".json")]
-        binary_ext = backend.binary_ext
-        self.asm = {
-            file.suffix[1:]: file.read_bytes() if file.suffix[1:] == binary_ext else file.read_text()
-            for file in asm_files
-        }
-        self.kernel = self.asm[binary_ext]
+        self.asm = KernelAsm(metadata_group, backend.binary_ext, regenerate, stages)
+        self.kernel = self.asm[backend.binary_ext]
         # binaries are lazily initialized
         # because it involves doing runtime things
         # (e.g., checking amount of shared memory on current device)
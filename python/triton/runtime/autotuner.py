@@ -4,11 +4,14 @@ import builtins
 import os
 import time
 import inspect
+from concurrent.futures import ThreadPoolExecutor, as_completed
 from typing import Dict
 
 from ..testing import do_bench, do_bench_cudagraph
+from .driver import driver
 from .jit import KernelInterface
 from .errors import OutOfResources
+from .cache import AutotuneDatabase
 
 
 class Autotuner(KernelInterface):
@@ -27,6 +30,8 @@ class Autotuner(KernelInterface):
         warmup=25,
         rep=100,
         use_cuda_graph=False,
+        cache_results=False,
+        pipeline_compile=False,
     ):
         """
         :param prune_configs_by: a dict of functions that are used to prune configs, fields:
@@ -92,10 +97,11 @@ class Autotuner(KernelInterface):
         self.num_reps = rep
         import torch
         self.use_cuda_graph = use_cuda_graph and torch.cuda.is_available()
+        self.cache_results = cache_results or os.getenv("TRITON_CACHE_AUTOTUNING", "0") == "1"
+        self.pipeline_compile = pipeline_compile
 
-    def _bench(self, *args, config, **meta):
-        from ..compiler.errors import CompileTimeAssertionFailure
-
+    @staticmethod
+    def _config_kwargs(config, meta):
         # check for conflicts, i.e. meta-parameters both provided
         # as kwargs and by the autotuner
         conflicts = meta.keys() & config.kwargs.keys()
@@ -103,7 +109,12 @@ class Autotuner(KernelInterface):
             raise ValueError(f"Conflicting meta-parameters: {', '.join(conflicts)}."
                              " Make sure that you don't re-define auto-tuned symbols.")
         # augment meta-parameters with tunable ones
-        current = dict(meta, **config.all_kwargs())
+        return dict(meta, **config.all_kwargs())
+
+    def _bench(self, *args, config, **meta):
+        from ..compiler.errors import CompileTimeAssertionFailure
+
+        current = self._config_kwargs(config, meta)
         full_nargs = {**self.nargs, **current}
 
         def kernel_call():
@@ -131,6 +142,52 @@ class Autotuner(KernelInterface):
         except (OutOfResources, CompileTimeAssertionFailure):
             return [float("inf"), float("inf"), float("inf")]
 
+    def _compile(self, *args, config, device, properties, **meta):
+        """
+        Compiles `config` on a worker thread and returns whether it fits in the resources of `device`, which are
+        checked against the static metadata of the kernel, so that it is never launched if it doesn't.
+        """
+        from ..compiler.errors import CompileTimeAssertionFailure
+
+        # the current device is a per-thread state
+        driver.active.set_current_device(device)
+        try:
+            kernel = self.fn.run(*args, grid=None, warmup=True, **self._config_kwargs(config, meta))
+        except (OutOfResources, CompileTimeAssertionFailure):
+            return False
+        if kernel is None:
+            return True
+        metadata = kernel.metadata
+        if metadata.shared > properties["max_shared_mem"]:
+            return False
+        # the register usage is only known for backends that report it at compile time
+        n_regs = getattr(metadata, "n_regs", None)
+        num_threads = metadata.num_warps * getattr(metadata, "warp_size", 32)
+        return n_regs is None or n_regs * num_threads <= properties["max_num_regs"]
+
+    def _bench_pipelined(self, *args, configs, **kwargs):
+        """
+        Compiles all the configs concurrently, and benchmarks each one as soon as it is compiled. Configs that don't
+        fit in the resources of the device are discarded without being launched.
+        """
+        device = driver.active.get_current_device()
+        properties = driver.active.utils.get_device_properties(device)
+        timings = {}
+        with ThreadPoolExecutor(max_workers=min(len(configs), os.cpu_count() or 1)) as executor:
+            futures = {
+                executor.submit(self._compile, *args, config=config, device=device, properties=properties, **kwargs):
+                config
+                for config in configs
+            }
+            for future in as_completed(futures):
+                config = futures[future]
+                if future.result():
+                    timings[config] = self._bench(*args, config=config, **kwargs)
+                else:
+                    timings[config] = [float("inf"), float("inf"), float("inf")]
+        # keep the order of the configs, which breaks ties between equal timings
+        return {config: timings[config] for config in configs}
+
     def run(self, *args, **kwargs):
         self.nargs = dict(zip(self.arg_names, args))
         used_cached_result = True
@@ -145,17 +202,24 @@ class Autotuner(KernelInterface):
                 if hasattr(arg, "dtype"):
                     key.append(str(arg.dtype))
             key = tuple(key)
+            if key not in self.cache and self.cache_results:
+                self._load_result(key)
             if key not in self.cache:
                 # prune configs
                 used_cached_result = False
                 pruned_configs = self.prune_configs(kwargs)
                 bench_start = time.time()
-                timings = {config: self._bench(*args, config=config, **kwargs) for config in pruned_configs}
+                if self.pipeline_compile and len(pruned_configs) > 1:
+                    timings = self._bench_pipelined(*args, configs=pruned_configs, **kwargs)
+                else:
+                    timings = {config: self._bench(*args, config=config, **kwargs) for config in pruned_configs}
                 bench_end = time.time()
                 self.bench_time = bench_end - bench_start
                 self.cache[key] = builtins.min(timings, key=timings.get)
                 self.pre_hook(args, reset_only=True)
                 self.configs_timings = timings
+                if self.cache_results:
+                    self._store_result(key, timings)
             config = self.cache[key]
         else:
             config = self.configs[0]
@@ -173,6 +237,38 @@ class Autotuner(KernelInterface):
         self.nargs = None
         return ret
 
+    def _database_key(self, key):
+        from ..compiler.compiler import make_backend, triton_key
+        from .jit import JITFunction
+        import torch
+
+        fn = self.fn
+        while not isinstance(fn, JITFunction):
+            fn = fn.fn
+        target = driver.active.get_current_target()
+        backend_key = f"{triton_key()}-{make_backend(target).hash()}"
+        device = f"{target.backend}:{target.arch}:{torch.cuda.get_device_name(driver.active.get_current_device())}"
+        return AutotuneDatabase.make_key(fn.cache_key, key, backend_key, device, [str(c) for c in self.configs])
+
+    def _load_result(self, key):
+        entry = AutotuneDatabase().get(self._database_key(key))
+        if entry is None:
+            return
+        # The config is looked up by its representation, so that its pre_hook is kept
+        configs = {str(config): config for config in self.configs}
+        if entry.get("config") in configs:
+            self.cache[key] = configs[entry["config"]]
+
+    def _store_result(self, key, timings):
+        config = self.cache[key]
+        entry = {
+            "name": self.base_fn.__name__,
+            "key": repr(key),
+            "config": str(config),
+            "timings": timings[config],
+        }
+        AutotuneDatabase().put(self._database_key(key), entry)
+
     def prune_configs(self, kwargs):
         pruned_configs = self.configs
         if self.early_config_prune:
@@ -260,7 +356,7 @@ class Config:
 
 
 def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, restore_value=None, pre_hook=None, post_hook=None,
-             warmup=25, rep=100, use_cuda_graph=False):
+             warmup=25, rep=100, use_cuda_graph=False, cache_results=False, pipeline_compile=False):
     """
     Decorator for auto-tuning a :code:`triton.jit`'d function.
 
@@ -312,12 +408,23 @@ def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, restore_va
     :type warmup: int
     :param rep: Repetition time (in ms) to pass to benchmarking, defaults to 100.
     :type rep: int
+    :param cache_results: Whether to store the autotuning results in a persistent database next to the kernel cache,
+        keyed by the kernel source, the autotuning key, the backend and the device, so that other processes reuse them
+        instead of benchmarking again. Also enabled by setting the environment variable
+        :code:`TRITON_CACHE_AUTOTUNING` to :code:`"1"`. See :code:`triton.runtime.cache.AutotuneDatabase` to export
+        and import the results.
+    :type cache_results: bool
+    :param pipeline_compile: Whether to compile all the configs concurrently on background threads, benchmarking each
+        one as soon as it is compiled. Configs that exceed the shared memory or registers of the device are discarded
+        before being launched.
+    :type pipeline_compile: bool
     """
 
     def decorator(fn):
         return Autotuner(fn, fn.arg_names, configs, key, reset_to_zero, restore_value, pre_hook=pre_hook,
                          post_hook=post_hook, prune_configs_by=prune_configs_by, warmup=warmup, rep=rep,
-                         use_cuda_graph=use_cuda_graph)
+                         use_cuda_graph=use_cuda_graph, cache_results=cache_results,
+                         pipeline_compile=pipeline_compile)
 
     return decorator
 
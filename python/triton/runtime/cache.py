@@ -1,10 +1,13 @@
 import importlib
 import json
 import os
+import re
+import shutil
 import uuid
+import zlib
 from abc import ABC, abstractmethod
 from pathlib import Path
-from typing import Dict, List, Optional
+from typing import Dict, List, Mapping, Optional
 import base64
 import hashlib
 
@@ -25,6 +28,114 @@ def default_dump_dir():
     return os.path.join(get_home_dir(), ".triton", "dump")
 
 
+# Compressed cache files start with this header, which tells them apart from the files written uncompressed
+COMPRESSED_MAGIC = b"\0TTZ"
+# The names of the directories of the keys, see `_base64`
+KEY_PATTERN = re.compile("[A-Za-z0-9_-]{43}")
+# The store of `MmapCacheManager`, in the cache directory
+STORE_NAME = "kernels.store"
+
+
+def compress_data(data: bytes) -> bytes:
+    return COMPRESSED_MAGIC + zlib.compress(data)
+
+
+def read_file(path) -> bytes:
+    """
+    Returns the contents of the cached file at `path`, decompressed.
+    """
+    data = Path(path).read_bytes()
+    if data.startswith(COMPRESSED_MAGIC):
+        return zlib.decompress(memoryview(data)[len(COMPRESSED_MAGIC):])
+    return data
+
+
+def parse_size(size: str) -> int:
+    """
+    Parses a number of bytes, optionally followed by a K, M, G or T unit (e.g. "512M").
+    """
+    units = {"K": 2**10, "M": 2**20, "G": 2**30, "T": 2**40}
+    size = size.strip().upper().rstrip("B")
+    if size and size[-1] in units:
+        return int(float(size[:-1]) * units[size[-1]])
+    return int(size or 0)
+
+
+def evict(cache_dir: str, max_size: int, keep=()) -> int:
+    """
+    Removes the least recently used keys of the cache directory `cache_dir` until the cache takes at most `max_size`
+    bytes, and returns the number of bytes freed. The directories in `keep` are not removed.
+
+    The modification time of the directory of a key is the last time it was used: it changes when a file is written
+    to it, and the cache managers touch it on cache hits. The autotuning results in the `autotune` directory are
+    evicted in the same way. The store of `MmapCacheManager` holds copies of the files of the keys: it counts towards
+    the size of the cache, and is compacted to drop the records of the evicted keys.
+    """
+    entries = []
+    total = 0
+    for entry in os.scandir(cache_dir):
+        if not entry.is_dir(follow_symlinks=False) or KEY_PATTERN.fullmatch(entry.name) is None:
+            continue
+        try:
+            size = sum(f.stat().st_size for f in os.scandir(entry.path) if f.is_file(follow_symlinks=False))
+            entries.append((entry.stat().st_mtime, entry.path, size))
+        except FileNotFoundError:
+            # Removed by another process
+            continue
+        total += size
+    autotune_dir = os.path.join(cache_dir, "autotune")
+    if os.path.isdir(autotune_dir):
+        for entry in os.scandir(autotune_dir):
+            key, ext = os.path.splitext(entry.name)
+            if ext != ".json" or not AutotuneDatabase._is_valid_key(key):
+                continue
+            try:
+                stat = entry.stat()
+            except FileNotFoundError:
+                continue
+            entries.append((stat.st_mtime, entry.path, stat.st_size))
+            total += stat.st_size
+    store_path = os.path.join(cache_dir, STORE_NAME)
+    try:
+        store_size = os.path.getsize(store_path)
+    except FileNotFoundError:
+        store_size = 0
+    total += store_size
+    freed = 0
+    # Estimate of the bytes the compaction of the store will free
+    store_freed = 0
+    for _, path, size in sorted(entries):
+        if total - freed - store_freed <= max_size:
+            break
+        if path in keep:
+            continue
+        if os.path.isdir(path):
+            shutil.rmtree(path, ignore_errors=True)
+            if store_size:
+                store_freed += size
+        else:
+            try:
+                os.remove(path)
+            except FileNotFoundError:
+                pass
+        freed += size
+    if store_freed:
+        freed += store_size - compact_store(cache_dir)
+    return freed
+
+
+def compact_store(cache_dir: str) -> int:
+    """
+    Drops the records of the keys that are no longer in the cache directory `cache_dir` from its `MmapCacheManager`
+    store, and returns the new size of the store. The processes that mapped the store before keep reading the old
+    one, and switch to the new one when they next write to it.
+    """
+    from .._C.libtriton import cache
+    store_path = os.path.join(cache_dir, STORE_NAME)
+    store = MmapCacheManager._stores.get(store_path) or cache.store(store_path)
+    return store.compact(lambda key: os.path.isdir(os.path.join(cache_dir, key.split("/", 1)[0])))
+
+
 class CacheManager(ABC):
 
     def __init__(self, key):
@@ -35,7 +146,7 @@ class CacheManager(ABC):
         pass
 
     @abstractmethod
-    def put(self, data, filename, binary=True) -> str:
+    def put(self, data, filename, binary=True, compress=True) -> str:
         pass
 
     @abstractmethod
@@ -46,12 +157,33 @@ class CacheManager(ABC):
     def put_group(self, filename: str, group: Dict[str, str]):
         pass
 
+    def get_group_contents(self, filename: str) -> Optional[Mapping[str, bytes]]:
+        """
+        Returns the contents of the files of a group, keyed by file name, or None if the group is missing. The files
+        may be read when they are first accessed.
+        """
+        group = self.get_group(filename)
+        if group is None:
+            return None
+        return read_group_files(group)
+
 
 class FileCacheManager(CacheManager):
+    """
+    Stores each file in the directory of its key in the cache directory. With `TRITON_CACHE_COMPRESS=1`, files are
+    compressed, except the shared libraries, which are loaded from their path. With `TRITON_CACHE_MAX_SIZE`, the
+    least recently used keys are evicted when the cache grows larger.
+    """
+
+    # Bytes written by this process since the cache was last checked for eviction, None before the first check
+    _written_since_eviction = None
 
     def __init__(self, key, override=False, dump=False):
         self.key = key
         self.lock_path = None
+        # Dumps are meant to be read by users, and overrides are written by them
+        self.compress = not (dump or override) and os.getenv("TRITON_CACHE_COMPRESS", "0") == "1"
+        self.max_size = 0 if dump or override else parse_size(os.getenv("TRITON_CACHE_MAX_SIZE", "0"))
         if dump:
             self.cache_dir = os.getenv("TRITON_DUMP_DIR", "").strip() or default_dump_dir()
             self.cache_dir = os.path.join(self.cache_dir, self.key)
@@ -89,12 +221,17 @@ class FileCacheManager(CacheManager):
         if not self.has_file(grp_filename):
             return None
         grp_filepath = self._make_path(grp_filename)
-        with open(grp_filepath) as f:
-            grp_data = json.load(f)
+        grp_data = json.loads(read_file(grp_filepath))
         child_paths = grp_data.get("child_paths", None)
         # Invalid group data.
         if child_paths is None:
             return None
+        if self.max_size:
+            # Mark the key as recently used, see `evict`
+            try:
+                os.utime(self.cache_dir)
+            except OSError:
+                pass
         result = {}
         for c, p in child_paths.items():
             if os.path.exists(p):
@@ -109,7 +246,11 @@ class FileCacheManager(CacheManager):
         grp_filename = f"__grp__{filename}"
         return self.put(grp_contents, grp_filename, binary=False)
 
-    def put(self, data, filename, binary=True) -> str:
+    def put(self, data, filename, binary=True, compress=True) -> str:
+        """
+        Stores `data` as `filename`, and returns its path. With `compress=False`, the file is never compressed, e.g.
+        when it must be readable from its path.
+        """
         if not self.cache_dir:
             raise RuntimeError("Could not create or locate cache dir")
         binary = isinstance(data, bytes)
@@ -126,6 +267,9 @@ class FileCacheManager(CacheManager):
         os.makedirs(temp_dir, exist_ok=True)
         temp_path = os.path.join(temp_dir, filename)
 
+        if compress and self.compress and not filename.endswith(".so"):
+            data = compress_data(data if binary else data.encode("utf-8"))
+            binary = True
         mode = "wb" if binary else "w"
         with open(temp_path, mode) as f:
             f.write(data)
@@ -133,8 +277,194 @@ class FileCacheManager(CacheManager):
         # so filepath cannot see a partial write
         os.replace(temp_path, filepath)
         os.removedirs(temp_dir)
+        if self.max_size:
+            self._maybe_evict(len(data))
         return filepath
 
+    def _maybe_evict(self, size):
+        # Scanning the cache is costly on network file systems: only check it once the process wrote a sixteenth of
+        # its maximum size since the last check.
+        written = FileCacheManager._written_since_eviction
+        if written is not None and written + size < self.max_size // 16:
+            FileCacheManager._written_since_eviction = written + size
+            return
+        FileCacheManager._written_since_eviction = 0
+        evict(os.path.dirname(self.cache_dir), self.max_size, keep={self.cache_dir})
+
+
+class MmapCacheManager(FileCacheManager):
+    """
+    A `FileCacheManager` that also appends every cached file to a single store, `kernels.store` in the cache
+    directory, which is memory-mapped by the readers. Groups are looked up in the in-memory index of the store and
+    their contents are returned as zero-copy views of the mapping, so loading a cached kernel costs no file system
+    operation once the store is mapped. The records of the store are never compressed. The regular files are still
+    written for the consumers that need paths (e.g., the launcher modules).
+
+    With `TRITON_CACHE_MAX_SIZE`, the store counts towards the size of the cache, see `evict`, and a cache hit
+    touches the directory of its key, like `FileCacheManager`: the keys evicted since the store was mapped are not
+    served from it.
+
+    Select it with `TRITON_CACHE_MANAGER=triton.runtime.cache:MmapCacheManager`.
+    """
+
+    # Store path -> store, shared by the managers of all the keys. The views a store returns keep its file mapped.
+    _stores = {}
+
+    def __init__(self, key, override=False, dump=False):
+        self._store = None
+        if dump or override:
+            super().__init__(key, override=override, dump=dump)
+            return
+        self.key = key
+        self.compress = os.getenv("TRITON_CACHE_COMPRESS", "0") == "1"
+        self.max_size = parse_size(os.getenv("TRITON_CACHE_MAX_SIZE", "0"))
+        cache_dir = os.getenv("TRITON_CACHE_DIR", "").strip() or default_cache_dir()
+        # Unlike `FileCacheManager`, the directory of the key is only created when a file is written
+        self.cache_dir = os.path.join(cache_dir, self.key)
+        self.lock_path = os.path.join(self.cache_dir, "lock")
+        store_path = os.path.join(cache_dir, STORE_NAME)
+        if store_path not in MmapCacheManager._stores:
+            from .._C.libtriton import cache
+            os.makedirs(cache_dir, exist_ok=True)
+            MmapCacheManager._stores[store_path] = cache.store(store_path)
+        self._store = MmapCacheManager._stores[store_path]
+
+    def _store_key(self, filename: str) -> str:
+        return f"{self.key}/{filename}"
+
+    def put(self, data, filename, binary=True, compress=True) -> str:
+        if not isinstance(data, bytes):
+            data = str(data)
+        filepath = super().put(data, filename, binary, compress)
+        if self._store is not None:
+            self._store.put(self._store_key(filename), data if isinstance(data, bytes) else data.encode("utf-8"))
+        return filepath
+
+    def get_group_contents(self, filename: str) -> Optional[Dict[str, memoryview]]:
+        if self._store is None:
+            return super().get_group_contents(filename)
+        grp_data = self._store.get(self._store_key(f"__grp__{filename}"))
+        # Fall back to the files written before the store was used
+        if grp_data is None:
+            return super().get_group_contents(filename)
+        if self.max_size:
+            # Mark the key as recently used, see `evict`
+            try:
+                os.utime(self.cache_dir)
+            except FileNotFoundError:
+                # The key was evicted
+                return None
+            except OSError:
+                pass
+        child_paths = json.loads(bytes(grp_data)).get("child_paths", None)
+        if child_paths is None:
+            return None
+        result = {}
+        for child in child_paths:
+            data = self._store.get(self._store_key(child))
+            if data is None:
+                return None
+            result[child] = data
+        return result
+
+
+def default_autotune_dir():
+    return os.path.join(os.getenv("TRITON_CACHE_DIR", "").strip() or default_cache_dir(), "autotune")
+
+
+class AutotuneDatabase:
+    """
+    Persistent autotuning results, stored as one JSON file per result in `path`, by default the `autotune` directory
+    of the kernel cache (or `TRITON_AUTOTUNE_DIR`).
+
+    Results are written to a temporary file and atomically renamed, so concurrent writers, in threads or processes,
+    never expose a partial result. They can be exported to a single JSON file and imported elsewhere, e.g. to feed the
+    results of an offline tuning sweep to other machines.
+    """
+
+    VERSION = 1
+
+    def __init__(self, path: Optional[str] = None):
+        self.path = path or os.getenv("TRITON_AUTOTUNE_DIR", "").strip() or default_autotune_dir()
+        self.max_size = parse_size(os.getenv("TRITON_CACHE_MAX_SIZE", "0"))
+
+    @staticmethod
+    def make_key(fn_key: str, key, backend_key: str, device: str, configs: List[str]) -> str:
+        """
+        Returns the key of the results for the JIT function of cache key `fn_key` called with the autotuning key
+        `key`, compiled with the backend of hash `backend_key` and run on `device`. `configs` are the
+        representations of the configs that are tuned, as adding or removing one may change the best config.
+        """
+        data = json.dumps([fn_key, repr(key), backend_key, device, configs])
+        return hashlib.sha256(data.encode("utf-8")).hexdigest()
+
+    @staticmethod
+    def _is_valid_key(key: str) -> bool:
+        return re.fullmatch("[0-9a-f]{64}", key) is not None
+
+    def _make_path(self, key: str) -> str:
+        assert self._is_valid_key(key), f"Invalid autotuning key {key}"
+        return os.path.join(self.path, f"{key}.json")
+
+    def get(self, key: str) -> Optional[Dict]:
+        path = self._make_path(key)
+        try:
+            with open(path) as f:
+                entry = json.load(f)
+        except (FileNotFoundError, json.JSONDecodeError):
+            return None
+        if self.max_size:
+            # Mark the result as recently used, see `evict`
+            try:
+                os.utime(path)
+            except OSError:
+                pass
+        return entry
+
+    def put(self, key: str, entry: Dict):
+        os.makedirs(self.path, exist_ok=True)
+        temp_path = os.path.join(self.path, f"tmp.pid_{os.getpid()}_{uuid.uuid4()}")
+        with open(temp_path, "w") as f:
+            json.dump(entry, f)
+        os.replace(temp_path, self._make_path(key))
+
+    def items(self):
+        if not os.path.isdir(self.path):
+            return
+        for filename in sorted(os.listdir(self.path)):
+            key, ext = os.path.splitext(filename)
+            if ext != ".json" or not self._is_valid_key(key):
+                continue
+            entry = self.get(key)
+            if entry is not None:
+                yield key, entry
+
+    def export_to(self, path: str) -> int:
+        """
+        Writes all the results to the JSON file `path`, and returns their number.
+        """
+        entries = dict(self.items())
+        with open(path, "w") as f:
+            json.dump({"version": AutotuneDatabase.VERSION, "entries": entries}, f, indent=1, sort_keys=True)
+        return len(entries)
+
+    def import_from(self, path: str, overwrite: bool = True) -> int:
+        """
+        Adds the results of a file written by `export_to`, and returns the number of results added.
+        """
+        with open(path) as f:
+            data = json.load(f)
+        if data.get("version") != AutotuneDatabase.VERSION:
+            raise ValueError(f"Unsupported autotuning database version {data.get('version')} in {path}")
+        count = 0
+        for key, entry in data["entries"].items():
+            if not self._is_valid_key(key):
+                raise ValueError(f"Invalid autotuning key {key} in {path}")
+            if overwrite or self.get(key) is None:
+                self.put(key, entry)
+                count += 1
+        return count
+
 
 class RemoteCacheBackend:
     """
@@ -191,9 +521,9 @@ class RemoteCacheManager(CacheManager):
         # Use a `FileCacheManager` to materialize remote cache paths locally.
         self._file_cache_manager = FileCacheManager(key, override=override, dump=dump)
 
-    def _materialize(self, filename: str, data: bytes):
+    def _materialize(self, filename: str, data: bytes, compress=True):
         # We use a backing `FileCacheManager` to provide the materialized data.
-        return self._file_cache_manager.put(data, filename, binary=True)
+        return self._file_cache_manager.put(data, filename, binary=True, compress=compress)
 
     def get_file(self, filename: str) -> Optional[str]:
         # We don't handle the dump/override cases.
@@ -209,15 +539,15 @@ class RemoteCacheManager(CacheManager):
         (_, data), = results.items()
         return self._materialize(filename, data)
 
-    def put(self, data, filename: str, binary=True) -> str:
+    def put(self, data, filename: str, binary=True, compress=True) -> str:
         # We don't handle the dump/override cases.
         if self._dump or self._override:
-            return self._file_cache_manager.put(data, filename, binary=binary)
+            return self._file_cache_manager.put(data, filename, binary=binary, compress=compress)
 
         if not isinstance(data, bytes):
             data = str(data).encode("utf-8")
         self._backend.put(filename, data)
-        return self._materialize(filename, data)
+        return self._materialize(filename, data, compress)
 
     def get_group(self, filename: str) -> Optional[Dict[str, str]]:
         # We don't handle the dump/override cases.
@@ -228,8 +558,7 @@ class RemoteCacheManager(CacheManager):
         grp_filepath = self.get_file(grp_filename)
         if grp_filepath is None:
             return None
-        with open(grp_filepath) as f:
-            grp_data = json.load(f)
+        grp_data = json.loads(read_file(grp_filepath))
         child_paths = grp_data.get("child_paths", None)
 
         result = None
@@ -285,6 +614,36 @@ def get_dump_manager(key) -> CacheManager:
     return __cache_cls(_base64(key), dump=True)
 
 
+class GroupFiles(Mapping):
+    """
+    The contents of the files of a group, keyed by file name. Each file is read when it is first accessed, so that
+    loading a kernel doesn't read the IRs nobody looks at.
+    """
+
+    def __init__(self, group: Dict[str, str]):
+        self.paths = group
+        self.contents = dict()
+
+    def __getitem__(self, filename):
+        data = self.contents.get(filename)
+        if data is None:
+            data = self.contents[filename] = read_file(self.paths[filename])
+        return data
+
+    def __contains__(self, filename):
+        return filename in self.paths
+
+    def __iter__(self):
+        return iter(self.paths)
+
+    def __len__(self):
+        return len(self.paths)
+
+
+def read_group_files(group: Dict[str, str]) -> Mapping[str, bytes]:
+    return GroupFiles(group)
+
+
 def make_so_cache_key(version_hash, signature, constants, ids, **kwargs):
     # Get unique key for the compiled code
     signature = {k: 'ptr' if v[0] == '*' else v for k, v in signature.items()}
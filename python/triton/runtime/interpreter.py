@@ -1,6 +1,10 @@
 import ast
+import itertools
+import os
 import textwrap
+import threading
 import inspect
+from concurrent.futures import ThreadPoolExecutor
 from typing import Tuple
 
 import math
@@ -128,7 +132,20 @@ def _get_np_dtype(tt_dtype):
     return np_types[tt_dtype]
 
 
+def _float_format(dtype):
+    return _interpreter.float_format(dtype.primitive_bitwidth, dtype.fp_mantissa_width, dtype.exponent_bias)
+
+
 def _convert_float(input, input_dtype, output_dtype, rounding_mode):
+    input_uint_dtype = getattr(np, f"uint{input_dtype.primitive_bitwidth}")
+    input_bin = np.ascontiguousarray(input).view(input_uint_dtype)
+    output = _interpreter.convert_float(input_bin, _float_format(input_dtype), _float_format(output_dtype),
+                                        rounding_mode == _ir.ROUNDING_MODE.RTNE)
+    return output.reshape(input.shape)
+
+
+def _convert_float_numpy(input, input_dtype, output_dtype, rounding_mode):
+    # Reference implementation of `_convert_float` using numpy temporaries
     input_uint_dtype = getattr(np, f"uint{input_dtype.primitive_bitwidth}")
     output_unint_dtype = getattr(np, f"uint{output_dtype.primitive_bitwidth}")
     input_bin = np.frombuffer(input.tobytes(), dtype=input_uint_dtype)
@@ -203,6 +220,7 @@ def _umulhi_64(a, b):
     return (int(a) * int(b)) >> 64
 
 
+# Reference implementations of `_interpreter.erf` and `_interpreter.umulhi`
 np_erf_fp32 = np.vectorize(_erf, otypes=[np.float32])
 np_erf_fp64 = np.vectorize(_erf, otypes=[np.float64])
 np_umulhi_u64 = np.vectorize(_umulhi_64, otypes=[np.uint64])
@@ -242,6 +260,16 @@ class InterpreterBuilder:
         self.codegen_fns = {}
         self.codegen_fns["convert_custom_types"] = ExtraFunctions._convert_custom_types
         self.codegen_fns["min_dot_size"] = lambda lhsType, rhsType: (16, 16, 16)
+        # Programs may run concurrently on several threads, each with its own grid index
+        self._thread_state = threading.local()
+
+    @property
+    def grid_idx(self):
+        return getattr(self._thread_state, "grid_idx", None)
+
+    @grid_idx.setter
+    def grid_idx(self, grid_idx):
+        self._thread_state.grid_idx = grid_idx
 
     def set_grid_idx(self, x, y, z):
         if not x < self.grid_dim[0]:
@@ -484,7 +512,8 @@ class InterpreterBuilder:
     def create_umulhi(self, lhs, rhs):
         dtype = lhs.data.dtype
         if dtype == np.int64 or dtype == np.uint64:
-            return TensorHandle(np_umulhi_u64(lhs.data, rhs.data), lhs.dtype.scalar)
+            lhs_data, rhs_data = np.broadcast_arrays(lhs.data, rhs.data.astype(dtype))
+            return TensorHandle(_interpreter.umulhi(lhs_data, rhs_data), lhs.dtype.scalar)
         else:
             compute_dtype = getattr(np, f"uint{dtype.itemsize * 8 * 2}")
             lhs_data = lhs.data.astype(compute_dtype)
@@ -529,8 +558,8 @@ class InterpreterBuilder:
     create_sin = lambda self, arg: self.unary_op(arg, np.sin)
 
     def create_erf(self, arg):
-        ret = np_erf_fp32(arg.data) if arg.data.dtype == np.float32 else np_erf_fp64(arg.data)
-        return TensorHandle(ret, arg.dtype.scalar)
+        data = arg.data if arg.data.dtype == np.float32 else arg.data.astype(np.float64)
+        return TensorHandle(_interpreter.erf(data), arg.dtype.scalar)
 
     def create_rsqrt(self, arg):
         return TensorHandle(1 / np.sqrt(arg.data), arg.dtype.scalar)
@@ -1085,25 +1114,60 @@ class GridExecutor:
         # remaps core language functions to interpreted ones
         _patch_lang(self.fn)
         # we need to copy arguments to the host for the interpreter
-        # implicitly convert tensor arguments to their base pointers
-        args = inspect.getcallargs(self.fn, *args_hst, **kwargs_hst)
-        args = {name: arg if name in self.constexprs else _implicit_cvt(arg) for name, arg in args.items()}
+        call_args = inspect.getcallargs(self.fn, *args_hst, **kwargs_hst)
+        args = self._implicit_cvt_args(call_args)
         # iterate through grid
         grid = self.grid(args) if callable(self.grid) else self.grid
         assert len(grid) <= 3, "grid must have at most 3 dimensions"
         grid = grid + (1, ) * (3 - len(grid))
         interpreter_builder.set_grid_dim(*grid)
+        num_threads = int(os.getenv("TRITON_INTERPRET_NUM_THREADS", "1"))
         try:
-            for x in range(grid[0]):
-                for y in range(grid[1]):
-                    for z in range(grid[2]):
-                        interpreter_builder.set_grid_idx(x, y, z)
-                        self.fn(**args)
+            if num_threads > 1 and grid[0] * grid[1] * grid[2] > 1:
+                self._run_parallel(grid, call_args, args, num_threads)
+            else:
+                for x in range(grid[0]):
+                    for y in range(grid[1]):
+                        for z in range(grid[2]):
+                            interpreter_builder.set_grid_idx(x, y, z)
+                            self.fn(**args)
         except Exception as e:
             raise InterpreterError(repr(e)) from e
         # copy arguments back to propagate side-effects
         self._restore_args_dev(args_dev, args_hst, kwargs, kwargs_hst)
 
+    def _implicit_cvt_args(self, call_args):
+        # implicitly convert tensor arguments to their base pointers
+        return {name: arg if name in self.constexprs else _implicit_cvt(arg) for name, arg in call_args.items()}
+
+    def _run_parallel(self, grid, call_args, args, num_threads):
+        # Threads pull program ids from a shared iterator, so threads that finish early take over the remaining
+        # programs. Atomics are implemented with hardware atomics, so programs can safely run concurrently.
+        program_ids = itertools.product(range(grid[0]), range(grid[1]), range(grid[2]))
+        lock = threading.Lock()
+        failed = threading.Event()
+
+        def worker(thread_args):
+            while not failed.is_set():
+                with lock:
+                    program_id = next(program_ids, None)
+                if program_id is None:
+                    return
+                interpreter_builder.set_grid_idx(*program_id)
+                try:
+                    self.fn(**thread_args)
+                except Exception:
+                    failed.set()
+                    raise
+
+        num_threads = min(num_threads, grid[0] * grid[1] * grid[2])
+        # Each thread works on its own argument handles, as some builder methods update handles in place
+        thread_args = [args] + [self._implicit_cvt_args(call_args) for _ in range(num_threads - 1)]
+        with ThreadPoolExecutor(max_workers=num_threads) as executor:
+            futures = [executor.submit(worker, arg) for arg in thread_args]
+        for future in futures:
+            future.result()
+
 
 class ASTTransformer(ast.NodeTransformer):
 
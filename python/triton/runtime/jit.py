@@ -7,6 +7,7 @@ import os
 import re
 import textwrap
 from collections import defaultdict
+from concurrent.futures import ThreadPoolExecutor
 from functools import cached_property
 from typing import Callable, Generic, Iterable, Optional, TypeVar, Union, overload, Dict, Any, Tuple
 from ..runtime.driver import driver
@@ -342,6 +343,19 @@ def serialize_specialization_data(name, signature, constants, attrs, options, ke
     return serialized_obj
 
 
+_background_compiler = None
+
+
+def get_background_compiler():
+    """
+    Returns the thread pool on which kernels with `async_compile` are compiled.
+    """
+    global _background_compiler
+    if _background_compiler is None:
+        _background_compiler = ThreadPoolExecutor(thread_name_prefix="triton-compile")
+    return _background_compiler
+
+
 def create_function_from_signature(sig, kparams):
     """
     Equivalent to sig.bind followed by apply_defaults. This generates a
@@ -581,6 +595,15 @@ class JITFunction(KernelInterface[T]):
         assert callable(hook)
         self.pre_run_hooks.append(hook)
 
+    def set_fallback(self, fallback):
+        '''
+        Set the kernel launched with the same arguments, when this kernel has
+        `async_compile` and is still being compiled for them. The fallback
+        should be compiled already, e.g. with `warmup`.
+        '''
+        assert fallback is None or isinstance(fallback, KernelInterface)
+        self.fallback = fallback
+
     def create_binder(self):
         """
         Precompute as much as possible.
@@ -590,6 +613,8 @@ class JITFunction(KernelInterface[T]):
         self.compile = compile
         self.ASTSource = ASTSource
         self.make_backend = make_backend
+        from .._C.libtriton import dispatch
+        self.Dispatcher = dispatch.dispatcher
         self.binder = create_function_from_signature(self.signature, self.params)
         self.constexpr_indices = [i for (i, p) in enumerate(self.params) if p.is_constexpr]
         self.non_constexpr_indices = [i for (i, p) in enumerate(self.params) if not p.is_constexpr]
@@ -597,12 +622,62 @@ class JITFunction(KernelInterface[T]):
             i for (i, p) in enumerate(self.params) if (not p.do_not_specialize) and (not p.is_constexpr)
         ]
 
+    def _add_to_cache(self, device, key, sig_and_spec, variant, kernel):
+        self.cache[device][key] = kernel
+        if self.async_compile:
+            num_types = len(self.non_constexpr_indices)
+            self.specializations[device].setdefault((sig_and_spec[:num_types], variant), []).append(
+                (sig_and_spec[num_types:], kernel))
+
+    def _find_specialization(self, device, sig_and_spec, variant):
+        """
+        Returns the compiled kernel with the most specializations among those
+        that are general enough for arguments specialized as `sig_and_spec`,
+        e.g. one compiled without the `divisible_by_16` attribute of a pointer.
+        """
+        num_types = len(self.non_constexpr_indices)
+        specs = sig_and_spec[num_types:]
+        ret, ret_num_specs = None, -1
+        for kernel_specs, kernel in self.specializations[device].get((sig_and_spec[:num_types], variant), []):
+            if all(k == "N" or k == s for k, s in zip(kernel_specs, specs)):
+                num_specs = sum(k != "N" for k in kernel_specs)
+                if num_specs > ret_num_specs:
+                    ret, ret_num_specs = kernel, num_specs
+        return ret
+
+    def _compile_in_background(self, device, key, sig_and_spec, variant, src, target, options, hook_args):
+        driver.active.set_current_device(device)
+        kernel = self.compile(src, target=target, options=options.__dict__)
+        # Later launches pick the kernel up from the cache
+        self._add_to_cache(device, key, sig_and_spec, variant, kernel)
+        self.compiling[device].pop(key, None)
+        self._call_hook(*hook_args, before=False)
+        return kernel
+
+    def _add_to_dispatcher(self, device, key, kernel, args, kwargs):
+        dispatcher = self.dispatchers.get(device)
+        if dispatcher is None:
+            params = [(p.name, p.is_constexpr, not p.do_not_specialize, not p.do_not_specialize_on_alignment,
+                       p.is_const, p.annotation_type, p.has_default, p.default) for p in self.params]
+            dispatcher = self.dispatchers[device] = self.Dispatcher(params, mangle_type, self.CompiledKernel)
+        used_global_vals = [(globals_dict, name, val)
+                            for (name, _), (val, globals_dict) in self.used_global_vals.items()]
+        launch = kernel.run
+        dispatcher.add(kernel, getattr(launch, "launch", launch), self.cache[device], key, used_global_vals, *args,
+                       **kwargs)
+
     def run(self, *args, grid, warmup, **kwargs):
         # parse options
         device = driver.active.get_current_device()
         stream = driver.active.get_current_stream(device)
         kwargs["debug"] = self.debug
 
+        # Fast path: launch a kernel that is already compiled, see dispatch.cc
+        if not warmup and not self.pre_run_hooks and (dispatcher := self.dispatchers.get(device)) is not None:
+            kernel = dispatcher.run(grid, stream, *args, **kwargs)
+            if kernel is not None:
+                return kernel
+
         # Execute pre run hooks with args and kwargs
         for hook in self.pre_run_hooks:
             hook(*args, **kwargs)
@@ -613,9 +688,26 @@ class JITFunction(KernelInterface[T]):
         bound_args, sig_and_spec, constexpr_vals, non_constexpr_vals, excess_kwargs = self.binder(*args, **kwargs)
 
         # compute cache key
-        key = ''.join(sig_and_spec) + str((constexpr_vals, excess_kwargs))
+        variant = str((constexpr_vals, excess_kwargs))
+        key = ''.join(sig_and_spec) + variant
         kernel = self.cache[device].get(key, None)
 
+        if kernel is None and (future := self.compiling[device].get(key)) is not None:
+            # The kernel is being compiled in the background, see `async_compile`
+            if future.done():
+                self.compiling[device].pop(key, None)
+                # Raises the compilation error, if any
+                kernel = future.result()
+            elif warmup:
+                kernel = future.result()
+            elif (kernel := self._find_specialization(device, sig_and_spec, variant)) is None:
+                if self.fallback is not None:
+                    return self.fallback.run(*args, grid=grid, warmup=warmup, **kwargs)
+                kernel = future.result()
+        elif kernel is None:
+            # The background compilation may have completed since the lookup
+            kernel = self.cache[device].get(key, None)
+
         if kernel is None:
             # Kernel is not cached; we have to compile.
             target = driver.active.get_current_target()
@@ -654,13 +746,24 @@ class JITFunction(KernelInterface[T]):
                 return None
             # compile the kernel
             src = self.ASTSource(self, signature, constants, configs[0])
-            kernel = self.compile(
-                src,
-                target=target,
-                options=options.__dict__,
-            )
-            self.cache[device][key] = kernel
-            self._call_hook(key, signature, device, constants, options, configs, warmup, before=False)
+            if self.async_compile and not warmup:
+                hook_args = (key, signature, device, constants, options, configs, warmup)
+                future = get_background_compiler().submit(self._compile_in_background, device, key, sig_and_spec,
+                                                          variant, src, target, options, hook_args)
+                self.compiling[device][key] = future
+                kernel = self._find_specialization(device, sig_and_spec, variant)
+                if kernel is None:
+                    if self.fallback is not None:
+                        return self.fallback.run(*args, grid=grid, warmup=warmup, **kwargs)
+                    kernel = future.result()
+            else:
+                kernel = self.compile(
+                    src,
+                    target=target,
+                    options=options.__dict__,
+                )
+                self._add_to_cache(device, key, sig_and_spec, variant, kernel)
+                self._call_hook(key, signature, device, constants, options, configs, warmup, before=False)
 
         # Check that used global values have not changed.
         not_present = object()
@@ -686,10 +789,12 @@ class JITFunction(KernelInterface[T]):
             launch_metadata = kernel.launch_metadata(grid, stream, *non_constexpr_vals)
             kernel.run(grid_0, grid_1, grid_2, stream, kernel.function, kernel.packed_metadata, launch_metadata,
                        self.CompiledKernel.launch_enter_hook, self.CompiledKernel.launch_exit_hook, *non_constexpr_vals)
+            if self.dispatch and self.cache[device].get(key) is kernel:
+                self._add_to_dispatcher(device, key, kernel, args, kwargs)
         return kernel
 
     def __init__(self, fn, version=None, do_not_specialize=None, do_not_specialize_on_alignment=None, debug=None,
-                 noinline=None, repr=None, launch_metadata=None):
+                 noinline=None, repr=None, launch_metadata=None, async_compile=None):
         do_not_specialize = do_not_specialize if do_not_specialize else []
         do_not_specialize_on_alignment = do_not_specialize_on_alignment if do_not_specialize_on_alignment else []
 
@@ -717,6 +822,18 @@ class JITFunction(KernelInterface[T]):
         # cache of just-in-time compiled kernels
         self.cache = defaultdict(dict)
         self.hash = None
+        # With `async_compile`, a launch that misses the cache compiles the kernel in the background and launches,
+        # in the meantime, a compiled kernel with fewer specializations or the fallback kernel. Otherwise it waits.
+        if async_compile is None:
+            async_compile = os.environ.get("TRITON_ASYNC_COMPILE", "0") == "1"
+        self.async_compile = async_compile
+        self.fallback = None
+        # futures of the kernels being compiled, and the compiled kernels by signature and constexpr values
+        self.compiling = defaultdict(dict)
+        self.specializations = defaultdict(dict)
+        # Compiled kernels are launched from C++, without going through `run`, unless TRITON_NO_FAST_DISPATCH=1
+        self.dispatch = os.environ.get("TRITON_NO_FAST_DISPATCH", "0") != "1"
+        self.dispatchers = dict()
 
         # Map of global variables used by the function and any functions it
         # transitively calls, plus their values.  The values are collected when
@@ -830,6 +947,7 @@ def jit(
     do_not_specialize_on_alignment: Optional[Iterable[int]] = None,
     debug: Optional[bool] = None,
     noinline: Optional[bool] = None,
+    async_compile: Optional[bool] = None,
 ) -> Callable[[T], JITFunction[T]]:
     ...
 
@@ -844,6 +962,7 @@ def jit(
     do_not_specialize_on_alignment: Optional[Iterable[int]] = None,
     debug: Optional[bool] = None,
     noinline: Optional[bool] = None,
+    async_compile: Optional[bool] = None,
 ) -> Union[JITFunction[T], Callable[[T], JITFunction[T]]]:
     """
     Decorator for JIT-compiling a function using the Triton compiler.
@@ -861,6 +980,10 @@ def jit(
 
     :param fn: the function to be jit-compiled
     :type fn: Callable
+    :param async_compile: compile the kernel in the background when a launch misses the cache. The launch meanwhile
+        runs an already compiled kernel with fewer specializations, or the kernel set with `set_fallback`, and only
+        waits for the compilation if there is neither. Defaults to `TRITON_ASYNC_COMPILE=1`.
+    :type async_compile: bool, optional
     """
 
     def decorator(fn: T) -> JITFunction[T]:
@@ -880,6 +1003,7 @@ def jit(
                 noinline=noinline,
                 repr=repr,
                 launch_metadata=launch_metadata,
+                async_compile=async_compile,
             )
 
     if fn is not None:
@@ -28,7 +28,7 @@ def _summarize_statistics(times, quantiles, return_mode):
     return getattr(torch, return_mode)(times).item()
 
 
-def do_bench_cudagraph(fn, rep=20, grad_to_none=None, quantiles=None, return_mode="mean"):
+def do_bench_cudagraph(fn, rep=20, grad_to_none=None, quantiles=None, return_mode="mean", launch_graph=False):
     """
     Benchmark the runtime of the provided function.
 
@@ -40,6 +40,9 @@ def do_bench_cudagraph(fn, rep=20, grad_to_none=None, quantiles=None, return_mod
     :type grad_to_none: torch.tensor, optional
     :param return_mode: The statistical measure to return. Options are "min", "max", "mean", "median", or "all" Default is "mean".
     :type return_mode: str
+    :param launch_graph: Record the Triton kernels launched by `fn` with the launch graph of the driver instead of
+        capturing a torch CUDA graph. `fn` must not run other GPU work, which would not be recorded.
+    :type launch_graph: bool
     """
     import torch
     assert return_mode in ["min", "max", "mean", "median", "all"]
@@ -69,8 +72,14 @@ def do_bench_cudagraph(fn, rep=20, grad_to_none=None, quantiles=None, return_mod
         n_repeat = max(1, int(rep / estimate_ms))
         # step 2 - construct a cuda graph with `n_repeat` unrolled function calls to minimize
         # host overhead
-        g = torch.cuda.CUDAGraph()
-        with torch.cuda.graph(g):
+        if launch_graph:
+            from .runtime import driver
+            g = driver.active.launch_graph_cls()
+            capture = g.capture()
+        else:
+            g = torch.cuda.CUDAGraph()
+            capture = torch.cuda.graph(g)
+        with capture:
             for _ in range(n_repeat):
                 if grad_to_none is not None:
                     for x in grad_to_none:
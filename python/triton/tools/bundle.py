@@ -0,0 +1,128 @@
+import hashlib
+import shutil
+import struct
+from pathlib import Path
+from typing import Dict, Tuple
+
+from triton.tools.link import HeaderParser
+
+# Layout of a bundle, see triton_bundle.c:
+#   header:  magic, version, number of entries, number of images, reserved
+#   entries: offsets of the name and specialization strings, index of the image, reserved;
+#            sorted by name, then specialization
+#   images:  offset and size of each distinct binary
+#   strings: null-terminated
+#   binaries, each aligned to a page
+MAGIC = b"TTBUNDLE"
+VERSION = 1
+ALIGNMENT = 4096
+HEADER = struct.Struct("<8sIIII")
+ENTRY = struct.Struct("<IIII")
+IMAGE = struct.Struct("<QQ")
+
+
+def _align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def write_bundle(kernels: Dict[Tuple[str, str], bytes], path):
+    """
+    Packs the binaries of `kernels`, keyed by kernel name and specialization, into a bundle at `path`.
+    Identical binaries are stored once.
+    """
+    images = []
+    image_ids = dict()
+    entries = []
+    for (name, spec), image in sorted(kernels.items()):
+        digest = hashlib.sha256(image).digest()
+        if digest not in image_ids:
+            image_ids[digest] = len(images)
+            images.append(bytes(image))
+        entries.append((name, spec, image_ids[digest]))
+    strings = bytearray()
+    strings_offset = HEADER.size + ENTRY.size * len(entries) + IMAGE.size * len(images)
+
+    def add_string(s):
+        offset = strings_offset + len(strings)
+        strings.extend(s.encode() + b"\0")
+        return offset
+
+    entry_table = [ENTRY.pack(add_string(name), add_string(spec), image_id, 0) for name, spec, image_id in entries]
+    image_table = []
+    offset = _align(strings_offset + len(strings))
+    for image in images:
+        image_table.append(IMAGE.pack(offset, len(image)))
+        offset = _align(offset + len(image))
+    with open(path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, len(entries), len(images), 0))
+        f.write(b"".join(entry_table))
+        f.write(b"".join(image_table))
+        f.write(strings)
+        for image in images:
+            f.write(b"\0" * (_align(f.tell()) - f.tell()))
+            f.write(image)
+
+
+def read_bundle(path) -> Dict[Tuple[str, str], bytes]:
+    """
+    Returns the binaries of the kernels of the bundle at `path`, keyed by kernel name and specialization.
+    """
+    data = Path(path).read_bytes()
+    magic, version, num_entries, num_images, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"{path} is not a kernel bundle")
+    images_offset = HEADER.size + ENTRY.size * num_entries
+    images = [IMAGE.unpack_from(data, images_offset + IMAGE.size * i) for i in range(num_images)]
+
+    def get_string(offset):
+        return data[offset:data.index(b"\0", offset)].decode()
+
+    ret = dict()
+    for i in range(num_entries):
+        name, spec, image_id, _ = ENTRY.unpack_from(data, HEADER.size + ENTRY.size * i)
+        offset, size = images[image_id]
+        ret[(get_string(name), get_string(spec))] = data[offset:offset + size]
+    return ret
+
+
+desc = """
+Triton ahead-of-time bundler:
+
+This program packs the binaries of kernels compiled with `compile.py --bundle`
+into a single kernel bundle, and writes the C sources of its loader
+(triton_bundle.h and triton_bundle.c) next to it. Identical binaries are stored
+once. The bundle is mapped in memory at run-time, and each kernel is loaded
+from it when it is first launched:
+
+  tt_bundle *bundle;
+  tt_bundle_open("kernels.bundle", &bundle);
+  tt_bundle_set_default(bundle);
+
+Example usage:
+python bundle.py /path/to/headers/*.h -o kernels.bundle
+"""
+
+if __name__ == "__main__":
+    from argparse import ArgumentParser
+
+    parser = ArgumentParser(description=desc)
+    parser.add_argument(
+        "headers",
+        nargs="+",
+        help="Paths to header files of the kernels to bundle, generated by compile.py with --bundle",
+    )
+    parser.add_argument("--out", "-o", type=Path, help="Out filename", required=True)
+    args = parser.parse_args()
+
+    kernels = dict()
+    for header in args.headers:
+        h_path = Path(header)
+        header_parser = HeaderParser()
+        header_parser.extract_linker_meta(h_path.read_text())
+        for metas in header_parser.kernels.values():
+            for meta in metas:
+                kernels[(meta.orig_kernel_name, f"{meta.sig_hash}_{meta.suffix}")] = \
+                    h_path.with_suffix(".cubin").read_bytes()
+    write_bundle(kernels, args.out)
+    for ext in ["h", "c"]:
+        shutil.copy(Path(__file__).parent / f"triton_bundle.{ext}", args.out.parent / f"triton_bundle.{ext}")
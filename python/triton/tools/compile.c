@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include <string.h>
 #include <cuda.h>
+{includes}
 
 
 // helpers to check for cuda errors
@@ -25,22 +26,20 @@ static inline void gpuAssert(CUresult code, const char *file, int line) {{
 }}
 
 // globals
-#define CUBIN_NAME {kernel_name}_cubin
 CUmodule {kernel_name}_mod = NULL;
 CUfunction {kernel_name}_func = NULL;
-unsigned char CUBIN_NAME[{bin_size}] = {{ {bin_data} }};
+{kernel_image}
 
 
 void unload_{kernel_name}(void) {{
-    CUDA_CHECK(cuModuleUnload({kernel_name}_mod));
+    {unload_module}
 }}
 
 // TODO: some code duplication with `runtime/backend/cuda.c`
 void load_{kernel_name}() {{
     int dev = 0;
-    void *bin = (void *)&CUBIN_NAME;
     int shared = {shared};
-    CUDA_CHECK(cuModuleLoadData(&{kernel_name}_mod, bin));
+    {load_module}
     CUDA_CHECK(cuModuleGetFunction(&{kernel_name}_func, {kernel_name}_mod, "{triton_kernel_name}"));
     // set dynamic shared memory if necessary
     int shared_optin;
@@ -32,6 +32,10 @@ CUresult kernel_{specialization_suffix}(CUstream stream, unsigned gX, unsigned g
 
 Different such specialized entry points can be combined using the `linker.py` script.
 
+With `--bundle`, the cubin is written to a separate file instead of being embedded in the C source. The cubins of
+many kernels can then be packed into a single kernel bundle with the `bundle.py` script, from which each kernel is
+loaded when it is first launched.
+
 NOTE: when resolving the scope of /path/to/kernel.py, the file will be executed from within its parent directory with the python interpreter
 used to run this `compile.py` script
 """
@@ -51,6 +55,8 @@ if __name__ == "__main__":
     parser.add_argument("--out-path", "-o", type=Path, default=None, help="Out filename")
     parser.add_argument("--signature", "-s", type=str, help="Signature of the kernel", required=True)
     parser.add_argument("--grid", "-g", type=str, help="Launch grid of the kernel", required=True)
+    parser.add_argument("--bundle", action="store_true",
+                        help="Load the kernel from a kernel bundle instead of embedding its cubin")
     args = parser.parse_args()
 
     out_name = args.out_name if args.out_name else args.kernel_name
@@ -120,12 +126,28 @@ if __name__ == "__main__":
     # dump C stub code
     suffix = kernel_suffix(signature.values(), attrs)
     func_name = '_'.join([out_name, sig_hash, suffix])
-    hex_ = str(binascii.hexlify(ccinfo.asm["cubin"]))[2:-1]
+    if args.bundle:
+        out_path.with_suffix(f".{sig_hash}_{suffix}.cubin").write_bytes(ccinfo.asm["cubin"])
+        includes = '#include "triton_bundle.h"'
+        kernel_image = ""
+        load_module = (f'CUDA_CHECK(tt_bundle_get_module(tt_bundle_get_default(), "{out_name}", "{sig_hash}_{suffix}", '
+                       f'&{func_name}_mod));')
+        # The module is shared with identical kernels and unloaded with the bundle
+        unload_module = f"{func_name}_func = NULL;"
+    else:
+        hex_ = str(binascii.hexlify(ccinfo.asm["cubin"]))[2:-1]
+        bin_data = ", ".join([f"0x{x}{y}" for x, y in zip(hex_[::2], hex_[1::2])])
+        includes = ""
+        kernel_image = f"unsigned char {func_name}_cubin[{len(hex_)}] = {{ {bin_data} }};"
+        load_module = f"CUDA_CHECK(cuModuleLoadData(&{func_name}_mod, (void *)&{func_name}_cubin));"
+        unload_module = f"CUDA_CHECK(cuModuleUnload({func_name}_mod));"
     params = {
         "kernel_name": func_name,
         "triton_kernel_name": args.kernel_name,
-        "bin_size": len(hex_),
-        "bin_data": ", ".join([f"0x{x}{y}" for x, y in zip(hex_[::2], hex_[1::2])]),
+        "includes": includes,
+        "kernel_image": kernel_image,
+        "load_module": load_module,
+        "unload_module": unload_module,
         "signature": ", ".join([f"{ty_to_cpp(ty)} {name}" for name, ty in zip(arg_names, arg_types)]),
         "full_signature": ", ".join([f"{ty_to_cpp(signature[i])} {kernel.arg_names[i]}" for i in signature.keys()]),
         "arg_pointers": ", ".join([f"&{arg}" for arg in arg_names]),
@@ -0,0 +1,197 @@
+#include "triton_bundle.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The layout of a bundle, see bundle.py. All integers are little-endian.
+#define TT_BUNDLE_MAGIC "TTBUNDLE"
+#define TT_BUNDLE_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_entries;
+  uint32_t num_images;
+  uint32_t reserved;
+} tt_bundle_header;
+
+// Entries are sorted by name, then specialization.
+typedef struct {
+  // Offsets of null-terminated strings in the file
+  uint32_t name;
+  uint32_t spec;
+  // Index of the binary of the kernel, shared by identical kernels
+  uint32_t image;
+  uint32_t reserved;
+} tt_bundle_entry;
+
+// Binaries are page-aligned.
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+} tt_bundle_image;
+
+struct tt_bundle {
+  const char *data;
+  size_t size;
+  const tt_bundle_entry *entries;
+  const tt_bundle_image *images;
+  uint32_t num_entries;
+  uint32_t num_images;
+  // Modules of the images loaded so far
+  CUmodule *modules;
+  pthread_mutex_t lock;
+};
+
+static tt_bundle *default_bundle = NULL;
+
+static int is_valid_string(const tt_bundle *bundle, uint32_t offset) {
+  return offset < bundle->size &&
+         memchr(bundle->data + offset, 0, bundle->size - offset) != NULL;
+}
+
+static int is_valid(const tt_bundle *bundle) {
+  const tt_bundle_header *header = (const tt_bundle_header *)bundle->data;
+  if (bundle->size < sizeof(tt_bundle_header) ||
+      memcmp(header->magic, TT_BUNDLE_MAGIC, 8) != 0 ||
+      header->version != TT_BUNDLE_VERSION)
+    return 0;
+  uint64_t tables_size =
+      sizeof(tt_bundle_header) +
+      (uint64_t)header->num_entries * sizeof(tt_bundle_entry) +
+      (uint64_t)header->num_images * sizeof(tt_bundle_image);
+  if (tables_size > bundle->size)
+    return 0;
+  const tt_bundle_entry *entries =
+      (const tt_bundle_entry *)(bundle->data + sizeof(tt_bundle_header));
+  const tt_bundle_image *images =
+      (const tt_bundle_image *)(entries + header->num_entries);
+  for (uint32_t i = 0; i < header->num_entries; i++)
+    if (!is_valid_string(bundle, entries[i].name) ||
+        !is_valid_string(bundle, entries[i].spec) ||
+        entries[i].image >= header->num_images)
+      return 0;
+  for (uint32_t i = 0; i < header->num_images; i++)
+    if (images[i].offset > bundle->size ||
+        images[i].size > bundle->size - images[i].offset)
+      return 0;
+  return 1;
+}
+
+CUresult tt_bundle_open(const char *path, tt_bundle **bundle) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return CUDA_ERROR_FILE_NOT_FOUND;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return CUDA_ERROR_INVALID_IMAGE;
+  }
+  void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping outlives the file descriptor
+  close(fd);
+  if (data == MAP_FAILED)
+    return CUDA_ERROR_OUT_OF_MEMORY;
+  tt_bundle *ret = calloc(1, sizeof(tt_bundle));
+  if (ret == NULL) {
+    munmap(data, st.st_size);
+    return CUDA_ERROR_OUT_OF_MEMORY;
+  }
+  ret->data = data;
+  ret->size = st.st_size;
+  if (!is_valid(ret)) {
+    munmap(data, st.st_size);
+    free(ret);
+    return CUDA_ERROR_INVALID_IMAGE;
+  }
+  const tt_bundle_header *header = (const tt_bundle_header *)ret->data;
+  ret->num_entries = header->num_entries;
+  ret->num_images = header->num_images;
+  ret->entries = (const tt_bundle_entry *)(ret->data + sizeof(*header));
+  ret->images = (const tt_bundle_image *)(ret->entries + ret->num_entries);
+  ret->modules =
+      calloc(ret->num_images ? ret->num_images : 1, sizeof(CUmodule));
+  if (ret->modules == NULL) {
+    munmap(data, st.st_size);
+    free(ret);
+    return CUDA_ERROR_OUT_OF_MEMORY;
+  }
+  pthread_mutex_init(&ret->lock, NULL);
+  *bundle = ret;
+  return CUDA_SUCCESS;
+}
+
+void tt_bundle_close(tt_bundle *bundle) {
+  if (bundle == NULL)
+    return;
+  if (default_bundle == bundle)
+    default_bundle = NULL;
+  for (uint32_t i = 0; i < bundle->num_images; i++)
+    if (bundle->modules[i] != NULL)
+      cuModuleUnload(bundle->modules[i]);
+  pthread_mutex_destroy(&bundle->lock);
+  munmap((void *)bundle->data, bundle->size);
+  free(bundle->modules);
+  free(bundle);
+}
+
+static const tt_bundle_entry *find_entry(const tt_bundle *bundle,
+                                         const char *name, const char *spec) {
+  uint32_t lo = 0, hi = bundle->num_entries;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    const tt_bundle_entry *entry = &bundle->entries[mid];
+    int cmp = strcmp(name, bundle->data + entry->name);
+    if (cmp == 0)
+      cmp = strcmp(spec, bundle->data + entry->spec);
+    if (cmp == 0)
+      return entry;
+    if (cmp < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return NULL;
+}
+
+int tt_bundle_find(const tt_bundle *bundle, const char *name, const char *spec,
+                   const void **image, size_t *size) {
+  if (bundle == NULL)
+    return 0;
+  const tt_bundle_entry *entry = find_entry(bundle, name, spec);
+  if (entry == NULL)
+    return 0;
+  const tt_bundle_image *info = &bundle->images[entry->image];
+  *image = bundle->data + info->offset;
+  *size = info->size;
+  return 1;
+}
+
+CUresult tt_bundle_get_module(tt_bundle *bundle, const char *name,
+                              const char *spec, CUmodule *module) {
+  if (bundle == NULL)
+    return CUDA_ERROR_INVALID_HANDLE;
+  const tt_bundle_entry *entry = find_entry(bundle, name, spec);
+  if (entry == NULL)
+    return CUDA_ERROR_NOT_FOUND;
+  CUresult ret = CUDA_SUCCESS;
+  pthread_mutex_lock(&bundle->lock);
+  CUmodule *slot = &bundle->modules[entry->image];
+  if (*slot == NULL)
+    ret = cuModuleLoadData(slot,
+                           bundle->data + bundle->images[entry->image].offset);
+  if (ret == CUDA_SUCCESS)
+    *module = *slot;
+  pthread_mutex_unlock(&bundle->lock);
+  return ret;
+}
+
+void tt_bundle_set_default(tt_bundle *bundle) { default_bundle = bundle; }
+
+tt_bundle *tt_bundle_get_default(void) { return default_bundle; }
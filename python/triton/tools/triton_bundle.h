@@ -0,0 +1,34 @@
+#ifndef TRITON_BUNDLE_H
+#define TRITON_BUNDLE_H
+
+#include <cuda.h>
+#include <stddef.h>
+
+// A kernel bundle, as written by bundle.py: the binaries of many kernels
+// packed in one indexed file. The file is mapped in memory, and the module of
+// a kernel is loaded straight from the mapping when it is first used.
+typedef struct tt_bundle tt_bundle;
+
+// Maps the bundle at `path`.
+CUresult tt_bundle_open(const char *path, tt_bundle **bundle);
+
+// Unloads the modules loaded from the bundle and unmaps it.
+void tt_bundle_close(tt_bundle *bundle);
+
+// Finds the binary of kernel `name` specialized for `spec` (the
+// `<signature hash>_<suffix>` part of the name of the generated kernel).
+// Returns 0 if the bundle doesn't contain it.
+int tt_bundle_find(const tt_bundle *bundle, const char *name, const char *spec,
+                   const void **image, size_t *size);
+
+// Returns the module of kernel `name` specialized for `spec`, loading it on
+// first use. Kernels with identical binaries share their module, which stays
+// loaded until the bundle is closed.
+CUresult tt_bundle_get_module(tt_bundle *bundle, const char *name,
+                              const char *spec, CUmodule *module);
+
+// The bundle kernels compiled with `compile.py --bundle` are loaded from.
+void tt_bundle_set_default(tt_bundle *bundle);
+tt_bundle *tt_bundle_get_default(void);
+
+#endif
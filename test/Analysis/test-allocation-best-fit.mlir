@@ -0,0 +1,52 @@
+// RUN: triton-opt %s -split-input-file --mlir-disable-threading -test-print-allocation="strategy=best-fit" 2>&1 | FileCheck %s
+
+#A_SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32} {
+
+// CHECK-LABEL: empty
+tt.func @empty() {
+  tt.return
+  // CHECK: size = 0
+  // CHECK-NEXT: peak live size = 0
+}
+
+// Larger buffers are placed first and smaller ones share the space once the
+// overlapping buffers are dead
+// CHECK-LABEL: largest_first
+tt.func @largest_first() {
+  // CHECK: offset = 0, size = 256
+  %a = triton_gpu.local_alloc : () -> !tt.memdesc<8x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK-NEXT: offset = 512, size = 128
+  %b = triton_gpu.local_alloc : () -> !tt.memdesc<8x8xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK-NEXT: offset = 256, size = 256
+  %c = triton_gpu.local_alloc : () -> !tt.memdesc<8x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %b : !tt.memdesc<8x8xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK-NEXT: offset = 512, size = 128
+  %d = triton_gpu.local_alloc : () -> !tt.memdesc<8x8xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %a : !tt.memdesc<8x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %c : !tt.memdesc<8x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %d : !tt.memdesc<8x8xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  tt.return
+  // CHECK-NEXT: size = 640
+  // CHECK-NEXT: peak live size = 640
+}
+
+// Small buffers fill the gaps left by the alignment of larger ones
+// CHECK-LABEL: alignment_gap
+tt.func @alignment_gap() {
+  // CHECK: offset = 0, size = 512
+  %a = triton_gpu.local_alloc : () -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK-NEXT: offset = 512, size = 128
+  %b = triton_gpu.local_alloc : () -> !tt.memdesc<8x8xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK-NEXT: offset = 1024, size = 512
+  %c = triton_gpu.local_alloc : () -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %a : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %b : !tt.memdesc<8x8xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  triton_gpu.local_dealloc %c : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  tt.return
+  // CHECK-NEXT: size = 1536
+  // CHECK-NEXT: peak live size = 1152
+}
+
+}
@@ -0,0 +1,42 @@
+// RUN: triton-opt %s -test-print-bank-conflicts 2>&1 | FileCheck %s
+// RUN: env TRITON_SMEM_SWIZZLE_CVT=1 triton-opt %s -test-print-bank-conflicts 2>&1 | FileCheck %s --check-prefix=SWIZZLE
+
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#AL_T = #triton_gpu.blocked<{sizePerThread = [4, 1], threadsPerWarp = [8, 4], warpsPerCTA = [1, 4], order = [0, 1]}>
+#COL = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [1, 4], order = [0, 1]}>
+#SHARED = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]}>
+#SHARED_SWIZZLED = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 32, order = [1, 0]}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// Each quarter warp stores a full row of 32 words.
+tt.func @row_store(%arg: tensor<32x32xf32, #AL>) {
+  %a = triton_gpu.local_alloc : () -> !tt.memdesc<32x32xf32, #SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK: remark: store: no bank conflicts, 8 wavefronts (8 without conflicts)
+  triton_gpu.local_store %arg, %a : tensor<32x32xf32, #AL> -> !tt.memdesc<32x32xf32, #SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK: remark: load: no bank conflicts, 8 wavefronts (8 without conflicts)
+  %0 = triton_gpu.local_load %a : !tt.memdesc<32x32xf32, #SHARED, #triton_gpu.shared_memory, mutable> -> tensor<32x32xf32, #AL>
+  tt.return
+}
+
+// The threads of a warp store a column, all in the same bank, unless the
+// columns are swizzled.
+tt.func @column_store(%arg: tensor<32x32xf32, #COL>) {
+  %a = triton_gpu.local_alloc : () -> !tt.memdesc<32x32xf32, #SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK: remark: store: 32-way bank conflicts, 256 wavefronts (8 without conflicts)
+  triton_gpu.local_store %arg, %a : tensor<32x32xf32, #COL> -> !tt.memdesc<32x32xf32, #SHARED, #triton_gpu.shared_memory, mutable>
+  // CHECK: remark: store: no bank conflicts, 8 wavefronts (8 without conflicts)
+  %b = triton_gpu.local_alloc %arg : (tensor<32x32xf32, #COL>) -> !tt.memdesc<32x32xf32, #SHARED_SWIZZLED, #triton_gpu.shared_memory>
+  tt.return
+}
+
+// The transposition is conflict-free with a padded scratch buffer, and with a
+// swizzled one that is 128 bytes smaller.
+tt.func @transpose(%arg: tensor<32x32xf32, #AL>) {
+  // CHECK: remark: store: no bank conflicts, 8 wavefronts (8 without conflicts); load: no bank conflicts, 8 wavefronts (8 without conflicts); scratch shape [33, 32]
+  // SWIZZLE: remark: store: no bank conflicts, 8 wavefronts (8 without conflicts); load: no bank conflicts, 8 wavefronts (8 without conflicts); scratch swizzled with vec = 1, perPhase = 1, maxPhase = 32
+  %0 = triton_gpu.convert_layout %arg : tensor<32x32xf32, #AL> -> tensor<32x32xf32, #AL_T>
+  tt.return
+}
+
+}
@@ -0,0 +1,54 @@
+// RUN: triton-opt %s --mlir-disable-threading --convert-scf-to-cf --allocate-shared-memory -test-print-membar="report=true" -verify-diagnostics
+
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#A_SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32} {
+
+tt.func @raw() {
+  %cst = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #AL>
+  %a = triton_gpu.local_alloc %cst : (tensor<16x16xf16, #AL>) -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory>
+  // expected-remark @below {{barrier for RAW hazard on shared memory [0, 512)}}
+  %0 = triton_gpu.local_load %a : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory> -> tensor<16x16xf16, #AL>
+  tt.return
+}
+
+tt.func @war() {
+  %a = triton_gpu.local_alloc : () -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  %0 = triton_gpu.local_load %a : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable> -> tensor<16x16xf16, #AL>
+  // expected-remark @below {{barrier for WAR hazard on shared memory [0, 512)}}
+  triton_gpu.local_store %0, %a : tensor<16x16xf16, #AL> -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  tt.return
+}
+
+tt.func @async_wait(%arg: tensor<32x16xf16, #AL>) {
+  %a = triton_gpu.local_alloc %arg : (tensor<32x16xf16, #AL>) -> !tt.memdesc<32x16xf16, #A_SHARED, #triton_gpu.shared_memory>
+  // expected-remark @below {{barrier after async wait}}
+  triton_gpu.async_wait {num = 4 : i32}
+  %0 = triton_gpu.local_load %a : !tt.memdesc<32x16xf16, #A_SHARED, #triton_gpu.shared_memory> -> tensor<32x16xf16, #AL>
+  tt.return
+}
+
+// The first visit of the loop body puts a barrier before the load of %a. Once
+// the store to %b at the end of the body is known, a barrier is needed before
+// the load of %b, which also covers the store to %a: the first barrier is
+// removed.
+tt.func @loop_covered_barrier(%lb : index, %ub : index, %step : index) {
+  %cst = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #AL>
+  %a = triton_gpu.local_alloc : () -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  %b = triton_gpu.local_alloc : () -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  %c = triton_gpu.local_alloc : () -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  scf.for %iv = %lb to %ub step %step {
+    triton_gpu.local_store %cst, %a : tensor<16x16xf16, #AL> -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+    // expected-remark @below {{barrier for RAW hazard on shared memory}}
+    %0 = triton_gpu.local_load %b : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable> -> tensor<16x16xf16, #AL>
+    %1 = triton_gpu.local_load %a : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable> -> tensor<16x16xf16, #AL>
+    triton_gpu.local_store %1, %c : tensor<16x16xf16, #AL> -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+    // expected-remark @below {{barrier for RAW hazard on shared memory}}
+    %2 = triton_gpu.local_load %c : !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable> -> tensor<16x16xf16, #AL>
+    triton_gpu.local_store %0, %b : tensor<16x16xf16, #AL> -> !tt.memdesc<16x16xf16, #A_SHARED, #triton_gpu.shared_memory, mutable>
+  }
+  tt.return
+}
+
+}
@@ -1630,6 +1630,27 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
   }
 }
 
+// -----
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0], hasLeadingOffset = false}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, triton_gpu.target = "cuda:80", "triton_gpu.threads-per-warp" = 32 : i32} {
+  // The address of the first vector of the thread is computed once, the others
+  // are at constant offsets from it.
+  // CHECK-LABEL: test_local_store_large_tile
+  // CHECK: %[[BASE:.*]] = llvm.getelementptr inbounds %{{.*}}[%{{.*}}] : (!llvm.ptr<3>, i32) -> !llvm.ptr<3>, f32
+  // CHECK-NOT: llvm.select
+  // CHECK: llvm.getelementptr inbounds %[[BASE]][%{{.*}}]
+  // CHECK: llvm.store
+  // CHECK-NOT: llvm.select
+  // CHECK: llvm.getelementptr inbounds %[[BASE]][%{{.*}}]
+  // CHECK: llvm.store
+  tt.func public @test_local_store_large_tile(%arg0: tensor<128x128xf32, #blocked>) {
+    %0 = triton_gpu.local_alloc {allocation.offset = 0 : i32} : () -> !tt.memdesc<128x128xf32, #shared, #triton_gpu.shared_memory, mutable>
+    triton_gpu.local_store %arg0, %0 : tensor<128x128xf32, #blocked> -> !tt.memdesc<128x128xf32, #shared, #triton_gpu.shared_memory, mutable>
+    tt.return
+  }
+}
+
 // -----
 
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
@@ -1,4 +1,5 @@
 // RUN: triton-opt %s -split-input-file -tritongpu-remove-layout-conversions 2>&1 | FileCheck %s
+// RUN: triton-opt %s -split-input-file --pass-pipeline='builtin.module(tt.func(tritongpu-remove-layout-conversions))' 2>&1 | FileCheck %s
 
 #layout0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
 #layout1 = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
@@ -2589,3 +2590,47 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 8 :
     // CHECK: tt.return %[[W]]#0, %[[W]]#1 : tensor<64x64xf32, #mma>, tensor<64x128xf32, #mma1>
   }
 }
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // Functions without layout conversions are left as is.
+  // CHECK-LABEL: @no_convert
+  tt.func public @no_convert(%arg0: tensor<512x!tt.ptr<f32>, #blocked>, %arg1: i32) -> tensor<512xf16, #blocked> {
+    %c0_i32 = arith.constant 0 : i32
+    %c1_i32 = arith.constant 1 : i32
+    %cst = arith.constant dense<0.000000e+00> : tensor<512xf32, #blocked>
+    // CHECK-NOT: triton_gpu.convert_layout
+    // CHECK: scf.for {{.*}} -> (tensor<512xf32, #blocked>)
+    %0 = scf.for %arg2 = %c0_i32 to %arg1 step %c1_i32 iter_args(%arg3 = %cst) -> (tensor<512xf32, #blocked>) : i32 {
+      %2 = tt.load %arg0 : tensor<512x!tt.ptr<f32>, #blocked>
+      %3 = arith.addf %arg3, %2 : tensor<512xf32, #blocked>
+      scf.yield %3 : tensor<512xf32, #blocked>
+    }
+    // CHECK: arith.truncf {{.*}} : tensor<512xf32, #blocked> to tensor<512xf16, #blocked>
+    %1 = arith.truncf %0 : tensor<512xf32, #blocked> to tensor<512xf16, #blocked>
+    tt.return %1 : tensor<512xf16, #blocked>
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // Values not connected to a layout conversion are left as is, and the others
+  // are still propagated.
+  // CHECK-DAG: #[[BLOCKED:.+]] = #triton_gpu.blocked<{sizePerThread = [4]
+  // CHECK-DAG: #[[BLOCKED1:.+]] = #triton_gpu.blocked<{sizePerThread = [1]
+  // CHECK-LABEL: @unconnected_slices
+  tt.func public @unconnected_slices(%arg0: tensor<512xf32, #blocked>, %arg1: tensor<512xf32, #blocked1>) -> (tensor<512xf32, #blocked>, tensor<512xf32, #blocked>) {
+    // CHECK: arith.addf %arg0, %arg0 : tensor<512xf32, #[[BLOCKED]]>
+    %0 = arith.addf %arg0, %arg0 : tensor<512xf32, #blocked>
+    // CHECK: %[[M:.+]] = arith.mulf %arg1, %arg1 : tensor<512xf32, #[[BLOCKED1]]>
+    // CHECK: triton_gpu.convert_layout %[[M]] : tensor<512xf32, #[[BLOCKED1]]> -> tensor<512xf32, #[[BLOCKED]]>
+    %1 = triton_gpu.convert_layout %arg1 : tensor<512xf32, #blocked1> -> tensor<512xf32, #blocked>
+    %2 = arith.mulf %1, %1 : tensor<512xf32, #blocked>
+    tt.return %0, %2 : tensor<512xf32, #blocked>, tensor<512xf32, #blocked>
+  }
+}
@@ -10,6 +10,9 @@ struct TestAllocationPass
 
   MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestAllocationPass);
 
+  TestAllocationPass() = default;
+  TestAllocationPass(const TestAllocationPass &other) : PassWrapper(other) {}
+
   StringRef getArgument() const final { return "test-print-allocation"; }
   StringRef getDescription() const final {
     return "print the result of the allocation pass";
@@ -18,8 +21,17 @@ struct TestAllocationPass
   void runOnOperation() override {
     auto &os = llvm::errs();
     ModuleOp moduleOp = getOperation();
+    auto allocationStrategy = triton::getDefaultAllocationStrategy();
+    if (!strategy.empty()) {
+      auto parsedStrategy = triton::parseAllocationStrategy(strategy);
+      if (!parsedStrategy) {
+        moduleOp.emitError("unknown allocation strategy: ") << strategy;
+        return signalPassFailure();
+      }
+      allocationStrategy = *parsedStrategy;
+    }
     // Convert to std::string can remove quotes from opName
-    ModuleAllocation moduleAllocation(moduleOp);
+    ModuleAllocation moduleAllocation(moduleOp, allocationStrategy);
     moduleOp.walk([&](triton::FuncOp funcOp) {
       auto opName = SymbolTable::getSymbolName(funcOp).getValue().str();
       os << opName << "\n";
@@ -46,8 +58,14 @@ struct TestAllocationPass
         }
       });
       os << "size = " << allocation->getSharedMemorySize() << "\n";
+      os << "peak live size = " << allocation->getPeakLiveSize() << "\n";
     });
   }
+
+  Option<std::string> strategy{
+      *this, "strategy",
+      llvm::cl::desc("allocation strategy (graph-coloring or best-fit)"),
+      llvm::cl::init("")};
 };
 
 } // namespace
@@ -0,0 +1,66 @@
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/BankConflicts.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+
+using namespace mlir;
+
+namespace {
+
+struct TestBankConflictsPass
+    : public PassWrapper<TestBankConflictsPass,
+                         OperationPass<triton::FuncOp>> {
+
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestBankConflictsPass);
+
+  StringRef getArgument() const final { return "test-print-bank-conflicts"; }
+  StringRef getDescription() const final {
+    return "emit a remark with the expected bank conflicts of each shared "
+           "memory access";
+  }
+
+  void runOnOperation() override {
+    getOperation()->walk([&](Operation *op) {
+      auto conflicts = triton::getSharedAccessConflicts(op);
+      if (!conflicts.store && !conflicts.load)
+        return;
+      std::string message;
+      llvm::raw_string_ostream os(message);
+      if (conflicts.store) {
+        os << "store: ";
+        conflicts.store->print(os);
+      }
+      if (conflicts.store && conflicts.load)
+        os << "; ";
+      if (conflicts.load) {
+        os << "load: ";
+        conflicts.load->print(os);
+      }
+      if (auto cvt = dyn_cast<triton::gpu::ConvertLayoutOp>(op)) {
+        auto config = triton::getScratchConfigForCvt(cvt.getSrc().getType(),
+                                                     cvt.getType());
+        if (config.maxPhase > 1) {
+          os << "; scratch swizzled with vec = " << config.swizzleVec
+             << ", perPhase = " << config.perPhase
+             << ", maxPhase = " << config.maxPhase;
+        } else {
+          os << "; scratch shape [";
+          llvm::interleaveComma(config.paddedRepShape, os);
+          os << "]";
+        }
+      }
+      op->emitRemark() << os.str();
+    });
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace test {
+void registerTestBankConflictsPass() {
+  PassRegistration<TestBankConflictsPass>();
+}
+} // namespace test
+} // namespace mlir
@@ -15,6 +15,9 @@ struct TestMembarPass
 
   MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestMembarPass);
 
+  TestMembarPass() = default;
+  TestMembarPass(const TestMembarPass &other) : PassWrapper(other) {}
+
   StringRef getArgument() const final { return "test-print-membar"; }
   StringRef getDescription() const final {
     return "print the result of the allocation pass";
@@ -27,7 +30,17 @@ struct TestMembarPass
     ModuleAllocation allocation(moduleOp);
     ModuleMembarAnalysis membarPass(&allocation);
     membarPass.run();
+    if (report) {
+      for (auto &info : membarPass.getBarriers())
+        info.barrier->emitRemark() << info.getReason();
+    }
   }
+
+  Option<bool> report{
+      *this, "report",
+      llvm::cl::desc("emit a remark for each inserted barrier with the hazard "
+                     "it resolves"),
+      llvm::cl::init(false)};
 };
 
 } // namespace
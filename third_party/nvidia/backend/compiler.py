@@ -281,10 +281,11 @@ class CUDABackend(BaseBackend):
 
         # Get some metadata
         metadata["shared"] = src.get_int_attr("triton_gpu.shared")
-        ret = str(llvm_mod)
-        del llvm_mod
-        del context
-        return ret
+        # Hand the module itself to the next stage rather than its textual form:
+        # `make_ptx` feeds it straight into the backend without re-parsing, and
+        # the cache/dump managers only stringify it when they write it out.
+        # `llvm_mod` keeps `context` alive.
+        return llvm_mod
 
     @staticmethod
     def make_ptx(src, metadata, opt, capability):
@@ -296,6 +297,8 @@ class CUDABackend(BaseBackend):
         triple = 'nvptx64-nvidia-cuda'
         proc = 'sm_90a' if capability == 90 else f'sm_{capability}'
         features = get_features(opt)
+        # `src` is either the llvm module produced by `make_llir` or, when the
+        # stage is overridden, its textual form.
         ret = llvm.translate_to_asm(src, triple, proc, features, ['nvptx-short-ptr'], opt.enable_fp_fusion, False)
         # Find kernel names (there should only be one)
         names = re.findall(r".visible .entry ([a-zA-Z_][a-zA-Z0-9_]*)", ret)
@@ -331,8 +334,15 @@ class CUDABackend(BaseBackend):
                 subprocess.run(ptxas_cmd, check=True, close_fds=False, stderr=flog)
                 if os.path.exists(fsrc.name):
                     os.remove(fsrc.name)
+                with open(flog.name) as log_file:
+                    log = log_file.read()
                 if os.path.exists(flog.name):
                     os.remove(flog.name)
+                # `-v` reports the registers of the kernel, which lets the autotuner discard configs that cannot be
+                # launched without loading them
+                match = re.search(rf"entry function '{metadata['name']}'.*?Used (\d+) registers", log, re.DOTALL)
+                if match:
+                    metadata["n_regs"] = int(match.group(1))
             except subprocess.CalledProcessError as e:
                 with open(flog.name) as log_file:
                     log = log_file.read()
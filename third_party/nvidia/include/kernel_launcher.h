@@ -0,0 +1,636 @@
+#ifndef TRITON_KERNEL_LAUNCHER_H
+#define TRITON_KERNEL_LAUNCHER_H
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "backend/include/cuda.h"
+#include <cstdint>
+#include <cstring>
+#include <dlfcn.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class LaunchGraph;
+
+// The launch arguments that precede the arguments of the kernel, see
+// `KernelLauncher::launch`.
+struct LaunchConfig {
+  int gridX, gridY, gridZ;
+  uint64_t stream, function;
+  int numWarps, numCtas, sharedMemory, clusterDimX, clusterDimY, clusterDimZ;
+
+  bool isEmpty() const { return gridX * gridY * gridZ <= 0; }
+};
+
+// Opens the CUDA driver library, reusing the handle if it is already loaded.
+inline void *openLibcuda(const std::string &libcuda) {
+  void *handle = dlopen(libcuda.c_str(), RTLD_NOLOAD | RTLD_LAZY);
+  if (handle == nullptr)
+    handle = dlopen(libcuda.c_str(), RTLD_LOCAL | RTLD_LAZY);
+  if (handle == nullptr)
+    throw std::runtime_error("Failed to open " + libcuda);
+  return handle;
+}
+
+// Launches kernels of any signature, without generating and compiling a C
+// launcher per signature.
+//
+// The signature is given as a string with one character per argument of the
+// kernel, after the constexprs are removed:
+//
+//   'P': pointer, i.e. an int, None, or an object with a `data_ptr` method
+//   'T': nvTmaDesc, an object with a `tma_desc_cpu_ptr` method
+//   'b', 'h', 'i', 'l': int8_t, int16_t, int32_t, int64_t
+//   'B', 'H', 'I', 'K': uint8_t, uint16_t, uint32_t, uint64_t
+//   'f', 'd': float, double
+//   '-': an argument specialized to a constant, which is not passed
+//
+// The arguments are marshalled into a `void *` params array, which is reused
+// across the launches from the same thread.  The CUDA driver is looked up at
+// runtime, see `libcuda`.
+class KernelLauncher {
+  typedef CUresult (*cuLaunchKernel_t)(CUfunction, unsigned int, unsigned int,
+                                       unsigned int, unsigned int,
+                                       unsigned int, unsigned int,
+                                       unsigned int, CUstream, void **,
+                                       void **);
+  typedef CUresult (*cuLaunchKernelEx_t)(const CUlaunchConfig *, CUfunction,
+                                         void **, void **);
+  typedef CUresult (*cuPointerGetAttribute_t)(void *, CUpointer_attribute,
+                                              CUdeviceptr);
+  typedef CUresult (*cuGetErrorString_t)(CUresult, const char **);
+
+  cuLaunchKernel_t cuLaunchKernel;
+  // Only available on recent drivers, only needed by clusters
+  cuLaunchKernelEx_t cuLaunchKernelEx;
+  cuPointerGetAttribute_t cuPointerGetAttribute;
+  cuGetErrorString_t cuGetErrorString;
+
+  std::string signature;
+  // Number of arguments passed to the kernel
+  int numParams = 0;
+
+  void loadDriver(const std::string &libcuda) {
+    void *handle = openLibcuda(libcuda);
+    cuLaunchKernel = (cuLaunchKernel_t)dlsym(handle, "cuLaunchKernel");
+    cuLaunchKernelEx = (cuLaunchKernelEx_t)dlsym(handle, "cuLaunchKernelEx");
+    cuPointerGetAttribute =
+        (cuPointerGetAttribute_t)dlsym(handle, "cuPointerGetAttribute");
+    cuGetErrorString = (cuGetErrorString_t)dlsym(handle, "cuGetErrorString");
+    if (!cuLaunchKernel || !cuPointerGetAttribute || !cuGetErrorString)
+      throw std::runtime_error("Failed to load the driver API from " + libcuda);
+  }
+
+  // Returns false and sets a Python error if code is not CUDA_SUCCESS.
+  bool cudaCheck(CUresult code) const {
+    if (code == CUDA_SUCCESS)
+      return true;
+    const char *str = nullptr;
+    cuGetErrorString(code, &str);
+    PyErr_Format(PyExc_RuntimeError, "Triton Error [CUDA]: %s",
+                 str ? str : "unknown error");
+    return false;
+  }
+
+  bool callHook(PyObject *hook, PyObject *launchMetadata) const {
+    if (hook == Py_None)
+      return true;
+    PyObject *ret = PyObject_CallFunctionObjArgs(hook, launchMetadata, nullptr);
+    Py_XDECREF(ret);
+    return ret != nullptr;
+  }
+
+  bool getPointer(PyObject *obj, int idx, CUdeviceptr &ptr) const {
+    ptr = 0;
+    if (PyLong_Check(obj)) {
+      ptr = PyLong_AsUnsignedLongLong(obj);
+      return !PyErr_Occurred();
+    }
+    if (obj == Py_None) {
+      // valid nullptr
+      return true;
+    }
+    PyObject *dataPtr = PyObject_GetAttrString(obj, "data_ptr");
+    if (!dataPtr) {
+      PyErr_SetString(PyExc_TypeError, "Pointer argument must be either "
+                                       "uint64 or have data_ptr method");
+      return false;
+    }
+    PyObject *ret = PyObject_CallObject(dataPtr, nullptr);
+    Py_DECREF(dataPtr);
+    if (!ret)
+      return false;
+    if (!PyLong_Check(ret)) {
+      Py_DECREF(ret);
+      PyErr_SetString(PyExc_TypeError, "data_ptr method of Pointer object "
+                                       "must return 64-bit int");
+      return false;
+    }
+    ptr = PyLong_AsUnsignedLongLong(ret);
+    Py_DECREF(ret);
+    if (PyErr_Occurred())
+      return false;
+    if (!ptr)
+      return true;
+    uint64_t devPtr;
+    CUresult status = cuPointerGetAttribute(
+        &devPtr, CU_POINTER_ATTRIBUTE_DEVICE_POINTER, ptr);
+    if (status == CUDA_ERROR_INVALID_VALUE) {
+      PyErr_Format(PyExc_ValueError,
+                   "Pointer argument (at %d) cannot be accessed from Triton "
+                   "(cpu tensor?)",
+                   idx);
+      return false;
+    }
+    if (status == CUDA_SUCCESS)
+      ptr = devPtr;
+    return true;
+  }
+
+  static CUtensorMap *getTmaDesc(PyObject *obj) {
+    PyObject *method = PyObject_GetAttrString(obj, "tma_desc_cpu_ptr");
+    if (!method) {
+      PyErr_SetString(PyExc_TypeError,
+                      "tma_desc_cpu_ptr() method does not exist");
+      return nullptr;
+    }
+    PyObject *ret = PyObject_CallObject(method, nullptr);
+    Py_DECREF(method);
+    if (!ret)
+      return nullptr;
+    if (!PyLong_Check(ret)) {
+      Py_DECREF(ret);
+      PyErr_SetString(PyExc_TypeError,
+                      "tma_desc_cpu_ptr() must return 64-bit int");
+      return nullptr;
+    }
+    uint64_t ptr = PyLong_AsUnsignedLongLong(ret);
+    Py_DECREF(ret);
+    if (PyErr_Occurred())
+      return nullptr;
+    if (!ptr) {
+      PyErr_SetString(PyExc_ValueError,
+                      "received NULL ptr from tma_desc_cpu_ptr()");
+      return nullptr;
+    }
+    if (ptr % 64 != 0) {
+      PyErr_SetString(PyExc_ValueError,
+                      "tma_desc_cpu_ptr() must be 64-byte aligned");
+      return nullptr;
+    }
+    return reinterpret_cast<CUtensorMap *>(ptr);
+  }
+
+  template <typename T> static bool getSigned(PyObject *obj, void *slot) {
+    long long value = PyLong_AsLongLong(obj);
+    if (value == -1 && PyErr_Occurred())
+      return false;
+    if (value < std::numeric_limits<T>::min() ||
+        value > std::numeric_limits<T>::max()) {
+      PyErr_Format(PyExc_OverflowError, "%lld does not fit in %d bits", value,
+                   int(8 * sizeof(T)));
+      return false;
+    }
+    T converted = value;
+    std::memcpy(slot, &converted, sizeof(T));
+    return true;
+  }
+
+  // Like PyArg_ParseTuple, unsigned values are not checked for overflow.
+  template <typename T> static bool getUnsigned(PyObject *obj, void *slot) {
+    unsigned long long value = PyLong_AsUnsignedLongLongMask(obj);
+    if (value == (unsigned long long)-1 && PyErr_Occurred())
+      return false;
+    T converted = value;
+    std::memcpy(slot, &converted, sizeof(T));
+    return true;
+  }
+
+  template <typename T> static bool getFloat(PyObject *obj, void *slot) {
+    double value = PyFloat_AsDouble(obj);
+    if (value == -1.0 && PyErr_Occurred())
+      return false;
+    T converted = value;
+    std::memcpy(slot, &converted, sizeof(T));
+    return true;
+  }
+
+  // Converts `arg` and stores it in `slot`, or in `params` directly if the
+  // kernel takes it by reference.
+  bool getParam(char kind, PyObject *arg, int idx, uint64_t *slot,
+                void *&param) const {
+    param = slot;
+    switch (kind) {
+    case 'P': {
+      CUdeviceptr ptr;
+      if (!getPointer(arg, idx, ptr))
+        return false;
+      std::memcpy(slot, &ptr, sizeof(ptr));
+      return true;
+    }
+    case 'T':
+      // The descriptor is copied by the driver when the kernel is launched
+      param = getTmaDesc(arg);
+      return param != nullptr;
+    case 'b':
+      return getSigned<int8_t>(arg, slot);
+    case 'h':
+      return getSigned<int16_t>(arg, slot);
+    case 'i':
+      return getSigned<int32_t>(arg, slot);
+    case 'l':
+      return getSigned<int64_t>(arg, slot);
+    case 'B':
+      return getUnsigned<uint8_t>(arg, slot);
+    case 'H':
+      return getUnsigned<uint16_t>(arg, slot);
+    case 'I':
+      return getUnsigned<uint32_t>(arg, slot);
+    case 'K':
+      return getUnsigned<uint64_t>(arg, slot);
+    case 'f':
+      return getFloat<float>(arg, slot);
+    case 'd':
+      return getFloat<double>(arg, slot);
+    }
+    PyErr_Format(PyExc_SystemError, "Invalid argument kind '%c'", kind);
+    return false;
+  }
+
+public:
+  // `libcuda` is the name or the path of the CUDA driver library.
+  KernelLauncher(std::string signature,
+                 const std::string &libcuda = "libcuda.so.1")
+      : signature(std::move(signature)) {
+    for (char kind : this->signature) {
+      if (std::string("PTbhilBHIKfd-").find(kind) == std::string::npos)
+        throw std::invalid_argument("Invalid kernel signature '" +
+                                    this->signature + "'");
+      numParams += kind != '-';
+    }
+    loadDriver(libcuda);
+  }
+
+  const std::string &getSignature() const { return signature; }
+
+  // Parses the launch arguments of `args`, checking that it also holds one
+  // argument per character of the signature.
+  bool getConfig(PyObject *args, LaunchConfig &config) const {
+    Py_ssize_t numArgs = PyTuple_GET_SIZE(args);
+    if (numArgs != numLaunchArgs + Py_ssize_t(signature.size())) {
+      PyErr_Format(PyExc_TypeError,
+                   "Kernel launch expects %zd arguments, got %zd",
+                   numLaunchArgs + Py_ssize_t(signature.size()), numArgs);
+      return false;
+    }
+    auto launchArg = [&](int i) { return PyTuple_GET_ITEM(args, i); };
+    if (!getSigned<int>(launchArg(0), &config.gridX) ||
+        !getSigned<int>(launchArg(1), &config.gridY) ||
+        !getSigned<int>(launchArg(2), &config.gridZ) ||
+        !getUnsigned<uint64_t>(launchArg(3), &config.stream) ||
+        !getUnsigned<uint64_t>(launchArg(4), &config.function))
+      return false;
+    if (!PyArg_ParseTuple(launchArg(5), "iiiiii", &config.numWarps,
+                          &config.numCtas, &config.sharedMemory,
+                          &config.clusterDimX, &config.clusterDimY,
+                          &config.clusterDimZ)) {
+      PyErr_SetString(PyExc_TypeError, "kernel_metadata must be a tuple");
+      return false;
+    }
+    return true;
+  }
+
+  // Marshals the arguments of the kernel, the items of `args` from `first` on,
+  // into a params array. The array is reused by the next call from the same
+  // thread. Returns null and sets a Python error on failure.
+  void **getParams(PyObject *args, Py_ssize_t first) const {
+    // The buffers are only used by this thread, the driver copies the params
+    // when the kernel is launched.
+    thread_local std::vector<uint64_t> slots;
+    thread_local std::vector<void *> params;
+    if (PyTuple_GET_SIZE(args) - first != Py_ssize_t(signature.size())) {
+      PyErr_Format(PyExc_TypeError, "Kernel expects %zd arguments, got %zd",
+                   Py_ssize_t(signature.size()),
+                   PyTuple_GET_SIZE(args) - first);
+      return nullptr;
+    }
+    slots.resize(numParams);
+    // Never empty, so that null only means failure
+    params.resize(numParams + 1);
+    int p = 0;
+    for (int i = 0; i < int(signature.size()); i++) {
+      if (signature[i] == '-')
+        continue;
+      PyObject *arg = PyTuple_GET_ITEM(args, first + i);
+      if (!getParam(signature[i], arg, i, &slots[p], params[p]))
+        return nullptr;
+      p++;
+    }
+    return params.data();
+  }
+
+  // Takes the same arguments as the generated launchers:
+  //   (gridX, gridY, gridZ, stream, function, kernel_metadata,
+  //    launch_metadata, launch_enter_hook, launch_exit_hook, *args)
+  // where kernel_metadata is (num_warps, num_ctas, shared_memory,
+  // clusterDimX, clusterDimY, clusterDimZ).
+  //
+  // While a `LaunchGraph` is capturing on this thread, the launch is recorded
+  // in it instead, and the hooks are not called.
+  //
+  // Returns false and sets a Python error on failure.
+  bool launch(PyObject *args) const;
+
+  static constexpr Py_ssize_t numLaunchArgs = 9;
+};
+
+// A sequence of kernel launches, recorded once and replayed with a single
+// call to the driver, as a CUDA graph.
+//
+// Launches made through any `KernelLauncher` of the capturing thread, between
+// `beginCapture` and `endCapture`, are added to the graph instead of being
+// launched. Each depends on the previous one, as on a stream. Launches with an
+// empty grid are not recorded. The graph is instantiated on the first replay;
+// the arguments of the recorded kernels can then be changed in place with
+// `update`, without capturing again.
+class LaunchGraph {
+  typedef CUresult (*cuGraphCreate_t)(CUgraph *, unsigned int);
+  typedef CUresult (*cuGraphDestroy_t)(CUgraph);
+  typedef CUresult (*cuGraphAddKernelNode_t)(
+      CUgraphNode *, CUgraph, const CUgraphNode *, size_t,
+      const CUDA_KERNEL_NODE_PARAMS_v1 *);
+  typedef CUresult (*cuGraphKernelNodeSetAttribute_t)(
+      CUgraphNode, CUlaunchAttributeID, const CUlaunchAttributeValue *);
+  typedef CUresult (*cuGraphInstantiateWithFlags_t)(CUgraphExec *, CUgraph,
+                                                    unsigned long long);
+  typedef CUresult (*cuGraphExecDestroy_t)(CUgraphExec);
+  typedef CUresult (*cuGraphExecKernelNodeSetParams_t)(
+      CUgraphExec, CUgraphNode, const CUDA_KERNEL_NODE_PARAMS_v1 *);
+  typedef CUresult (*cuGraphLaunch_t)(CUgraphExec, CUstream);
+  typedef CUresult (*cuGetErrorString_t)(CUresult, const char **);
+
+  cuGraphCreate_t cuGraphCreate;
+  cuGraphDestroy_t cuGraphDestroy;
+  cuGraphAddKernelNode_t cuGraphAddKernelNode;
+  cuGraphKernelNodeSetAttribute_t cuGraphKernelNodeSetAttribute;
+  cuGraphInstantiateWithFlags_t cuGraphInstantiateWithFlags;
+  cuGraphExecDestroy_t cuGraphExecDestroy;
+  cuGraphExecKernelNodeSetParams_t cuGraphExecKernelNodeSetParams;
+  cuGraphLaunch_t cuGraphLaunch;
+  cuGetErrorString_t cuGetErrorString;
+
+  struct Node {
+    // A copy of the launcher of the kernel, to marshal updated arguments
+    KernelLauncher launcher;
+    CUgraphNode node;
+    // Without the kernel params, which are copied by the driver
+    CUDA_KERNEL_NODE_PARAMS_v1 params;
+  };
+
+  CUgraph graph = nullptr;
+  CUgraphExec exec = nullptr;
+  std::vector<Node> nodes;
+
+  static LaunchGraph *&capturing() {
+    static thread_local LaunchGraph *graph = nullptr;
+    return graph;
+  }
+
+  void loadDriver(const std::string &libcuda) {
+    void *handle = openLibcuda(libcuda);
+#define TRITON_LOAD_GRAPH_API(name)                                            \
+  name = (name##_t)dlsym(handle, #name);                                       \
+  if (!name)                                                                   \
+    throw std::runtime_error("Failed to load " #name " from " + libcuda);
+    TRITON_LOAD_GRAPH_API(cuGraphCreate)
+    TRITON_LOAD_GRAPH_API(cuGraphDestroy)
+    TRITON_LOAD_GRAPH_API(cuGraphAddKernelNode)
+    TRITON_LOAD_GRAPH_API(cuGraphKernelNodeSetAttribute)
+    TRITON_LOAD_GRAPH_API(cuGraphInstantiateWithFlags)
+    TRITON_LOAD_GRAPH_API(cuGraphExecDestroy)
+    TRITON_LOAD_GRAPH_API(cuGraphExecKernelNodeSetParams)
+    TRITON_LOAD_GRAPH_API(cuGraphLaunch)
+    TRITON_LOAD_GRAPH_API(cuGetErrorString)
+#undef TRITON_LOAD_GRAPH_API
+  }
+
+  bool cudaCheck(CUresult code) const {
+    if (code == CUDA_SUCCESS)
+      return true;
+    const char *str = nullptr;
+    cuGetErrorString(code, &str);
+    PyErr_Format(PyExc_RuntimeError, "Triton Error [CUDA]: %s",
+                 str ? str : "unknown error");
+    return false;
+  }
+
+  void reset() {
+    if (exec)
+      cuGraphExecDestroy(exec);
+    if (graph)
+      cuGraphDestroy(graph);
+    exec = nullptr;
+    graph = nullptr;
+    nodes.clear();
+  }
+
+public:
+  explicit LaunchGraph(const std::string &libcuda = "libcuda.so.1") {
+    loadDriver(libcuda);
+  }
+
+  LaunchGraph(const LaunchGraph &) = delete;
+  LaunchGraph &operator=(const LaunchGraph &) = delete;
+
+  ~LaunchGraph() {
+    if (capturing() == this)
+      capturing() = nullptr;
+    reset();
+  }
+
+  static LaunchGraph *getCapturing() { return capturing(); }
+
+  // Drops the launches recorded so far and starts recording.
+  bool beginCapture() {
+    if (capturing()) {
+      PyErr_SetString(PyExc_RuntimeError,
+                      "Kernel launches are already being captured");
+      return false;
+    }
+    reset();
+    if (!cudaCheck(cuGraphCreate(&graph, 0)))
+      return false;
+    capturing() = this;
+    return true;
+  }
+
+  void endCapture() {
+    if (capturing() == this)
+      capturing() = nullptr;
+  }
+
+  size_t size() const { return nodes.size(); }
+
+  // Adds the launch of `launcher` with `args`, see `KernelLauncher::launch`.
+  bool record(const KernelLauncher &launcher, const LaunchConfig &config,
+              PyObject *args) {
+    if (config.isEmpty())
+      return true;
+    void **kernelParams =
+        launcher.getParams(args, KernelLauncher::numLaunchArgs);
+    if (!kernelParams)
+      return false;
+    CUDA_KERNEL_NODE_PARAMS_v1 params = {};
+    params.func = (CUfunction)config.function;
+    params.gridDimX = config.gridX * config.clusterDimX;
+    params.gridDimY = config.gridY * config.clusterDimY;
+    params.gridDimZ = config.gridZ * config.clusterDimZ;
+    params.blockDimX = 32 * config.numWarps;
+    params.blockDimY = 1;
+    params.blockDimZ = 1;
+    params.sharedMemBytes = config.sharedMemory;
+    params.kernelParams = kernelParams;
+    CUgraphNode node;
+    const CUgraphNode *deps = nodes.empty() ? nullptr : &nodes.back().node;
+    if (!cudaCheck(cuGraphAddKernelNode(&node, graph, deps, deps ? 1 : 0,
+                                        &params)))
+      return false;
+    if (config.numCtas > 1) {
+      CUlaunchAttributeValue value;
+      value.clusterDim.x = config.clusterDimX;
+      value.clusterDim.y = config.clusterDimY;
+      value.clusterDim.z = config.clusterDimZ;
+      if (!cudaCheck(cuGraphKernelNodeSetAttribute(
+              node, CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION, &value)))
+        return false;
+      value.clusterSchedulingPolicyPreference =
+          CU_CLUSTER_SCHEDULING_POLICY_SPREAD;
+      if (!cudaCheck(cuGraphKernelNodeSetAttribute(
+              node, CU_LAUNCH_ATTRIBUTE_CLUSTER_SCHEDULING_POLICY_PREFERENCE,
+              &value)))
+        return false;
+    }
+    params.kernelParams = nullptr;
+    nodes.push_back({launcher, node, params});
+    return true;
+  }
+
+  // Replaces the arguments of the kernel of the `index`-th recorded launch
+  // with `args`, which holds one argument per character of its signature.
+  bool update(size_t index, PyObject *args) {
+    if (index >= nodes.size()) {
+      PyErr_SetString(PyExc_IndexError, "launch index out of range");
+      return false;
+    }
+    if (capturing() == this) {
+      PyErr_SetString(PyExc_RuntimeError,
+                      "Launches can't be updated while capturing");
+      return false;
+    }
+    Node &node = nodes[index];
+    CUDA_KERNEL_NODE_PARAMS_v1 params = node.params;
+    params.kernelParams = node.launcher.getParams(args, 0);
+    if (!params.kernelParams)
+      return false;
+    return instantiate() &&
+           cudaCheck(cuGraphExecKernelNodeSetParams(exec, node.node, &params));
+  }
+
+  bool instantiate() {
+    if (exec)
+      return true;
+    if (!graph) {
+      PyErr_SetString(PyExc_RuntimeError, "No kernel launches were captured");
+      return false;
+    }
+    return cudaCheck(cuGraphInstantiateWithFlags(&exec, graph, 0));
+  }
+
+  // Launches the recorded kernels on `stream`.
+  bool replay(uint64_t stream) {
+    if (capturing() == this) {
+      PyErr_SetString(PyExc_RuntimeError,
+                      "The graph can't be replayed while capturing");
+      return false;
+    }
+    if (!instantiate())
+      return false;
+    CUresult result;
+    Py_BEGIN_ALLOW_THREADS;
+    result = cuGraphLaunch(exec, (CUstream)stream);
+    Py_END_ALLOW_THREADS;
+    return cudaCheck(result);
+  }
+};
+
+inline bool KernelLauncher::launch(PyObject *args) const {
+  LaunchConfig config;
+  if (!getConfig(args, config))
+    return false;
+  if (LaunchGraph *graph = LaunchGraph::getCapturing())
+    return graph->record(*this, config, args);
+
+  PyObject *launchMetadata = PyTuple_GET_ITEM(args, 6);
+  PyObject *launchEnterHook = PyTuple_GET_ITEM(args, 7);
+  PyObject *launchExitHook = PyTuple_GET_ITEM(args, 8);
+  if (!callHook(launchEnterHook, launchMetadata))
+    return false;
+
+  // Raise exceptions asap.
+  void **params = getParams(args, numLaunchArgs);
+  if (!params)
+    return false;
+
+  CUresult result = CUDA_SUCCESS;
+  bool missingLaunchKernelEx = false;
+  Py_BEGIN_ALLOW_THREADS;
+  if (!config.isEmpty()) {
+    if (config.numCtas == 1) {
+      result = cuLaunchKernel((CUfunction)config.function, config.gridX,
+                              config.gridY, config.gridZ, 32 * config.numWarps,
+                              1, 1, config.sharedMemory,
+                              (CUstream)config.stream, params, nullptr);
+    } else if (!cuLaunchKernelEx) {
+      missingLaunchKernelEx = true;
+    } else {
+      CUlaunchAttribute launchAttr[2];
+      launchAttr[0].id = CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION;
+      launchAttr[0].value.clusterDim.x = config.clusterDimX;
+      launchAttr[0].value.clusterDim.y = config.clusterDimY;
+      launchAttr[0].value.clusterDim.z = config.clusterDimZ;
+      launchAttr[1].id =
+          CU_LAUNCH_ATTRIBUTE_CLUSTER_SCHEDULING_POLICY_PREFERENCE;
+      launchAttr[1].value.clusterSchedulingPolicyPreference =
+          CU_CLUSTER_SCHEDULING_POLICY_SPREAD;
+      CUlaunchConfig launchConfig;
+      launchConfig.gridDimX = config.gridX * config.clusterDimX;
+      launchConfig.gridDimY = config.gridY * config.clusterDimY;
+      launchConfig.gridDimZ = config.gridZ * config.clusterDimZ;
+      launchConfig.blockDimX = 32 * config.numWarps;
+      launchConfig.blockDimY = 1;
+      launchConfig.blockDimZ = 1;
+      launchConfig.sharedMemBytes = config.sharedMemory;
+      launchConfig.hStream = (CUstream)config.stream;
+      launchConfig.attrs = launchAttr;
+      launchConfig.numAttrs = 2;
+      result = cuLaunchKernelEx(&launchConfig, (CUfunction)config.function,
+                                params, nullptr);
+    }
+  }
+  Py_END_ALLOW_THREADS;
+  if (missingLaunchKernelEx) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "Failed to retrieve cuLaunchKernelEx from libcuda.so.1");
+    return false;
+  }
+  if (!cudaCheck(result))
+    return false;
+
+  return callHook(launchExitHook, launchMetadata);
+}
+
+#endif // TRITON_KERNEL_LAUNCHER_H
@@ -2,6 +2,7 @@
 #include "NVGPUToLLVM/NVGPUToLLVMPass.h"
 #include "TritonNVIDIAGPUToLLVM/Passes.h"
 #include "cublas_instance.h"
+#include "kernel_launcher.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Target/LLVMIR/Dialect/NVVM/NVVMToLLVMIRTranslation.h"
 #include "passes.h"
@@ -158,4 +159,36 @@ void init_triton_nvidia(py::module &&m) {
         self.matmul(A_shape[0], B_shape[0], A_shape[1], A_ptr, B_ptr, C_ptr,
                     dtype);
       });
+
+  // launcher
+  auto launcher = m.def_submodule("launcher");
+
+  py::class_<KernelLauncher>(launcher, "KernelLauncher")
+      .def(py::init<std::string, std::string>(), py::arg("signature"),
+           py::arg("libcuda") = "libcuda.so.1")
+      .def_property_readonly("signature", &KernelLauncher::getSignature)
+      .def("launch", [](const KernelLauncher &self, py::args args) {
+        if (!self.launch(args.ptr()))
+          throw py::error_already_set();
+      });
+
+  py::class_<LaunchGraph>(launcher, "LaunchGraph")
+      .def(py::init<std::string>(), py::arg("libcuda") = "libcuda.so.1")
+      .def("begin_capture",
+           [](LaunchGraph &self) {
+             if (!self.beginCapture())
+               throw py::error_already_set();
+           })
+      .def("end_capture", &LaunchGraph::endCapture)
+      .def("update",
+           [](LaunchGraph &self, size_t index, py::args args) {
+             if (!self.update(index, args.ptr()))
+               throw py::error_already_set();
+           })
+      .def("replay",
+           [](LaunchGraph &self, uint64_t stream) {
+             if (!self.replay(stream))
+               throw py::error_already_set();
+           })
+      .def("__len__", &LaunchGraph::size);
 }
@@ -115,13 +115,14 @@ public:
     Duration,
     DeviceId,
     DeviceType,
+    StreamId,
     Count,
   };
 
   KernelMetric() : Metric(MetricKind::Kernel, kernelMetricKind::Count) {}
 
   KernelMetric(uint64_t startTime, uint64_t endTime, uint64_t invocations,
-               uint64_t deviceId, uint64_t deviceType)
+               uint64_t deviceId, uint64_t deviceType, uint64_t streamId = 0)
       : KernelMetric() {
     this->values[StartTime] = startTime;
     this->values[EndTime] = endTime;
@@ -129,6 +130,7 @@ public:
     this->values[Duration] = endTime - startTime;
     this->values[DeviceId] = deviceId;
     this->values[DeviceType] = deviceType;
+    this->values[StreamId] = streamId;
   }
 
   virtual const std::string getName() const { return "KernelMetric"; }
@@ -141,10 +143,11 @@ public:
 
 private:
   const static inline bool AGGREGABLE[kernelMetricKind::Count] = {
-      false, false, true, true, false, false};
+      false, false, true, true, false, false, false};
   const static inline std::string VALUE_NAMES[kernelMetricKind::Count] = {
       "StartTime (ns)", "EndTime (ns)", "Count",
       "Time (ns)",      "DeviceId",     "DeviceType",
+      "StreamId",
   };
 };
 
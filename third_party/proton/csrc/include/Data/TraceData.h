@@ -1,15 +1,29 @@
 #ifndef PROTON_DATA_TRACE_DATA_H_
 #define PROTON_DATA_TRACE_DATA_H_
 
+#include "Context/Context.h"
 #include "Data.h"
 
 namespace proton {
 
+/// Records every kernel launch as an individual timeline event instead of
+/// aggregating metrics per calling context.
+///
+/// Each writer thread appends to its own preallocated event buffer, so the
+/// recording paths (addScope/addMetric/addMetrics/startOp) never take the
+/// shared `Data::mutex` except the first time a thread records an event.
+/// Scope ids are resolved to their calling contexts only when the trace is
+/// dumped.
 class TraceData : public Data {
 public:
-  using Data::Data;
-  virtual ~TraceData() = default;
+  TraceData(const std::string &path, ContextSource *contextSource);
+  virtual ~TraceData();
 
+  TraceData(const std::string &path) : TraceData(path, nullptr) {}
+
+  /// If `name` is empty, record the current calling context of `scopeId` and
+  /// return `scopeId`. Otherwise, create a new scope named `name` under
+  /// `scopeId` (e.g., a kernel triggered by a non-Triton op) and return its id.
   size_t addScope(size_t scopeId, const std::string &name) override;
 
   void addMetric(size_t scopeId, std::shared_ptr<Metric> metric) override;
@@ -19,12 +33,23 @@ public:
                   bool aggregable) override;
 
 protected:
+  // OpInterface
   void startOp(const Scope &scope) override final;
 
   void stopOp(const Scope &scope) override final;
 
 private:
+  class Trace;
+
+  Trace &getThreadTrace();
+  std::vector<Context> getContexts();
+  void dumpChromeTrace(std::ostream &os) const;
   void doDump(std::ostream &os, OutputFormat outputFormat) const override;
+
+  // Unique id of this object, used to key the thread local buffer lookup.
+  const size_t id;
+  // One trace per writer thread, owned by this object.
+  std::vector<std::unique_ptr<Trace>> traces;
 };
 
 } // namespace proton
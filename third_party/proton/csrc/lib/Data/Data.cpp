@@ -27,6 +27,9 @@ OutputFormat parseOutputFormat(const std::string &outputFormat) {
   if (toLower(outputFormat) == "hatchet") {
     return OutputFormat::Hatchet;
   }
+  if (toLower(outputFormat) == "chrome_trace") {
+    return OutputFormat::ChromeTrace;
+  }
   throw std::runtime_error("Unknown output format: " + outputFormat);
 }
 
@@ -34,6 +37,9 @@ const std::string outputFormatToString(OutputFormat outputFormat) {
   if (outputFormat == OutputFormat::Hatchet) {
     return "hatchet";
   }
+  if (outputFormat == OutputFormat::ChromeTrace) {
+    return "chrome_trace";
+  }
   throw std::runtime_error("Unknown output format: " +
                            std::to_string(static_cast<int>(outputFormat)));
 }
@@ -1,30 +1,325 @@
 #include "Data/TraceData.h"
-#include "Utility/Errors.h"
+#include "Context/Context.h"
+#include "Data/Metric.h"
+#include "Driver/Device.h"
+#include "nlohmann/json.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <set>
 #include <stdexcept>
+#include <unordered_map>
+#include <variant>
+
+using json = nlohmann::json;
 
 namespace proton {
 
-void TraceData::startOp(const Scope &scope) { throw NotImplemented(); }
+namespace {
+std::atomic<size_t> traceDataIdCounter{0};
+} // namespace
+
+/// An append-only event log written by a single thread.
+///
+/// Events are stored in fixed-size blocks that are allocated up front, so
+/// appending never moves a recorded event and only takes a lock when the
+/// current block is full. Readers may walk the log concurrently with the
+/// writer; they see a prefix of the recorded events.
+class TraceData::Trace {
+public:
+  /// Binds a scope id to its calling contexts.
+  /// Nested scopes only store their own context and refer to their parent.
+  struct ScopeEvent {
+    size_t scopeId = Scope::DummyScopeId;
+    size_t parentScopeId = Scope::DummyScopeId;
+    std::vector<Context> contexts;
+  };
+
+  struct KernelEvent {
+    size_t scopeId = Scope::DummyScopeId;
+    uint64_t startTime = 0;
+    uint64_t endTime = 0;
+    uint64_t deviceId = 0;
+    uint64_t deviceType = 0;
+    uint64_t streamId = 0;
+  };
+
+  /// User provided metrics. `contexts` is only used if `scopeId` has never
+  /// been recorded.
+  struct MetricEvent {
+    size_t scopeId = Scope::DummyScopeId;
+    std::vector<Context> contexts;
+    std::map<std::string, MetricValueType> metrics;
+    bool aggregable = true;
+  };
+
+  using Event = std::variant<ScopeEvent, KernelEvent, MetricEvent>;
+
+  inline static const size_t BlockSize = 1024;
+
+  Trace() {
+    blocks.push_back(std::make_unique<Block>());
+    tail = blocks.back().get();
+  }
+
+  /// [MT] Must only be called by the owning thread.
+  void append(Event &&event) {
+    auto size = tailSize.load(std::memory_order_relaxed);
+    if (size == BlockSize) {
+      std::lock_guard<std::mutex> lock(blocksMutex);
+      blocks.push_back(std::make_unique<Block>());
+      tail = blocks.back().get();
+      size = 0;
+      tailSize.store(size, std::memory_order_relaxed);
+    }
+    (*tail)[size] = std::move(event);
+    tailSize.store(size + 1, std::memory_order_release);
+  }
 
-void TraceData::stopOp(const Scope &scope) { throw NotImplemented(); }
+  /// [MT] Thread-safe.
+  template <typename FnT> void walk(FnT &&fn) const {
+    std::vector<const Block *> snapshot;
+    size_t size = 0;
+    {
+      std::lock_guard<std::mutex> lock(blocksMutex);
+      for (auto &block : blocks)
+        snapshot.push_back(block.get());
+      size = tailSize.load(std::memory_order_acquire);
+    }
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+      auto numEvents = (i + 1 == snapshot.size()) ? size : BlockSize;
+      for (size_t j = 0; j < numEvents; ++j)
+        fn((*snapshot[i])[j]);
+    }
+  }
+
+private:
+  using Block = std::array<Event, BlockSize>;
+
+  mutable std::mutex blocksMutex;
+  std::vector<std::unique_ptr<Block>> blocks;
+  Block *tail{};
+  std::atomic<size_t> tailSize{0};
+};
+
+TraceData::Trace &TraceData::getThreadTrace() {
+  // TraceData id -> trace of the current thread.
+  // Ids are never reused, so entries of destroyed objects are never looked up.
+  static thread_local std::unordered_map<size_t, Trace *> threadTraces;
+  auto it = threadTraces.find(id);
+  if (it != threadTraces.end())
+    return *it->second;
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  auto *trace = traces.emplace_back(std::make_unique<Trace>()).get();
+  threadTraces[id] = trace;
+  return *trace;
+}
+
+std::vector<Context> TraceData::getContexts() {
+  if (contextSource == nullptr)
+    return {};
+  return contextSource->getContexts();
+}
+
+void TraceData::startOp(const Scope &scope) {
+  auto contexts = getContexts();
+  contexts.push_back(Context(scope.name));
+  getThreadTrace().append(Trace::ScopeEvent{
+      scope.scopeId, Scope::DummyScopeId, std::move(contexts)});
+}
+
+void TraceData::stopOp(const Scope &scope) {}
 
 size_t TraceData::addScope(size_t scopeId, const std::string &name) {
-  throw NotImplemented();
+  auto &trace = getThreadTrace();
+  if (name.empty()) {
+    // Record the calling context of the scope
+    trace.append(
+        Trace::ScopeEvent{scopeId, Scope::DummyScopeId, getContexts()});
+    return scopeId;
+  }
+  // Add a new scope under it
+  auto newScopeId = Scope::getNewScopeId();
+  trace.append(Trace::ScopeEvent{newScopeId, scopeId, {Context(name)}});
+  return newScopeId;
 }
 
 void TraceData::addMetric(size_t scopeId, std::shared_ptr<Metric> metric) {
-  throw NotImplemented();
+  // Invalid activities are converted to null metrics
+  if (!metric || metric->getKind() != MetricKind::Kernel)
+    return;
+  Trace::KernelEvent event;
+  event.scopeId = scopeId;
+  event.startTime =
+      std::get<uint64_t>(metric->getValue(KernelMetric::StartTime));
+  event.endTime = std::get<uint64_t>(metric->getValue(KernelMetric::EndTime));
+  event.deviceId =
+      std::get<uint64_t>(metric->getValue(KernelMetric::DeviceId));
+  event.deviceType =
+      std::get<uint64_t>(metric->getValue(KernelMetric::DeviceType));
+  event.streamId =
+      std::get<uint64_t>(metric->getValue(KernelMetric::StreamId));
+  getThreadTrace().append(std::move(event));
 }
 
 void TraceData::addMetrics(
     size_t scopeId, const std::map<std::string, MetricValueType> &metrics,
     bool aggregable) {
-  throw NotImplemented();
+  getThreadTrace().append(
+      Trace::MetricEvent{scopeId, getContexts(), metrics, aggregable});
+}
+
+void TraceData::dumpChromeTrace(std::ostream &os) const {
+  using FlexibleMetrics = std::map<std::string, FlexibleMetric>;
+  std::unordered_map<size_t, const Trace::ScopeEvent *> scopes;
+  std::vector<const Trace::KernelEvent *> kernels;
+  std::vector<const Trace::MetricEvent *> metricEvents;
+  for (auto &trace : traces) {
+    trace->walk([&](const Trace::Event &event) {
+      if (auto *scope = std::get_if<Trace::ScopeEvent>(&event))
+        scopes[scope->scopeId] = scope;
+      else if (auto *kernel = std::get_if<Trace::KernelEvent>(&event))
+        kernels.push_back(kernel);
+      else if (auto *metric = std::get_if<Trace::MetricEvent>(&event))
+        metricEvents.push_back(metric);
+    });
+  }
+
+  auto getCallStack = [&](size_t scopeId) {
+    std::vector<std::string> callStack;
+    for (auto it = scopes.find(scopeId); it != scopes.end();
+         it = scopes.find(it->second->parentScopeId)) {
+      auto &contexts = it->second->contexts;
+      std::vector<std::string> names;
+      for (auto &context : contexts)
+        names.push_back(context.name);
+      callStack.insert(callStack.begin(), names.begin(), names.end());
+    }
+    return callStack;
+  };
+
+  auto getCallPath = [](const std::vector<std::string> &callStack) {
+    std::string path;
+    for (auto &name : callStack)
+      path += (path.empty() ? "" : "/") + name;
+    return path;
+  };
+
+  auto addFlexibleMetrics = [](FlexibleMetrics &flexibleMetrics,
+                               const Trace::MetricEvent &event) {
+    for (auto [metricName, metricValue] : event.metrics) {
+      auto it = flexibleMetrics.find(metricName);
+      if (it == flexibleMetrics.end())
+        flexibleMetrics.emplace(
+            metricName,
+            FlexibleMetric(metricName, metricValue, event.aggregable));
+      else
+        it->second.updateValue(metricValue);
+    }
+  };
+
+  auto toJson = [](const FlexibleMetrics &flexibleMetrics) {
+    json metrics = json::object();
+    for (auto &[metricName, flexibleMetric] : flexibleMetrics) {
+      std::visit([&](auto &&value) { metrics[metricName] = value; },
+                 flexibleMetric.getValues()[0]);
+    }
+    return metrics;
+  };
+
+  // Metrics attached to recorded scopes are emitted along with their kernels,
+  // others are attributed to the calling context they were added from.
+  std::unordered_map<size_t, FlexibleMetrics> scopeMetrics;
+  std::map<std::string, FlexibleMetrics> contextMetrics;
+  for (auto *event : metricEvents) {
+    if (scopes.count(event->scopeId)) {
+      addFlexibleMetrics(scopeMetrics[event->scopeId], *event);
+    } else {
+      std::vector<std::string> callStack;
+      for (auto &context : event->contexts)
+        callStack.push_back(context.name);
+      addFlexibleMetrics(contextMetrics[getCallPath(callStack)], *event);
+    }
+  }
+
+  std::stable_sort(kernels.begin(), kernels.end(),
+                   [](const Trace::KernelEvent *lhs,
+                      const Trace::KernelEvent *rhs) {
+                     return lhs->startTime < rhs->startTime;
+                   });
+  // Chrome trace timestamps are in microseconds and stored as doubles, so we
+  // make them relative to the first kernel to keep nanosecond precision.
+  auto baseTime = kernels.empty() ? 0 : kernels.front()->startTime;
+
+  json traceEvents = json::array();
+  // <device type, device id> -> pid
+  std::map<std::pair<uint64_t, uint64_t>, size_t> devicePids;
+  // <pid, stream id>
+  std::set<std::pair<size_t, uint64_t>> streams;
+  for (auto *kernel : kernels) {
+    auto callStack = getCallStack(kernel->scopeId);
+    auto pid = devicePids
+                   .try_emplace({kernel->deviceType, kernel->deviceId},
+                                devicePids.size())
+                   .first->second;
+    streams.insert({pid, kernel->streamId});
+    json event = {
+        {"name", callStack.empty() ? "unknown" : callStack.back()},
+        {"cat", "kernel"},
+        {"ph", "X"},
+        {"ts", static_cast<double>(kernel->startTime - baseTime) / 1000.0},
+        {"dur",
+         static_cast<double>(kernel->endTime - kernel->startTime) / 1000.0},
+        {"pid", pid},
+        {"tid", kernel->streamId},
+    };
+    event["args"] = {{"call_stack", getCallPath(callStack)},
+                     {"scope_id", kernel->scopeId}};
+    if (auto it = scopeMetrics.find(kernel->scopeId); it != scopeMetrics.end())
+      event["args"]["metrics"] = toJson(it->second);
+    traceEvents.push_back(std::move(event));
+  }
+  // Name the timeline rows after devices and streams
+  for (auto [device, pid] : devicePids) {
+    auto [deviceType, deviceId] = device;
+    auto deviceName = getDeviceTypeString(static_cast<DeviceType>(deviceType)) +
+                      " " + std::to_string(deviceId);
+    traceEvents.push_back({{"name", "process_name"},
+                           {"ph", "M"},
+                           {"pid", pid},
+                           {"args", {{"name", deviceName}}}});
+  }
+  for (auto [pid, streamId] : streams) {
+    traceEvents.push_back(
+        {{"name", "thread_name"},
+         {"ph", "M"},
+         {"pid", pid},
+         {"tid", streamId},
+         {"args", {{"name", "Stream " + std::to_string(streamId)}}}});
+  }
+
+  json output = {{"traceEvents", std::move(traceEvents)},
+                 {"displayTimeUnit", "ns"},
+                 {"otherData", {{"base_time_ns", baseTime}}}};
+  for (auto &[callPath, flexibleMetrics] : contextMetrics)
+    output["otherData"]["metrics"][callPath] = toJson(flexibleMetrics);
+  os << output.dump() << std::endl;
 }
 
 void TraceData::doDump(std::ostream &os, OutputFormat outputFormat) const {
-  throw NotImplemented();
+  if (outputFormat == OutputFormat::ChromeTrace) {
+    dumpChromeTrace(os);
+  } else {
+    throw std::runtime_error("OutputFormat not supported by TraceData: " +
+                             outputFormatToString(outputFormat));
+  }
 }
 
+TraceData::TraceData(const std::string &path, ContextSource *contextSource)
+    : Data(path, contextSource), id(traceDataIdCounter++) {}
+
+TraceData::~TraceData() {}
+
 } // namespace proton
@@ -34,7 +34,8 @@ std::shared_ptr<Metric> convertActivityToMetric(CUpti_Activity *activity) {
           static_cast<uint64_t>(kernel->start),
           static_cast<uint64_t>(kernel->end), 1,
           static_cast<uint64_t>(kernel->deviceId),
-          static_cast<uint64_t>(DeviceType::CUDA));
+          static_cast<uint64_t>(DeviceType::CUDA),
+          static_cast<uint64_t>(kernel->streamId));
     } // else: not a valid kernel activity
     break;
   }
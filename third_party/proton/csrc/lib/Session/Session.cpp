@@ -1,6 +1,7 @@
 #include "Session/Session.h"
 #include "Context/Python.h"
 #include "Context/Shadow.h"
+#include "Data/TraceData.h"
 #include "Data/TreeData.h"
 #include "Profiler/CuptiProfiler.h"
 #include "Profiler/RoctracerProfiler.h"
@@ -25,6 +26,9 @@ std::unique_ptr<Data> makeData(const std::string &dataName,
   if (toLower(dataName) == "tree") {
     return std::make_unique<TreeData>(path, contextSource);
   }
+  if (toLower(dataName) == "trace") {
+    return std::make_unique<TraceData>(path, contextSource);
+  }
   throw std::runtime_error("Unknown data: " + dataName);
 }
 
@@ -48,7 +48,9 @@ def start(
                                  Available options are ["shadow", "python"].
                                  Defaults to "shadow".
         data (str, optional): The data structure to use for profiling.
-                              Available options are ["tree"].
+                              Available options are ["tree", "trace"].
+                              "tree" aggregates metrics by calling context, while "trace" records a timeline
+                              of every kernel launch.
                               Defaults to "tree".
         hook (str, optional): The hook to use for profiling.
                               Available options are [None, "triton"].
@@ -112,7 +114,8 @@ def finalize(session: Optional[int] = None, output_format: str = "hatchet") -> N
     Args:
         session (int, optional): The session ID to finalize. If None, all sessions are finalized. Defaults to None.
         output_format (str, optional): The output format for the profiling results.
-                                       Aavailable options are ["hatchet"].
+                                       Aavailable options are ["hatchet", "chrome_trace"].
+                                       "tree" data is dumped as "hatchet" and "trace" data as "chrome_trace".
 
     Returns:
         None
@@ -44,3 +44,14 @@ def test_add_metrics():
         libproton.exit_scope(id1, "one")
         libproton.finalize_all("hatchet")
         assert pathlib.Path(f.name).exists()
+
+
+def test_trace_session():
+    with tempfile.NamedTemporaryFile(delete=True, suffix=".chrome_trace") as f:
+        session_id = libproton.start(f.name.split(".")[0], "shadow", "trace", _select_backend())
+        id1 = libproton.record_scope()
+        libproton.enter_op(id1, "one")
+        libproton.add_metrics(id1, {"a": 1.0})
+        libproton.exit_op(id1, "one")
+        libproton.finalize(session_id, "chrome_trace")
+        assert pathlib.Path(f.name).exists()
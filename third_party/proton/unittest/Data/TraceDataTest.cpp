@@ -0,0 +1,216 @@
+#include "Context/Shadow.h"
+#include "Data/Metric.h"
+#include "Data/TraceData.h"
+#include "Driver/Device.h"
+#include "nlohmann/json.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace proton {
+namespace {
+
+/// Feeds a data object the same way GPU profilers do, without a GPU:
+/// application threads record the scope of each launch, and the kernel
+/// activities are reported later from a separate (activity) thread.
+class MockProfiler {
+public:
+  explicit MockProfiler(Data &data) : data(data) {}
+
+  /// Launch a kernel from a Triton op.
+  void launchOp(const std::string &name, uint64_t startTime, uint64_t endTime,
+                uint64_t streamId = 0) {
+    auto scopeId = Scope::getNewScopeId();
+    data.enterOp(Scope(scopeId, name));
+    data.exitOp(Scope(scopeId, name));
+    activities.push_back({scopeId, {}, startTime, endTime, streamId});
+  }
+
+  /// Launch a kernel from a non-Triton op (e.g., a torch kernel).
+  void launchApi(const std::string &kernelName, uint64_t startTime,
+                 uint64_t endTime, uint64_t streamId = 0) {
+    auto scopeId = Scope::getNewScopeId();
+    data.addScope(scopeId);
+    activities.push_back({scopeId, kernelName, startTime, endTime, streamId});
+  }
+
+  /// Report all pending activities from the activity thread.
+  void flush() {
+    std::thread activityThread([&]() {
+      for (auto &activity : activities) {
+        auto scopeId = activity.scopeId;
+        if (!activity.kernelName.empty())
+          scopeId = data.addScope(scopeId, activity.kernelName);
+        data.addMetric(scopeId, std::make_shared<KernelMetric>(
+                                    activity.startTime, activity.endTime, 1,
+                                    /*deviceId=*/0,
+                                    static_cast<uint64_t>(DeviceType::CUDA),
+                                    activity.streamId));
+      }
+    });
+    activityThread.join();
+    activities.clear();
+  }
+
+private:
+  struct Activity {
+    size_t scopeId;
+    std::string kernelName;
+    uint64_t startTime;
+    uint64_t endTime;
+    uint64_t streamId;
+  };
+
+  Data &data;
+  std::vector<Activity> activities;
+};
+
+class TraceDataTest : public ::testing::Test {
+protected:
+  TraceDataTest()
+      : path(::testing::TempDir() + "/proton_trace_" +
+             ::testing::UnitTest::GetInstance()->current_test_info()->name()),
+        data(path, &contextSource), profiler(data) {}
+
+  json dump() {
+    data.dump(OutputFormat::ChromeTrace);
+    std::ifstream in(path + ".chrome_trace");
+    return json::parse(in);
+  }
+
+  static std::vector<json> getKernels(const json &trace) {
+    std::vector<json> kernels;
+    for (auto &event : trace["traceEvents"])
+      if (event["ph"] == "X")
+        kernels.push_back(event);
+    return kernels;
+  }
+
+  std::string path;
+  ShadowContextSource contextSource;
+  TraceData data;
+  MockProfiler profiler;
+};
+
+TEST_F(TraceDataTest, OpKernels) {
+  auto outer = Scope("outer");
+  contextSource.enterScope(outer);
+  profiler.launchOp("kernel_a", 1000, 3000, /*streamId=*/7);
+  profiler.launchOp("kernel_b", 5000, 5500, /*streamId=*/7);
+  contextSource.exitScope(outer);
+  profiler.flush();
+
+  auto kernels = getKernels(dump());
+  ASSERT_EQ(kernels.size(), 2);
+  EXPECT_EQ(kernels[0]["name"], "kernel_a");
+  EXPECT_EQ(kernels[0]["args"]["call_stack"], "outer/kernel_a");
+  EXPECT_DOUBLE_EQ(kernels[0]["ts"].get<double>(), 0.0);
+  EXPECT_DOUBLE_EQ(kernels[0]["dur"].get<double>(), 2.0);
+  EXPECT_EQ(kernels[0]["tid"], 7);
+  EXPECT_EQ(kernels[1]["name"], "kernel_b");
+  EXPECT_DOUBLE_EQ(kernels[1]["ts"].get<double>(), 4.0);
+  EXPECT_DOUBLE_EQ(kernels[1]["dur"].get<double>(), 0.5);
+}
+
+TEST_F(TraceDataTest, ApiKernels) {
+  auto outer = Scope("outer");
+  contextSource.enterScope(outer);
+  profiler.launchApi("torch_kernel", 2000, 4000);
+  contextSource.exitScope(outer);
+  profiler.flush();
+
+  auto kernels = getKernels(dump());
+  ASSERT_EQ(kernels.size(), 1);
+  EXPECT_EQ(kernels[0]["name"], "torch_kernel");
+  EXPECT_EQ(kernels[0]["args"]["call_stack"], "outer/torch_kernel");
+}
+
+TEST_F(TraceDataTest, Metrics) {
+  auto scopeId = Scope::getNewScopeId();
+  data.enterOp(Scope(scopeId, "kernel"));
+  data.addMetrics(scopeId, {{"flops", 10.0}}, /*aggregable=*/true);
+  data.addMetrics(scopeId, {{"flops", 5.0}}, /*aggregable=*/true);
+  data.exitOp(Scope(scopeId, "kernel"));
+  data.addMetric(scopeId,
+                 std::make_shared<KernelMetric>(
+                     0, 100, 1, 0, static_cast<uint64_t>(DeviceType::CUDA)));
+  // Metrics without a recorded scope are attributed to the calling context
+  auto outer = Scope("outer");
+  contextSource.enterScope(outer);
+  data.addMetrics(Scope::getNewScopeId(), {{"bytes", uint64_t(64)}},
+                  /*aggregable=*/true);
+  contextSource.exitScope(outer);
+
+  auto trace = dump();
+  auto kernels = getKernels(trace);
+  ASSERT_EQ(kernels.size(), 1);
+  EXPECT_DOUBLE_EQ(kernels[0]["args"]["metrics"]["flops"].get<double>(), 15.0);
+  EXPECT_EQ(trace["otherData"]["metrics"]["outer"]["bytes"], 64);
+}
+
+TEST_F(TraceDataTest, DeviceAndStreamNames) {
+  profiler.launchOp("kernel", 0, 10, /*streamId=*/3);
+  profiler.flush();
+
+  auto trace = dump();
+  bool hasProcessName = false, hasThreadName = false;
+  for (auto &event : trace["traceEvents"]) {
+    if (event["ph"] != "M")
+      continue;
+    if (event["name"] == "process_name") {
+      EXPECT_EQ(event["args"]["name"], "CUDA 0");
+      hasProcessName = true;
+    } else if (event["name"] == "thread_name") {
+      EXPECT_EQ(event["args"]["name"], "Stream 3");
+      hasThreadName = true;
+    }
+  }
+  EXPECT_TRUE(hasProcessName);
+  EXPECT_TRUE(hasThreadName);
+}
+
+TEST_F(TraceDataTest, ManyThreads) {
+  // Enough events per thread to span several buffer blocks
+  constexpr int numThreads = 4;
+  constexpr int numKernels = 3000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < numKernels; ++j) {
+        auto scopeId = Scope::getNewScopeId();
+        data.enterOp(Scope(scopeId, "kernel"));
+        data.exitOp(Scope(scopeId, "kernel"));
+        data.addMetric(scopeId, std::make_shared<KernelMetric>(
+                                    j, j + 1, 1, 0,
+                                    static_cast<uint64_t>(DeviceType::CUDA),
+                                    /*streamId=*/i));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  auto kernels = getKernels(dump());
+  EXPECT_EQ(kernels.size(), numThreads * numKernels);
+  for (auto &kernel : kernels)
+    EXPECT_EQ(kernel["args"]["call_stack"], "kernel");
+}
+
+TEST_F(TraceDataTest, InvalidMetric) {
+  auto scopeId = Scope::getNewScopeId();
+  data.addScope(scopeId, /*name=*/"");
+  data.addMetric(scopeId, nullptr);
+  EXPECT_TRUE(getKernels(dump()).empty());
+}
+
+TEST_F(TraceDataTest, UnsupportedFormat) {
+  EXPECT_THROW(data.dump(OutputFormat::Hatchet), std::runtime_error);
+}
+
+} // namespace
+} // namespace proton
@@ -0,0 +1,71 @@
+#include "triton/Analysis/BankConflicts.h"
+
+#include "llvm/Support/Signals.h"
+#include <gtest/gtest.h>
+
+namespace mlir::triton {
+namespace {
+
+// One instruction where lane i accesses byte offset i * stride.
+SmallVector<SmallVector<int64_t>> strided(int64_t stride) {
+  SmallVector<int64_t> offsets;
+  for (int lane = 0; lane < 32; lane++)
+    offsets.push_back(lane * stride);
+  return {offsets};
+}
+
+TEST(BankConflictsTest, ConsecutiveWords) {
+  BankConflicts conflicts = getBankConflicts(strided(4), /*accessBytes=*/4);
+  EXPECT_TRUE(conflicts.isConflictFree());
+  EXPECT_EQ(conflicts.wavefronts, 1);
+  EXPECT_EQ(conflicts.ways, 1);
+}
+
+TEST(BankConflictsTest, Broadcast) {
+  BankConflicts conflicts = getBankConflicts(strided(0), /*accessBytes=*/4);
+  EXPECT_TRUE(conflicts.isConflictFree());
+  EXPECT_EQ(conflicts.wavefronts, 1);
+}
+
+TEST(BankConflictsTest, Strided) {
+  BankConflicts twoWay = getBankConflicts(strided(8), /*accessBytes=*/4);
+  EXPECT_EQ(twoWay.wavefronts, 2);
+  EXPECT_EQ(twoWay.minWavefronts, 1);
+  EXPECT_EQ(twoWay.ways, 2);
+
+  BankConflicts column = getBankConflicts(strided(128), /*accessBytes=*/4);
+  EXPECT_EQ(column.wavefronts, 32);
+  EXPECT_EQ(column.ways, 32);
+}
+
+TEST(BankConflictsTest, Vectors) {
+  // A warp of 16-byte accesses takes 4 wavefronts of 8 threads.
+  BankConflicts conflicts = getBankConflicts(strided(16), /*accessBytes=*/16);
+  EXPECT_TRUE(conflicts.isConflictFree());
+  EXPECT_EQ(conflicts.wavefronts, 4);
+
+  // 32-byte accesses are split in two 16-byte accesses, where threads 4 apart
+  // hit the same banks.
+  BankConflicts split = getBankConflicts(strided(32), /*accessBytes=*/32);
+  EXPECT_EQ(split.wavefronts, 16);
+  EXPECT_EQ(split.minWavefronts, 8);
+  EXPECT_EQ(split.ways, 2);
+}
+
+TEST(BankConflictsTest, Instructions) {
+  auto offsets = strided(4);
+  offsets.append(strided(128));
+  BankConflicts conflicts = getBankConflicts(offsets, /*accessBytes=*/4);
+  EXPECT_EQ(conflicts.wavefronts, 33);
+  EXPECT_EQ(conflicts.minWavefronts, 2);
+  EXPECT_EQ(conflicts.ways, 32);
+}
+
+} // namespace
+} // namespace mlir::triton
+
+int main(int argc, char *argv[]) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
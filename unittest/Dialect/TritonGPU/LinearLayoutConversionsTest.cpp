@@ -1048,6 +1048,32 @@ TEST_F(LinearLayoutConversionsTest, ChooseShmemLayout_Multidim) {
                    {S("dim3"), S("dim2"), S("dim1"), S("dim0")}));
 }
 
+TEST_F(LinearLayoutConversionsTest, ChooseShmemLayout_Swizzled) {
+  // Rows 1 and 2 of the 4x8 buffer are swizzled by 2 and 4 columns.
+  EXPECT_EQ(chooseShemLayoutForRegToRegConversion(
+                &ctx, /*tensorShape=*/{8, 8}, /*repShape=*/{4, 8},
+                /*order=*/{1, 0}, /*swizzleVec=*/2, /*perPhase=*/1,
+                /*maxPhase=*/4),
+            LinearLayout(
+                {{S("offset"), {{1, 0}, {2, 0}, {4, 0}, {2, 1}, {4, 2}}},
+                 {S("iteration"), {{0, 4}}},
+                 {S("block"), {}}},
+                {S("dim1"), S("dim0")}));
+}
+
+TEST_F(LinearLayoutConversionsTest, SwizzleLayout) {
+  LinearLayout swizzle = getSwizzleLayout(&ctx, /*shape=*/{16, 8},
+                                          /*order=*/{1, 0}, /*vec=*/2,
+                                          /*perPhase=*/2, /*maxPhase=*/4);
+  EXPECT_EQ(swizzle, LinearLayout({{S("offset"),
+                                    {{1}, {2}, {4}, {8}, {16 ^ 2}, {32 ^ 4},
+                                     {64}}}},
+                                  {S("offset")}));
+  // The swizzle is its own inverse.
+  EXPECT_EQ(swizzle.compose(swizzle),
+            LinearLayout::identity1D(128, S("offset"), S("offset")));
+}
+
 } // anonymous namespace
 } // namespace mlir::triton::gpu
 
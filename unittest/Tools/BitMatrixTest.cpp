@@ -0,0 +1,104 @@
+#include "triton/Tools/BitMatrix.h"
+
+#include "llvm/Support/Signals.h"
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace mlir::triton {
+namespace {
+
+BitMatrix fromColumns(int numRows, std::initializer_list<uint64_t> columns) {
+  BitMatrix m(numRows, columns.size());
+  int c = 0;
+  for (uint64_t column : columns)
+    m.setColumn(c++, column);
+  return m;
+}
+
+BitMatrix random(int numRows, int numCols, std::mt19937_64 &rng) {
+  BitMatrix m(numRows, numCols);
+  for (int c = 0; c < numCols; c++)
+    m.setColumn(c, numRows == 64 ? rng() : rng() & ((1ULL << numRows) - 1));
+  return m;
+}
+
+TEST(BitMatrixTest, Apply) {
+  BitMatrix m = fromColumns(3, {0b001, 0b110, 0b011});
+  EXPECT_EQ(m.apply(0b000), 0b000);
+  EXPECT_EQ(m.apply(0b010), 0b110);
+  EXPECT_EQ(m.apply(0b101), 0b010);
+  EXPECT_EQ(m.apply(0b111), 0b100);
+  EXPECT_TRUE(m.get(1, 1));
+  EXPECT_FALSE(m.get(0, 1));
+}
+
+TEST(BitMatrixTest, Multiply) {
+  std::mt19937_64 rng(0);
+  BitMatrix lhs = random(32, 20, rng);
+  BitMatrix rhs = random(20, 12, rng);
+  BitMatrix product = lhs * rhs;
+  ASSERT_EQ(product.getNumRows(), 32);
+  ASSERT_EQ(product.getNumCols(), 12);
+  for (uint64_t x = 0; x < (1 << 12); x += 7)
+    EXPECT_EQ(product.apply(x), lhs.apply(rhs.apply(x)));
+  EXPECT_EQ(BitMatrix::identity(32) * lhs, lhs);
+  EXPECT_EQ(lhs * BitMatrix::identity(20), lhs);
+}
+
+TEST(BitMatrixTest, Transpose) {
+  std::mt19937_64 rng(0);
+  BitMatrix m = random(64, 17, rng);
+  BitMatrix t = m.transpose();
+  ASSERT_EQ(t.getNumRows(), 17);
+  ASSERT_EQ(t.getNumCols(), 64);
+  for (int r = 0; r < 64; r++)
+    for (int c = 0; c < 17; c++)
+      EXPECT_EQ(t.get(c, r), m.get(r, c));
+  EXPECT_EQ(t.transpose(), m);
+}
+
+TEST(BitMatrixTest, PivotColumns) {
+  // Column 2 is column 0 + column 1, column 3 is zero.
+  BitMatrix m = fromColumns(4, {0b0011, 0b0110, 0b0101, 0b0000, 0b1000});
+  EXPECT_EQ(m.getPivotColumns(), 0b10011);
+  EXPECT_EQ(m.rank(), 3);
+  EXPECT_EQ(m.transpose().rank(), 3);
+  EXPECT_EQ(BitMatrix(0, 0).rank(), 0);
+  EXPECT_EQ(BitMatrix::identity(64).getPivotColumns(), ~0ULL);
+}
+
+TEST(BitMatrixTest, Inverse) {
+  std::mt19937_64 rng(0);
+  int numInvertible = 0;
+  for (int size : {1, 5, 32, 64}) {
+    for (int i = 0; i < 20; i++) {
+      BitMatrix m = random(size, size, rng);
+      std::optional<BitMatrix> inverse = m.inverse();
+      ASSERT_EQ(inverse.has_value(), m.rank() == size);
+      if (!inverse)
+        continue;
+      numInvertible++;
+      EXPECT_EQ(m * *inverse, BitMatrix::identity(size));
+      EXPECT_EQ(*inverse * m, BitMatrix::identity(size));
+    }
+  }
+  // Random matrices are invertible with probability ~0.29.
+  EXPECT_GT(numInvertible, 0);
+}
+
+TEST(BitMatrixTest, Singular) {
+  EXPECT_EQ(fromColumns(2, {0b01, 0b01}).inverse(), std::nullopt);
+  EXPECT_EQ(fromColumns(2, {0b11, 0b00}).inverse(), std::nullopt);
+  EXPECT_EQ(fromColumns(2, {0b10, 0b01}).inverse(),
+            fromColumns(2, {0b10, 0b01}));
+}
+
+} // namespace
+} // namespace mlir::triton
+
+int main(int argc, char *argv[]) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,145 @@
+#include "triton/Tools/LinearLayoutCache.h"
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/Support/Signals.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mlir::triton {
+namespace {
+
+class LinearLayoutCacheTest : public ::testing::Test {
+public:
+  StringAttr S(StringRef str) { return StringAttr::get(&ctx, str); }
+
+  // A blocked-like layout of a size x size tensor, where each thread owns
+  // `regs` consecutive elements along `minor`.
+  LinearLayout blocked(int32_t size, int32_t regs, StringRef minor,
+                       StringRef major) {
+    int32_t lanesMinor = std::min(32, size / regs);
+    int32_t lanesMajor = 32 / lanesMinor;
+    int32_t warps = 4;
+    LinearLayout layout =
+        LinearLayout::identity1D(regs, S("register"), S(minor)) *
+        LinearLayout::identity1D(lanesMinor, S("lane"), S(minor)) *
+        LinearLayout::identity1D(size / regs / lanesMinor, S("register"),
+                                 S(minor)) *
+        LinearLayout::identity1D(lanesMajor, S("lane"), S(major)) *
+        LinearLayout::identity1D(warps, S("warp"), S(major)) *
+        LinearLayout::identity1D(size / lanesMajor / warps, S("register"),
+                                 S(major));
+    return layout.transposeOuts({S("dim0"), S("dim1")});
+  }
+
+protected:
+  MLIRContext ctx;
+  LinearLayoutCache cache;
+};
+
+TEST_F(LinearLayoutCacheTest, SameResults) {
+  LinearLayout src = blocked(64, 4, "dim1", "dim0");
+  LinearLayout dst = blocked(64, 2, "dim0", "dim1");
+  LinearLayout conversion = src.invertAndCompose(dst);
+  EXPECT_EQ(cache.invertAndCompose(src, dst), conversion);
+  EXPECT_EQ(cache.compose(conversion, dst), conversion.compose(dst));
+  LinearLayout zeros = LinearLayout::zeros1D(4, S("register"), S("dim0"));
+  EXPECT_EQ(cache.multiply(src, zeros), src * zeros);
+  LinearLayout product = src * zeros;
+  EXPECT_EQ(cache.divideRight(product, zeros), product.divideRight(zeros));
+  EXPECT_EQ(cache.getNumHits(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 4);
+  EXPECT_EQ(cache.size(), 4);
+}
+
+TEST_F(LinearLayoutCacheTest, StructuralKeys) {
+  // Layouts built independently share entries if they are equal
+  LinearLayout result =
+      cache.invertAndCompose(blocked(64, 4, "dim1", "dim0"),
+                             blocked(64, 2, "dim0", "dim1"));
+  EXPECT_EQ(cache.invertAndCompose(blocked(64, 4, "dim1", "dim0"),
+                                   blocked(64, 2, "dim0", "dim1")),
+            result);
+  EXPECT_EQ(cache.getNumHits(), 1);
+  // The operation and the order of the operands are part of the key
+  (void)cache.invertAndCompose(blocked(64, 2, "dim0", "dim1"),
+                               blocked(64, 4, "dim1", "dim0"));
+  (void)cache.compose(LinearLayout::identity1D(8, S("in"), S("out")),
+                      LinearLayout::identity1D(8, S("out"), S("out2")));
+  EXPECT_EQ(cache.getNumHits(), 1);
+  EXPECT_EQ(cache.size(), 3);
+}
+
+TEST_F(LinearLayoutCacheTest, DivideRightFailure) {
+  LinearLayout dividend = LinearLayout::identity1D(4, S("in"), S("out"));
+  LinearLayout divisor = LinearLayout::identity1D(8, S("in"), S("out"));
+  EXPECT_EQ(cache.divideRight(dividend, divisor), std::nullopt);
+  EXPECT_EQ(cache.divideRight(dividend, divisor), std::nullopt);
+  EXPECT_EQ(cache.getNumHits(), 1);
+}
+
+TEST_F(LinearLayoutCacheTest, Clear) {
+  LinearLayout layout = LinearLayout::identity1D(8, S("in"), S("out"));
+  (void)cache.multiply(layout, layout);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 0);
+}
+
+TEST_F(LinearLayoutCacheTest, Threads) {
+  LinearLayout src = blocked(64, 4, "dim1", "dim0");
+  LinearLayout dst = blocked(64, 2, "dim0", "dim1");
+  LinearLayout expected = src.invertAndCompose(dst);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 100; j++)
+        EXPECT_EQ(cache.invertAndCompose(src, dst), expected);
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.getNumHits() + cache.getNumMisses(), 800);
+}
+
+// Repeated conversions between the same pairs of layouts, as done when
+// lowering a module with many convert_layout ops, are computed once.
+TEST_F(LinearLayoutCacheTest, RepeatedConversions) {
+  std::vector<std::pair<LinearLayout, LinearLayout>> pairs;
+  for (int32_t size : {64, 128, 256}) {
+    pairs.push_back(
+        {blocked(size, 4, "dim1", "dim0"), blocked(size, 2, "dim0", "dim1")});
+    pairs.push_back(
+        {blocked(size, 8, "dim1", "dim0"), blocked(size, 1, "dim1", "dim0")});
+  }
+  for (int i = 0; i < 10; i++) {
+    for (auto &[src, dst] : pairs)
+      EXPECT_EQ(cache.invertAndCompose(src, dst), src.invertAndCompose(dst));
+  }
+  EXPECT_EQ(cache.getNumMisses(), pairs.size());
+  EXPECT_EQ(cache.getNumHits(), 9 * pairs.size());
+}
+
+TEST_F(LinearLayoutCacheTest, MaxSize) {
+  LinearLayoutCache small(/*maxSize=*/2);
+  LinearLayout dst = blocked(64, 1, "dim1", "dim0");
+  for (int32_t regs : {1, 2, 4, 8}) {
+    LinearLayout src = blocked(64, regs, "dim1", "dim0");
+    EXPECT_EQ(small.invertAndCompose(src, dst), src.invertAndCompose(dst));
+    EXPECT_LE(small.size(), 2u);
+  }
+  EXPECT_EQ(small.getNumMisses(), 4);
+}
+
+} // namespace
+} // namespace mlir::triton
+
+int main(int argc, char *argv[]) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}